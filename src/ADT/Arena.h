@@ -0,0 +1,103 @@
+#ifndef _DG_ADT_ARENA_H_
+#define _DG_ADT_ARENA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dg {
+namespace ADT {
+
+// Bump allocator - the objects are placed one after another
+// in big slabs of memory and they are all destroyed and released
+// at once with the arena (the objects cannot be freed one by one).
+// Only the objects with non-trivial destructor are remembered,
+// so that the destructors can be called.
+class Arena
+{
+    static const size_t SLAB_SIZE = 64 * 1024;
+
+    // the slabs of memory, the current one is the last one
+    std::vector<char *> slabs;
+    char *cur;
+    char *end;
+
+    struct Destructor {
+        void *object;
+        void (*destroy)(void *);
+
+        Destructor(void *o, void (*d)(void *)) : object(o), destroy(d) {}
+    };
+
+    std::vector<Destructor> destructors;
+
+    template <typename T>
+    static void destroyObject(void *o)
+    {
+        static_cast<T *>(o)->~T();
+    }
+
+    void *allocate(size_t size, size_t align)
+    {
+        size_t pad = (align - reinterpret_cast<size_t>(cur) % align) % align;
+        if (!cur || size + pad > static_cast<size_t>(end - cur)) {
+            // big objects get a slab of their own
+            size_t slab_size = size + align > SLAB_SIZE
+                                ? size + align : SLAB_SIZE;
+            char *slab = static_cast<char *>(::operator new(slab_size));
+            slabs.push_back(slab);
+            cur = slab;
+            end = slab + slab_size;
+            pad = (align - reinterpret_cast<size_t>(cur) % align) % align;
+        }
+
+        void *mem = cur + pad;
+        cur += pad + size;
+        return mem;
+    }
+
+public:
+    Arena() : cur(nullptr), end(nullptr) {}
+    ~Arena() { clear(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    template <typename T, typename... Args>
+    T *create(Args&&... args)
+    {
+        void *mem = allocate(sizeof(T), alignof(T));
+        T *obj = new (mem) T(std::forward<Args>(args)...);
+
+        if (!std::is_trivially_destructible<T>::value)
+            destructors.emplace_back(obj, &destroyObject<T>);
+
+        return obj;
+    }
+
+    // destroy all the objects and release the memory
+    void clear()
+    {
+        // destroy the objects in the reverse order of creation,
+        // the later objects may refer to the earlier ones
+        for (auto it = destructors.rbegin(); it != destructors.rend(); ++it)
+            it->destroy(it->object);
+
+        for (char *slab : slabs)
+            ::operator delete(slab);
+
+        destructors.clear();
+        slabs.clear();
+        cur = end = nullptr;
+    }
+
+    size_t getSlabsNum() const { return slabs.size(); }
+};
+
+} // namespace ADT
+} // namespace dg
+
+#endif // _DG_ADT_ARENA_H_
@@ -0,0 +1,490 @@
+#ifndef _DG_ADT_PERSISTENT_HASH_MAP_H_
+#define _DG_ADT_PERSISTENT_HASH_MAP_H_
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <functional>
+
+namespace dg {
+namespace ADT {
+
+// Persistent map implemented as a hash array mapped trie (HAMT).
+// Copying the map is O(1) and a modified map shares all the unchanged
+// parts of the trie with the map it was created from, so many similar
+// maps take not much more memory than one such map.
+// The shape of the trie depends only on the keys in it, so merging
+// two maps can skip the parts that the maps share.
+template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT> >
+class PersistentHashMap
+{
+public:
+    typedef std::pair<KeyT, ValueT> EntryT;
+
+private:
+    // every level of the trie takes BITS bits of the hash
+    static const unsigned BITS = 5;
+    static const unsigned MASK = (1 << BITS) - 1;
+
+    struct Node {
+        unsigned refs;
+
+        // inner node - bitmap of the occupied slots and the children
+        // in these slots (only the occupied slots are stored)
+        uint32_t bitmap;
+        std::vector<Node *> children;
+
+        // leaf - the entries with the given hash
+        // (there is more of them only on collision)
+        uint64_t hash;
+        std::vector<EntryT> entries;
+
+        Node() : refs(0), bitmap(0), hash(0) {}
+
+        bool isLeaf() const { return !entries.empty(); }
+    };
+
+    // the nodes are reference counted, a node that was just created
+    // has no references and the one who stores it takes the reference
+    Node *root;
+
+    static Node *ref(Node *n)
+    {
+        if (n)
+            ++n->refs;
+        return n;
+    }
+
+    static void destroy(Node *n)
+    {
+        for (Node *c : n->children)
+            unref(c);
+        delete n;
+    }
+
+    static void unref(Node *n)
+    {
+        if (n && --n->refs == 0)
+            destroy(n);
+    }
+
+    // delete a node that was created, but nobody took it
+    static void dispose(Node *n)
+    {
+        if (n && n->refs == 0)
+            destroy(n);
+    }
+
+    static uint64_t getHash(const KeyT& key)
+    {
+        // mix the bits, the hashes of pointers
+        // have the lowest bits always zero
+        uint64_t h = HashT()(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static unsigned getIndex(uint64_t hash, unsigned depth)
+    {
+        assert(depth * BITS < 64 && "Out of hash bits");
+        return (hash >> (depth * BITS)) & MASK;
+    }
+
+    static unsigned getPosition(uint32_t bitmap, uint32_t bit)
+    {
+        return __builtin_popcount(bitmap & (bit - 1));
+    }
+
+    static Node *newLeaf(uint64_t hash, const EntryT& e)
+    {
+        Node *n = new Node();
+        n->hash = hash;
+        n->entries.push_back(e);
+        return n;
+    }
+
+    static Node *copyNode(const Node *n)
+    {
+        Node *c = new Node(*n);
+        c->refs = 0;
+        for (Node *ch : c->children)
+            ref(ch);
+
+        return c;
+    }
+
+    static const ValueT *findAt(const Node *n, unsigned depth,
+                                uint64_t hash, const KeyT& key)
+    {
+        while (n) {
+            if (n->isLeaf()) {
+                if (n->hash != hash)
+                    return nullptr;
+
+                for (const EntryT& e : n->entries) {
+                    if (e.first == key)
+                        return &e.second;
+                }
+
+                return nullptr;
+            }
+
+            uint32_t bit = 1u << getIndex(hash, depth);
+            if (!(n->bitmap & bit))
+                return nullptr;
+
+            n = n->children[getPosition(n->bitmap, bit)];
+            ++depth;
+        }
+
+        return nullptr;
+    }
+
+    // create an inner node that contains the leaf and the new entry,
+    // the leaf must have a different hash than the entry
+    static Node *split(Node *leaf, unsigned depth,
+                       uint64_t hash, const EntryT& e)
+    {
+        assert(leaf->hash != hash);
+
+        Node *inner = new Node();
+        unsigned i1 = getIndex(leaf->hash, depth);
+        unsigned i2 = getIndex(hash, depth);
+        if (i1 == i2) {
+            inner->bitmap = 1u << i1;
+            inner->children.push_back(ref(split(leaf, depth + 1, hash, e)));
+        } else {
+            Node *l = newLeaf(hash, e);
+            inner->bitmap = (1u << i1) | (1u << i2);
+            if (i1 < i2) {
+                inner->children.push_back(ref(leaf));
+                inner->children.push_back(ref(l));
+            } else {
+                inner->children.push_back(ref(l));
+                inner->children.push_back(ref(leaf));
+            }
+        }
+
+        return inner;
+    }
+
+    // return a new node that is @n with the entry @e set
+    static Node *insertAt(Node *n, unsigned depth,
+                          uint64_t hash, const EntryT& e)
+    {
+        if (!n)
+            return newLeaf(hash, e);
+
+        if (n->isLeaf()) {
+            if (n->hash != hash)
+                return split(n, depth, hash, e);
+
+            Node *c = copyNode(n);
+            for (EntryT& old : c->entries) {
+                if (old.first == e.first) {
+                    old.second = e.second;
+                    return c;
+                }
+            }
+
+            // collision
+            c->entries.push_back(e);
+            return c;
+        }
+
+        Node *c = copyNode(n);
+        uint32_t bit = 1u << getIndex(hash, depth);
+        unsigned pos = getPosition(c->bitmap, bit);
+        if (c->bitmap & bit) {
+            Node *child = c->children[pos];
+            c->children[pos] = ref(insertAt(child, depth + 1, hash, e));
+            unref(child);
+        } else {
+            c->bitmap |= bit;
+            c->children.insert(c->children.begin() + pos,
+                               ref(newLeaf(hash, e)));
+        }
+
+        return c;
+    }
+
+    // return a node that is @n without the @key (may be nullptr
+    // if the node would be empty), or @n if it does not contain the key
+    static Node *eraseAt(Node *n, unsigned depth,
+                         uint64_t hash, const KeyT& key)
+    {
+        if (!n)
+            return nullptr;
+
+        if (n->isLeaf()) {
+            if (n->hash != hash)
+                return n;
+
+            for (size_t i = 0; i < n->entries.size(); ++i) {
+                if (n->entries[i].first == key) {
+                    if (n->entries.size() == 1)
+                        return nullptr;
+
+                    Node *c = copyNode(n);
+                    c->entries.erase(c->entries.begin() + i);
+                    return c;
+                }
+            }
+
+            return n;
+        }
+
+        uint32_t bit = 1u << getIndex(hash, depth);
+        if (!(n->bitmap & bit))
+            return n;
+
+        unsigned pos = getPosition(n->bitmap, bit);
+        Node *child = n->children[pos];
+        Node *nc = eraseAt(child, depth + 1, hash, key);
+        if (nc == child)
+            return n;
+
+        if (!nc && n->children.size() == 1)
+            return nullptr;
+
+        // keep the shape of the trie canonical - a node with a single
+        // leaf is replaced by that leaf
+        if (n->children.size() == 1 && nc->isLeaf())
+            return nc;
+        if (!nc && n->children.size() == 2
+            && n->children[1 - pos]->isLeaf())
+            return n->children[1 - pos];
+
+        Node *c = copyNode(n);
+        unref(c->children[pos]);
+        if (nc) {
+            c->children[pos] = ref(nc);
+        } else {
+            c->bitmap &= ~bit;
+            c->children.erase(c->children.begin() + pos);
+        }
+
+        return c;
+    }
+
+    // insert the entries of the leaf @from into the node @to,
+    // @mergeValues gets the value from @to first if @from_first is false
+    template <typename MergeT>
+    static Node *mergeLeaf(Node *to, const Node *from, unsigned depth,
+                           MergeT& mergeValues, bool from_first)
+    {
+        Node *cur = to;
+        for (const EntryT& e : from->entries) {
+            Node *nn;
+            const ValueT *v = findAt(cur, depth, from->hash, e.first);
+            if (v) {
+                ValueT merged = from_first ? mergeValues(e.second, *v)
+                                           : mergeValues(*v, e.second);
+                if (merged == *v)
+                    continue;
+
+                nn = insertAt(cur, depth, from->hash, EntryT(e.first, merged));
+            } else
+                nn = insertAt(cur, depth, from->hash, e);
+
+            // intermediate result
+            if (cur != to)
+                dispose(cur);
+            cur = nn;
+        }
+
+        return cur;
+    }
+
+    template <typename MergeT>
+    static Node *mergeAt(Node *a, Node *b, unsigned depth, MergeT& mergeValues)
+    {
+        if (a == b || !b)
+            return a;
+        if (!a)
+            return b;
+
+        if (b->isLeaf())
+            return mergeLeaf(a, b, depth, mergeValues, false);
+        if (a->isLeaf())
+            return mergeLeaf(b, a, depth, mergeValues, true);
+
+        uint32_t bitmap = a->bitmap | b->bitmap;
+        bool same_as_a = bitmap == a->bitmap;
+        bool same_as_b = bitmap == b->bitmap;
+        std::vector<Node *> children;
+        children.reserve(__builtin_popcount(bitmap));
+
+        for (unsigned i = 0; i <= MASK; ++i) {
+            uint32_t bit = 1u << i;
+            if (!(bitmap & bit))
+                continue;
+
+            Node *ca = (a->bitmap & bit)
+                        ? a->children[getPosition(a->bitmap, bit)] : nullptr;
+            Node *cb = (b->bitmap & bit)
+                        ? b->children[getPosition(b->bitmap, bit)] : nullptr;
+            Node *c = mergeAt(ca, cb, depth + 1, mergeValues);
+
+            same_as_a &= (c == ca);
+            same_as_b &= (c == cb);
+            children.push_back(c);
+        }
+
+        // all the children are the children of one of the nodes,
+        // so we did not create any new node
+        if (same_as_a)
+            return a;
+        if (same_as_b)
+            return b;
+
+        Node *n = new Node();
+        n->bitmap = bitmap;
+        for (Node *c : children)
+            n->children.push_back(ref(c));
+
+        return n;
+    }
+
+    void setRoot(Node *n)
+    {
+        if (n == root)
+            return;
+
+        ref(n);
+        unref(root);
+        root = n;
+    }
+
+public:
+    PersistentHashMap() : root(nullptr) {}
+    PersistentHashMap(const PersistentHashMap& oth) : root(ref(oth.root)) {}
+    ~PersistentHashMap() { unref(root); }
+
+    PersistentHashMap& operator=(const PersistentHashMap& oth)
+    {
+        setRoot(oth.root);
+        return *this;
+    }
+
+    bool empty() const { return root == nullptr; }
+    void clear() { setRoot(nullptr); }
+
+    // do the maps share the whole trie? (then they are equal)
+    bool shares(const PersistentHashMap& oth) const
+    {
+        return root == oth.root;
+    }
+
+    const ValueT *find(const KeyT& key) const
+    {
+        return findAt(root, 0, getHash(key), key);
+    }
+
+    void set(const KeyT& key, const ValueT& value)
+    {
+        setRoot(insertAt(root, 0, getHash(key), EntryT(key, value)));
+    }
+
+    // return true if the key was in the map
+    bool erase(const KeyT& key)
+    {
+        Node *n = eraseAt(root, 0, getHash(key), key);
+        if (n == root)
+            return false;
+
+        setRoot(n);
+        return true;
+    }
+
+    // add the entries from @oth into this map, the values of keys
+    // that are in both maps are merged using @mergeValues(this_value,
+    // oth_value). It must return this_value if there is nothing new.
+    // Return true if this map changed.
+    template <typename MergeT>
+    bool merge(const PersistentHashMap& oth, MergeT mergeValues)
+    {
+        Node *n = mergeAt(root, oth.root, 0, mergeValues);
+        if (n == root)
+            return false;
+
+        setRoot(n);
+        return true;
+    }
+
+    class const_iterator
+    {
+        // path to the current entry - nodes and indices
+        // of the child (or entry) in them
+        std::vector<std::pair<const Node *, size_t> > path;
+
+        // move to the first entry at or after the current position
+        void descend()
+        {
+            while (!path.empty()) {
+                auto& top = path.back();
+                const Node *n = top.first;
+                if (n->isLeaf()) {
+                    if (top.second < n->entries.size())
+                        return;
+                } else if (top.second < n->children.size()) {
+                    path.push_back(std::make_pair(n->children[top.second],
+                                                  (size_t) 0));
+                    continue;
+                }
+
+                path.pop_back();
+                if (!path.empty())
+                    ++path.back().second;
+            }
+        }
+
+    public:
+        const_iterator(const Node *root = nullptr)
+        {
+            if (root) {
+                path.push_back(std::make_pair(root, (size_t) 0));
+                descend();
+            }
+        }
+
+        const EntryT& operator*() const
+        {
+            assert(!path.empty());
+            return path.back().first->entries[path.back().second];
+        }
+
+        const EntryT *operator->() const { return &operator*(); }
+
+        const_iterator& operator++()
+        {
+            assert(!path.empty());
+            ++path.back().second;
+            descend();
+            return *this;
+        }
+
+        bool operator==(const const_iterator& oth) const
+        {
+            return path == oth.path;
+        }
+
+        bool operator!=(const const_iterator& oth) const
+        {
+            return !operator==(oth);
+        }
+    };
+
+    const_iterator begin() const { return const_iterator(root); }
+    const_iterator end() const { return const_iterator(); }
+};
+
+} // namespace ADT
+} // namespace dg
+
+#endif // _DG_ADT_PERSISTENT_HASH_MAP_H_
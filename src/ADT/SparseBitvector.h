@@ -0,0 +1,337 @@
+#ifndef _DG_ADT_SPARSE_BITVECTOR_H_
+#define _DG_ADT_SPARSE_BITVECTOR_H_
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace dg {
+namespace ADT {
+
+// Set of unsigned integers stored as a sorted vector
+// of (word index, 64-bit word) pairs. Only non-zero words
+// are kept, so sparse sets take little memory, but operations
+// on whole sets (union, intersection, subset test) work on
+// whole words instead of single elements.
+class SparseBitvector
+{
+public:
+    typedef uint64_t WordT;
+    typedef std::pair<size_t, WordT> ElementT;
+    static const unsigned BITS_PER_WORD = 64;
+
+    class const_iterator
+    {
+        const std::vector<ElementT> *words;
+        size_t pos;
+        // bits of the current word that we did not visit yet
+        WordT rest;
+
+        void skipEmpty()
+        {
+            while (rest == 0) {
+                if (++pos >= words->size())
+                    return;
+
+                rest = (*words)[pos].second;
+            }
+        }
+
+    public:
+        const_iterator(const std::vector<ElementT> *w, size_t p, WordT r = 0)
+        : words(w), pos(p), rest(r)
+        {
+            if (pos < words->size()) {
+                if (rest == 0)
+                    rest = (*words)[pos].second;
+                skipEmpty();
+            }
+        }
+
+        size_t operator*() const
+        {
+            assert(pos < words->size() && rest != 0);
+            return (*words)[pos].first * BITS_PER_WORD
+                   + __builtin_ctzll(rest);
+        }
+
+        const_iterator& operator++()
+        {
+            // clear the lowest set bit
+            rest &= rest - 1;
+            skipEmpty();
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator tmp = *this;
+            operator++();
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& oth) const
+        {
+            return pos == oth.pos && (pos >= words->size() || rest == oth.rest);
+        }
+
+        bool operator!=(const const_iterator& oth) const
+        {
+            return !operator==(oth);
+        }
+    };
+
+    bool empty() const { return words.empty(); }
+    void clear() { words.clear(); }
+    void swap(SparseBitvector& oth) { words.swap(oth.words); }
+
+    size_t size() const
+    {
+        size_t num = 0;
+        for (const ElementT& w : words)
+            num += __builtin_popcountll(w.second);
+
+        return num;
+    }
+
+    // return true if the bit was not set before
+    bool set(size_t i)
+    {
+        size_t idx = i / BITS_PER_WORD;
+        WordT mask = ((WordT) 1) << (i % BITS_PER_WORD);
+
+        auto it = findWord(idx);
+        if (it != words.end() && it->first == idx) {
+            if (it->second & mask)
+                return false;
+
+            it->second |= mask;
+            return true;
+        }
+
+        words.insert(it, ElementT(idx, mask));
+        return true;
+    }
+
+    // return true if the bit was set before
+    bool unset(size_t i)
+    {
+        size_t idx = i / BITS_PER_WORD;
+        WordT mask = ((WordT) 1) << (i % BITS_PER_WORD);
+
+        auto it = findWord(idx);
+        if (it == words.end() || it->first != idx || !(it->second & mask))
+            return false;
+
+        it->second &= ~mask;
+        // keep only non-zero words
+        if (it->second == 0)
+            words.erase(it);
+
+        return true;
+    }
+
+    bool get(size_t i) const
+    {
+        size_t idx = i / BITS_PER_WORD;
+        auto it = findWord(idx);
+        if (it == words.end() || it->first != idx)
+            return false;
+
+        return (it->second >> (i % BITS_PER_WORD)) & 1;
+    }
+
+    // is every bit from this vector set in @oth?
+    bool isSubsetOf(const SparseBitvector& oth) const
+    {
+        auto I = oth.words.begin(), E = oth.words.end();
+        for (const ElementT& w : words) {
+            while (I != E && I->first < w.first)
+                ++I;
+
+            if (I == E || I->first != w.first)
+                return false;
+
+            if ((w.second & ~I->second) != 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool intersects(const SparseBitvector& oth) const
+    {
+        auto I = words.begin(), E = words.end();
+        auto OI = oth.words.begin(), OE = oth.words.end();
+        while (I != E && OI != OE) {
+            if (I->first < OI->first)
+                ++I;
+            else if (OI->first < I->first)
+                ++OI;
+            else {
+                if (I->second & OI->second)
+                    return true;
+                ++I;
+                ++OI;
+            }
+        }
+
+        return false;
+    }
+
+    // this = this | oth
+    // return true if this vector changed
+    bool set(const SparseBitvector& oth)
+    {
+        // the most common case in the fixpoint computation
+        // is that nothing new is added, check that first
+        // without any allocation
+        if (oth.isSubsetOf(*this))
+            return false;
+
+        std::vector<ElementT> result;
+        result.reserve(words.size() + oth.words.size());
+
+        auto I = words.begin(), E = words.end();
+        auto OI = oth.words.begin(), OE = oth.words.end();
+        while (I != E || OI != OE) {
+            if (OI == OE || (I != E && I->first < OI->first)) {
+                result.push_back(*I++);
+            } else if (I == E || OI->first < I->first) {
+                result.push_back(*OI++);
+            } else {
+                result.push_back(ElementT(I->first, I->second | OI->second));
+                ++I;
+                ++OI;
+            }
+        }
+
+        words.swap(result);
+        return true;
+    }
+
+    // this = this & oth
+    // return true if this vector changed
+    bool intersect(const SparseBitvector& oth)
+    {
+        bool changed = false;
+        std::vector<ElementT> result;
+        result.reserve(std::min(words.size(), oth.words.size()));
+
+        auto OI = oth.words.begin(), OE = oth.words.end();
+        for (const ElementT& w : words) {
+            while (OI != OE && OI->first < w.first)
+                ++OI;
+
+            WordT val = (OI != OE && OI->first == w.first) ? w.second & OI->second : 0;
+            if (val != w.second)
+                changed = true;
+            if (val != 0)
+                result.push_back(ElementT(w.first, val));
+        }
+
+        if (changed)
+            words.swap(result);
+
+        return changed;
+    }
+
+    // this = this & ~oth
+    // return true if this vector changed
+    bool unset(const SparseBitvector& oth)
+    {
+        if (!intersects(oth))
+            return false;
+
+        std::vector<ElementT> result;
+        result.reserve(words.size());
+
+        auto OI = oth.words.begin(), OE = oth.words.end();
+        for (const ElementT& w : words) {
+            while (OI != OE && OI->first < w.first)
+                ++OI;
+
+            WordT val = w.second;
+            if (OI != OE && OI->first == w.first)
+                val &= ~OI->second;
+            if (val != 0)
+                result.push_back(ElementT(w.first, val));
+        }
+
+        words.swap(result);
+        return true;
+    }
+
+    bool operator==(const SparseBitvector& oth) const
+    {
+        return words == oth.words;
+    }
+
+    bool operator!=(const SparseBitvector& oth) const
+    {
+        return !operator==(oth);
+    }
+
+    size_t hash() const
+    {
+        size_t h = words.size();
+        for (const ElementT& w : words) {
+            h ^= w.first + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            h ^= w.second + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        }
+
+        return h;
+    }
+
+    // get iterator pointing to the bit @i or to the first
+    // set bit after @i
+    const_iterator find(size_t i) const
+    {
+        size_t idx = i / BITS_PER_WORD;
+        auto it = findWord(idx);
+        if (it == words.end())
+            return end();
+
+        size_t pos = it - words.begin();
+        if (it->first != idx)
+            return const_iterator(&words, pos);
+
+        WordT rest = it->second & (~((WordT) 0) << (i % BITS_PER_WORD));
+        if (rest == 0)
+            // move to the next word
+            return const_iterator(&words, pos + 1);
+
+        return const_iterator(&words, pos, rest);
+    }
+
+    const_iterator begin() const { return const_iterator(&words, 0); }
+    const_iterator end() const { return const_iterator(&words, words.size()); }
+
+    // the number of non-zero words, for statistics
+    size_t wordsNum() const { return words.size(); }
+
+private:
+    std::vector<ElementT> words;
+
+    static bool compWord(const ElementT& w, size_t idx)
+    {
+        return w.first < idx;
+    }
+
+    std::vector<ElementT>::iterator findWord(size_t idx)
+    {
+        return std::lower_bound(words.begin(), words.end(), idx, compWord);
+    }
+
+    std::vector<ElementT>::const_iterator findWord(size_t idx) const
+    {
+        return std::lower_bound(words.begin(), words.end(), idx, compWord);
+    }
+};
+
+} // namespace ADT
+} // namespace dg
+
+#endif // _DG_ADT_SPARSE_BITVECTOR_H_
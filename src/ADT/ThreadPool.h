@@ -0,0 +1,105 @@
+#ifndef _DG_ADT_THREAD_POOL_H_
+#define _DG_ADT_THREAD_POOL_H_
+
+#include <cassert>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dg {
+namespace ADT {
+
+// A fixed set of threads that run the same job together.
+// run(fun) calls fun(0), ..., fun(size() - 1), each in its own thread
+// (the last one in the calling thread) and waits for all of them.
+// The threads are created once and sleep between the jobs, so that
+// running many short jobs does not pay for creating the threads.
+class ThreadPool
+{
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+
+    const std::function<void(unsigned)> *job;
+    // the number of the job, the threads wait until it changes
+    unsigned long generation;
+    // the number of threads that did not finish the current job
+    unsigned running;
+    bool stop;
+
+    void worker(unsigned id)
+    {
+        unsigned long seen = 0;
+        while (true) {
+            const std::function<void(unsigned)> *fun;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                job_ready.wait(guard, [&] { return stop || generation != seen; });
+                if (stop)
+                    return;
+
+                seen = generation;
+                fun = job;
+            }
+
+            (*fun)(id);
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (--running == 0)
+                job_done.notify_one();
+        }
+    }
+
+public:
+    ThreadPool(unsigned num = 1)
+    : job(nullptr), generation(0), running(0), stop(false)
+    {
+        assert(num > 0);
+        threads.reserve(num - 1);
+        for (unsigned i = 0; i + 1 < num; ++i)
+            threads.emplace_back(&ThreadPool::worker, this, i);
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stop = true;
+        }
+
+        job_ready.notify_all();
+        for (std::thread& t : threads)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return threads.size() + 1; }
+
+    void run(const std::function<void(unsigned)>& fun)
+    {
+        if (!threads.empty()) {
+            std::lock_guard<std::mutex> guard(lock);
+            assert(running == 0 && "Running a job from the job");
+            job = &fun;
+            running = threads.size();
+            ++generation;
+        }
+
+        job_ready.notify_all();
+        fun(threads.size());
+
+        std::unique_lock<std::mutex> guard(lock);
+        job_done.wait(guard, [&] { return running == 0; });
+        job = nullptr;
+    }
+};
+
+} // namespace ADT
+} // namespace dg
+
+#endif // _DG_ADT_THREAD_POOL_H_
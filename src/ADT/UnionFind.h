@@ -0,0 +1,113 @@
+#ifndef _DG_ADT_UNION_FIND_H_
+#define _DG_ADT_UNION_FIND_H_
+
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+
+namespace dg {
+namespace ADT {
+
+// Disjoint sets of elements with union by rank and path compression.
+// Elements that were never united with anything are not stored at all,
+// every such element is the representative of its own singleton set.
+template <typename ValueT>
+class UnionFind
+{
+    struct Entry {
+        ValueT parent;
+        unsigned rank;
+
+        Entry(const ValueT& p) : parent(p), rank(0) {}
+    };
+
+    std::unordered_map<ValueT, Entry> entries;
+
+    Entry& getEntry(const ValueT& x)
+    {
+        auto it = entries.find(x);
+        if (it == entries.end())
+            it = entries.emplace(x, Entry(x)).first;
+
+        return it->second;
+    }
+
+public:
+    // get the representative of the set that contains @x
+    ValueT find(const ValueT& x)
+    {
+        auto it = entries.find(x);
+        if (it == entries.end())
+            return x;
+
+        ValueT& parent = it->second.parent;
+        if (parent == x)
+            return x;
+
+        // path compression. Write only when the path is not
+        // compressed yet, so that after compressing all the paths
+        // the structure can be searched from more threads at once
+        ValueT root = find(parent);
+        if (parent != root)
+            parent = root;
+
+        return root;
+    }
+
+    // merge the sets that contain @x and @y,
+    // return the representative of the new set
+    ValueT unite(const ValueT& x, const ValueT& y)
+    {
+        ValueT rx = find(x);
+        ValueT ry = find(y);
+        if (rx == ry)
+            return rx;
+
+        Entry& ex = getEntry(rx);
+        Entry& ey = getEntry(ry);
+        if (ex.rank < ey.rank) {
+            ex.parent = ry;
+            return ry;
+        }
+
+        ey.parent = rx;
+        if (ex.rank == ey.rank)
+            ++ex.rank;
+
+        return rx;
+    }
+
+    // merge the set that contains @x into the set that contains @into,
+    // the representative of @into's set stays the representative
+    ValueT merge(const ValueT& x, const ValueT& into)
+    {
+        ValueT rx = find(x);
+        ValueT rinto = find(into);
+        if (rx == rinto)
+            return rinto;
+
+        Entry& ex = getEntry(rx);
+        Entry& einto = getEntry(rinto);
+        ex.parent = rinto;
+        // keep the rank an upper bound on the height of the tree
+        if (einto.rank <= ex.rank)
+            einto.rank = ex.rank + 1;
+
+        return rinto;
+    }
+
+    bool isRepresentative(const ValueT& x)
+    {
+        return find(x) == x;
+    }
+
+    // the number of elements that were united with something
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void clear() { entries.clear(); }
+};
+
+} // namespace ADT
+} // namespace dg
+
+#endif // _DG_ADT_UNION_FIND_H_
@@ -7,30 +7,121 @@ namespace analysis {
 #define UNKNOWN_OFFSET ~((uint64_t) 0)
 
 // just a wrapper around uint64_t to
-// handle UNKNOWN_OFFSET somehow easily
-// maybe later we'll make it a range
+// handle UNKNOWN_OFFSET somehow easily.
+//
+// Besides concrete offsets and UNKNOWN_OFFSET, the offset can be
+// strided: base + k*stride for any integer k, which is the offset
+// of a field in an array of structures indexed by a variable.
+// The strided offset is packed into the 64 bits, so that it costs
+// nothing to have it in pointers: the highest bit is set, the stride
+// is in the bits 32 - 62 and the base (base < stride) in the lower bits.
+// The stride bits of (small) negative concrete offsets are all set,
+// so these are not mistaken for strided offsets. The concrete offsets
+// below about -2^32 would be, so they are UNKNOWN_OFFSET
+// (see getConcrete()).
+// Code that does not care about the strided offsets can treat
+// all the offsets that are not concrete as unknown.
 struct Offset
 {
+    enum : uint64_t {
+        STRIDED_FLAG = 1ULL << 63,
+        MAX_STRIDE = (1ULL << 31) - 2,
+    };
+
     Offset(uint64_t o = UNKNOWN_OFFSET) : offset(o) {}
-    Offset& operator+=(const Offset& o)
+
+    // the concrete offset @o, or UNKNOWN_OFFSET if @o would be
+    // read as a strided offset. Use this for the offsets computed
+    // from the program, the constructor takes also the encoded offsets
+    static Offset getConcrete(uint64_t o)
+    {
+        Offset off(o);
+        if (off.isStrided())
+            return UNKNOWN_OFFSET;
+
+        return off;
+    }
+
+    // base + k*stride, stride 0 means just the base. If the stride
+    // is too big (or 1, in which case it can be any offset),
+    // return UNKNOWN_OFFSET
+    static Offset getStrided(int64_t base, uint64_t stride)
     {
-        if (offset == UNKNOWN_OFFSET)
-            return *this;
+        if (stride == 0)
+            return getConcrete(static_cast<uint64_t>(base));
+        if (stride == 1 || stride > MAX_STRIDE)
+            return UNKNOWN_OFFSET;
+
+        int64_t b = base % static_cast<int64_t>(stride);
+        if (b < 0)
+            b += stride;
 
-        if (o.offset == UNKNOWN_OFFSET)
-            offset = UNKNOWN_OFFSET;
-        else
-            offset += o.offset;
+        return Offset(STRIDED_FLAG | (stride << 32) | static_cast<uint64_t>(b));
+    }
+
+    static uint64_t gcd(uint64_t a, uint64_t b)
+    {
+        while (b != 0) {
+            uint64_t t = a % b;
+            a = b;
+            b = t;
+        }
+
+        return a;
+    }
+
+    bool isUnknown() const { return offset == UNKNOWN_OFFSET; }
+    bool isStrided() const
+    {
+        return (offset & STRIDED_FLAG)
+               && ((offset & ~STRIDED_FLAG) >> 32) <= MAX_STRIDE;
+    }
 
+    bool isConcrete() const { return !isUnknown() && !isStrided(); }
+
+    uint64_t getStride() const
+    {
+        return isStrided() ? (offset & ~STRIDED_FLAG) >> 32 : 0;
+    }
+
+    // the base of strided offset or the concrete offset
+    uint64_t getBase() const
+    {
+        return isStrided() ? offset & 0xffffffffULL : offset;
+    }
+
+    // may the offsets be the same?
+    bool mayAlias(const Offset& o) const
+    {
+        if (isUnknown() || o.isUnknown())
+            return true;
+
+        uint64_t g = gcd(getStride(), o.getStride());
+        if (g == 0)
+            return offset == o.offset;
+
+        // the concrete offsets (possibly negative) wrap around,
+        // so compute the difference as signed
+        int64_t diff = static_cast<int64_t>(getBase() - o.getBase());
+        return diff % static_cast<int64_t>(g) == 0;
+    }
+
+    Offset& operator+=(const Offset& o)
+    {
+        *this = *this + o;
         return *this;
     }
 
-    Offset operator+(const Offset& o)
+    Offset operator+(const Offset& o) const
     {
         if (offset == UNKNOWN_OFFSET || o.offset == UNKNOWN_OFFSET)
             return UNKNOWN_OFFSET;
 
-        return Offset(offset + o.offset);
+        if (isConcrete() && o.isConcrete())
+            return getConcrete(offset + o.offset);
+
+        return getStrided(static_cast<int64_t>(getBase() + o.getBase()),
+                          gcd(getStride(), o.getStride()));
     }
 
     bool operator<(const Offset& o) const
@@ -43,13 +134,17 @@ struct Offset
         return offset == o.offset;
     }
 
+    // is the concrete offset in the range? The strided offsets
+    // are not compared (their encoding is not ordered with the
+    // concrete offsets), the callers must handle them as unknown
     bool inRange(uint64_t from, uint64_t to) const
     {
+        if (isStrided())
+            return false;
+
         return (offset >= from && offset <= to);
     }
 
-    bool isUnknown() const { return offset == UNKNOWN_OFFSET; }
-
     uint64_t operator*() const { return offset; }
     const uint64_t *operator->() const { return &offset; }
 
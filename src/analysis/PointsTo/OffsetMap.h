@@ -0,0 +1,139 @@
+#ifndef _DG_OFFSET_MAP_H_
+#define _DG_OFFSET_MAP_H_
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "analysis/Offset.h"
+
+namespace dg {
+namespace analysis {
+namespace pta {
+
+// Mapping from offsets to sets stored in a sorted vector.
+// Memory objects have usually only a few offsets with pointers
+// and are read much more often than written, so the lookups
+// in contiguous memory pay off. UNKNOWN_OFFSET is the greatest
+// offset, so its entry (if any) is always the last one and
+// can be found in constant time.
+// NOTE: unlike with std::map, adding a new offset invalidates
+// the iterators and the references to the sets in the map.
+template <typename SetT>
+class OffsetMap
+{
+public:
+    typedef std::pair<Offset, SetT> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+private:
+    std::vector<value_type> entries;
+    // the number of strided offsets in the map
+    size_t strided = 0;
+
+    static bool keyLess(const value_type& v, const Offset& off)
+    {
+        return v.first < off;
+    }
+
+    template <typename It>
+    static It findIn(It b, It e, const Offset& off)
+    {
+        It it = std::lower_bound(b, e, off, keyLess);
+        if (it != e && it->first == off)
+            return it;
+
+        return e;
+    }
+
+public:
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    bool hasStrided() const { return strided > 0; }
+
+    void clear()
+    {
+        entries.clear();
+        strided = 0;
+    }
+
+    iterator lower_bound(const Offset& off)
+    {
+        return std::lower_bound(entries.begin(), entries.end(), off, keyLess);
+    }
+
+    const_iterator lower_bound(const Offset& off) const
+    {
+        return std::lower_bound(entries.begin(), entries.end(), off, keyLess);
+    }
+
+    iterator find(const Offset& off)
+    {
+        return findIn(entries.begin(), entries.end(), off);
+    }
+
+    const_iterator find(const Offset& off) const
+    {
+        return findIn(entries.begin(), entries.end(), off);
+    }
+
+    size_t count(const Offset& off) const { return find(off) != end(); }
+
+    // the set at the offset or nullptr
+    const SetT *get(const Offset& off) const
+    {
+        auto it = find(off);
+        return it == end() ? nullptr : &it->second;
+    }
+
+    const SetT *getUnknown() const
+    {
+        if (entries.empty() || !entries.back().first.isUnknown())
+            return nullptr;
+
+        return &entries.back().second;
+    }
+
+    // the set at the offset and the set at UNKNOWN_OFFSET
+    // (or nullptrs) with one search
+    std::pair<const SetT *, const SetT *> getWithUnknown(const Offset& off) const
+    {
+        const SetT *unknown = getUnknown();
+        if (off.isUnknown())
+            return std::make_pair(unknown, unknown);
+
+        // do not search the entry with UNKNOWN_OFFSET
+        auto e = unknown ? entries.end() - 1 : entries.end();
+        auto it = findIn(entries.begin(), e, off);
+        return std::make_pair(it == e ? nullptr : &it->second, unknown);
+    }
+
+    SetT& operator[](const Offset& off)
+    {
+        // the common case - adding to the unknown offset
+        // or to the greatest concrete offset
+        if (!entries.empty() && entries.back().first == off)
+            return entries.back().second;
+
+        auto it = lower_bound(off);
+        if (it != entries.end() && it->first == off)
+            return it->second;
+
+        if (off.isStrided())
+            ++strided;
+
+        return entries.insert(it, value_type(off, SetT()))->second;
+    }
+};
+
+} // namespace pta
+} // namespace analysis
+} // namespace dg
+
+#endif // _DG_OFFSET_MAP_H_
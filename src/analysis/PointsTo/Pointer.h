@@ -6,6 +6,8 @@
 #include <cassert>
 
 #include "analysis/Offset.h"
+#include "analysis/PointsTo/PointsToSet.h"
+#include "analysis/PointsTo/OffsetMap.h"
 
 namespace dg {
 namespace analysis {
@@ -49,8 +51,29 @@ struct Pointer
     bool isValid() const { return !isNull() && !isUnknown(); }
 };
 
+#if defined(ENABLE_SHARED_PTSETS)
+typedef SharedPointsToSet<Pointer> PointsToSetT;
+#elif defined(ENABLE_SPARSE_PTSETS)
+typedef SparseBitvectorPointsToSet<Pointer> PointsToSetT;
+#else
 typedef std::set<Pointer> PointsToSetT;
-typedef std::map<Offset, PointsToSetT> PointsToMapT;
+#endif
+typedef OffsetMap<PointsToSetT> PointsToMapT;
+
+// The pointer to unknown memory stands for any pointer. With the
+// saturation (see PointerAnalysis::setSaturateUnknown()) the set that
+// contains it does not take other pointers anymore ("top"), only
+// the pointers to functions are kept, so that the calls via the pointer
+// still know what they call.
+inline bool isTopSet(const PointsToSetT& S)
+{
+    return S.count(PointerUnknown) > 0;
+}
+
+// make the set top (keep only the unknown pointer and the pointers
+// to functions), return true if the set changed
+bool makeTopSet(PointsToSetT& S);
+
 typedef std::set<PSNode *> ValuesSetT;
 typedef std::map<Offset, ValuesSetT> ValuesMapT;
 
@@ -66,13 +89,20 @@ struct MemoryObject
 
     PointsToSetT& getPointsTo(const Offset& off) { return pointsTo[off]; }
 
-    bool addPointsTo(const Offset& off, const Pointer& ptr)
+    // the object has the unknown pointer at unknown offset, so a load
+    // from any offset may yield any pointer (see isTopSet())
+    bool isTop() const
     {
-        /*
-        if (isUnknown())
-            return false;
-            */
+        const PointsToSetT *S = pointsTo.getUnknown();
+        return S && isTopSet(*S);
+    }
 
+    // keep only the top set at UNKNOWN_OFFSET,
+    // return true if the object changed
+    bool makeTop();
+
+    bool addPointsTo(const Offset& off, const Pointer& ptr)
+    {
         assert(ptr.target != nullptr
                && "Cannot have NULL target, use unknown instead");
 
@@ -81,17 +111,17 @@ struct MemoryObject
 
     bool addPointsTo(const Offset& off, const PointsToSetT& pointers)
     {
-        /*
-        if (isUnknown())
-            return false;
-            */
-
+#ifdef ENABLE_SPARSE_PTSETS
+        // union the bitvectors at once
+        return pointsTo[off].add(pointers);
+#else
         bool changed = false;
 
         for (const Pointer& ptr : pointers)
             changed |= addPointsTo(off, ptr);
 
         return changed;
+#endif
     }
 
 
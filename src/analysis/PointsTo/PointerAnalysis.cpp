@@ -1,6 +1,16 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <set>
+
 #include "Pointer.h"
 #include "PointerSubgraph.h"
 #include "PointerAnalysis.h"
+#include "SteensgaardClasses.h"
 
 namespace dg {
 namespace analysis {
@@ -16,21 +26,26 @@ PSNode *UNKNOWN_MEMORY = &UNKNOWN_MEMLOC;
 const Pointer PointerUnknown(UNKNOWN_MEMORY, UNKNOWN_OFFSET);
 const Pointer PointerNull(NULLPTR, 0);
 
+thread_local PointerAnalysis::RoundUpdates *PointerAnalysis::round_updates = nullptr;
+
 // replace all pointers to given target with one
 // to that target, but UNKNOWN_OFFSET
 bool PSNode::addPointsToUnknownOffset(PSNode *target)
 {
-    bool changed = false;
-    for (auto I = pointsTo.begin(), E = pointsTo.end(); I != E;) {
-        auto cur = I++;
-
-        // erase pointers to the same memory but with concrete offset
-        if (cur->target == target && !cur->offset.isUnknown()) {
-            pointsTo.erase(cur);
-            changed = true;
-        }
+    // erase pointers to the same memory but with concrete offset.
+    // Gather them first, so that we do not need to erase using
+    // iterators (that the sparse-bitvector sets do not support)
+    std::vector<Pointer> to_erase;
+    for (const Pointer& ptr : pointsTo) {
+        if (ptr.target == target && !ptr.offset.isUnknown())
+            to_erase.push_back(ptr);
     }
 
+    for (const Pointer& ptr : to_erase)
+        pointsTo.erase(ptr);
+
+    bool changed = !to_erase.empty();
+
     // DONT use addPointsTo() method, it would recursively call
     // this method again, until stack overflow
     changed |= pointsTo.insert(Pointer(target, UNKNOWN_OFFSET)).second;
@@ -38,18 +53,475 @@ bool PSNode::addPointsToUnknownOffset(PSNode *target)
     return changed;
 }
 
+void PSNode::removeCoveredOffsets()
+{
+    std::set<PSNode *> unknown;
+    for (const Pointer& ptr : pointsTo) {
+        if (ptr.offset.isUnknown())
+            unknown.insert(ptr.target);
+    }
+
+    if (unknown.empty())
+        return;
+
+    std::vector<Pointer> to_erase;
+    for (const Pointer& ptr : pointsTo) {
+        if (!ptr.offset.isUnknown() && unknown.count(ptr.target) > 0)
+            to_erase.push_back(ptr);
+    }
+
+    if (to_erase.empty())
+        return;
+
+#ifdef ENABLE_SPARSE_PTSETS
+    // remove them at once, the shared sets intern only the result
+    PointsToSetT erased;
+    erased.insert(to_erase.begin(), to_erase.end());
+    pointsTo.remove(erased);
+#else
+    for (const Pointer& ptr : to_erase)
+        pointsTo.erase(ptr);
+#endif
+}
+
+static bool isFunctionPointer(const Pointer& ptr)
+{
+    return ptr.target->getType() == FUNCTION;
+}
+
+bool makeTopSet(PointsToSetT& S)
+{
+    PointsToSetT top;
+    top.insert(PointerUnknown);
+    for (const Pointer& ptr : S) {
+        if (isFunctionPointer(ptr))
+            top.insert(ptr);
+    }
+
+    if (top == S)
+        return false;
+
+    S = top;
+    return true;
+}
+
+bool MemoryObject::makeTop()
+{
+    if (isTop() && pointsTo.size() == 1)
+        return false;
+
+    PointsToSetT top;
+    top.insert(PointerUnknown);
+    for (auto& it : pointsTo) {
+        for (const Pointer& ptr : it.second) {
+            if (isFunctionPointer(ptr))
+                top.insert(ptr);
+        }
+    }
+
+    pointsTo.clear();
+    pointsTo[UNKNOWN_OFFSET] = top;
+    return true;
+}
+
+// add the pointers with the saturation - the unknown pointer makes
+// the set top and the top set takes only the pointers to functions
+static bool addSaturated(PSNode *node, const Pointer& ptr)
+{
+    if (ptr.isUnknown())
+        return node->makeTop();
+
+    if (node->isTop() && !isFunctionPointer(ptr))
+        return false;
+
+    return node->addPointsTo(ptr);
+}
+
+static bool addSaturated(PSNode *node, const PointsToSetT& ptrs)
+{
+    if (!node->isTop() && !isTopSet(ptrs))
+        return node->addPointsTo(ptrs);
+
+    bool changed = node->makeTop();
+    for (const Pointer& ptr : ptrs) {
+        if (isFunctionPointer(ptr))
+            changed |= node->addPointsTo(ptr);
+    }
+
+    return changed;
+}
+
+static bool addSaturated(MemoryObject *o, const Offset& off, const Pointer& ptr)
+{
+    if (ptr.isUnknown())
+        return off.isUnknown() ? o->makeTop() : makeTopSet(o->pointsTo[off]);
+
+    // the top object has only the set at UNKNOWN_OFFSET
+    if (o->isTop())
+        return isFunctionPointer(ptr)
+               && o->addPointsTo(UNKNOWN_OFFSET, ptr);
+
+    if (!isFunctionPointer(ptr)) {
+        const PointsToSetT *S = o->pointsTo.get(off);
+        if (S && isTopSet(*S))
+            return false;
+    }
+
+    return o->addPointsTo(off, ptr);
+}
+
+static bool addSaturated(MemoryObject *o, const Offset& off,
+                         const PointsToSetT& ptrs)
+{
+    if (!o->isTop() && !isTopSet(ptrs)) {
+        const PointsToSetT *S = o->pointsTo.get(off);
+        if (!S || !isTopSet(*S))
+            return o->addPointsTo(off, ptrs);
+    }
+
+    bool changed = false;
+    if (isTopSet(ptrs))
+        changed |= addSaturated(o, off, PointerUnknown);
+
+    for (const Pointer& ptr : ptrs) {
+        if (isFunctionPointer(ptr))
+            changed |= addSaturated(o, off, ptr);
+    }
+
+    return changed;
+}
+
+// get the pointers that were added to the operand since the node
+// was processed the last time. The pointers are taken from the log
+// of the operand, so no copy of the operand is kept at the user.
+// Return false if there are no such pointers
+bool PointerAnalysis::getOperandDelta(PSNode *node, unsigned idx,
+                                      PointsToSetT& delta)
+{
+    PSNode *op = getOperandRepr(node, idx);
+    std::vector<OperandCursor>& node_cursors = cursors[node];
+    // operands can be added during the analysis (function pointer calls)
+    if (node_cursors.size() <= idx)
+        node_cursors.resize(node->getOperandsNum());
+
+    OperandCursor& cur = node_cursors[idx];
+    if (cur.producer != op) {
+        // the first time or the operand was collapsed into another node,
+        // stop reading the old log and process the whole set
+        if (cur.producer) {
+            ProducerDelta& old = deltas[cur.producer];
+            --old.consumers;
+            if (cur.pos < old.end() && --old.behind == 0) {
+                old.base = old.end();
+                old.log.clear();
+            }
+        }
+
+        ProducerDelta& pd = deltas[op];
+        ++pd.consumers;
+        cur.producer = op;
+        cur.pos = pd.end();
+
+        delta = op->pointsTo;
+        return !delta.empty();
+    }
+
+    ProducerDelta& pd = deltas[op];
+    if (cur.pos == pd.end())
+        return false;
+
+    assert(cur.pos >= pd.base && "Lost a part of the log");
+    delta.insert(pd.log.begin() + (cur.pos - pd.base), pd.log.end());
+    cur.pos = pd.end();
+
+    // everybody has read the log
+    assert(pd.behind > 0);
+    if (--pd.behind == 0) {
+        pd.base = pd.end();
+        pd.log.clear();
+    }
+
+    return !delta.empty();
+}
+
+// append the pointers that were added to the node to its log,
+// if somebody reads it
+void PointerAnalysis::logNewPointers(PSNode *node, const PointsToSetT& added)
+{
+    auto it = deltas.find(node);
+    if (it == deltas.end() || it->second.consumers == 0)
+        return;
+
+    ProducerDelta& pd = it->second;
+    bool logged = false;
+    for (const Pointer& ptr : added) {
+        // the pointer may not have been added (e. g. it has
+        // an offset that is covered by an unknown offset)
+        if (node->pointsTo.count(ptr)) {
+            pd.log.push_back(ptr);
+            logged = true;
+        }
+    }
+
+    if (logged)
+        pd.behind = pd.consumers;
+}
+
+// forget the logs, the users of the nodes process whole
+// points-to sets the next time
+void PointerAnalysis::clearDeltas()
+{
+    deltas.clear();
+    cursors.clear();
+}
+
+// get the pointers of the operand that need to be processed -
+// all of them, or only the new ones with difference propagation
+const PointsToSetT& PointerAnalysis::getOperandPointsTo(PSNode *node,
+                                                        unsigned idx,
+                                                        PointsToSetT& delta)
+{
+    if (!diff_propagation)
+        return getOperandRepr(node, idx)->pointsTo;
+
+    getOperandDelta(node, idx, delta);
+    return delta;
+}
+
+// call record(ptr) for the pointers from @ptrs that are not in @S,
+// so that the pointers that are there already are not looked up
+// one by one when recording the updates of a thread
+template <typename RecordT>
+static bool recordNewPointers(const PointsToSetT& S, const PointsToSetT& ptrs,
+                              RecordT record)
+{
+    bool changed = false;
+#ifdef ENABLE_SPARSE_PTSETS
+    // cheap word-level check
+    if (ptrs.isSubsetOf(S))
+        return false;
+
+    for (const Pointer& ptr : ptrs)
+        changed |= record(ptr);
+#else
+    // both the sets are sorted, find the new pointers in one pass
+    auto it = S.begin();
+    for (const Pointer& ptr : ptrs) {
+        while (it != S.end() && *it < ptr)
+            ++it;
+
+        if (it != S.end() && *it == ptr)
+            continue;
+
+        changed |= record(ptr);
+    }
+#endif
+
+    return changed;
+}
+
+bool PointerAnalysis::addPointsTo(PSNode *node, const Pointer& ptr)
+{
+    if (!round_updates) {
+        bool changed = saturate_unknown ? addSaturated(node, ptr)
+                                        : node->addPointsTo(ptr);
+        if (changed && diff_propagation) {
+            PointsToSetT added;
+            added.insert(ptr);
+            logNewPointers(node, added);
+        }
+
+        return changed;
+    }
+
+    // would the pointer change the points-to set?
+    // (see PSNode::addPointsTo())
+    if ((isTop(node) && !isFunctionPointer(ptr))
+        || node->pointsTo.count(Pointer(ptr.target, UNKNOWN_OFFSET))
+        || node->pointsTo.count(ptr))
+        return false;
+
+    round_updates->pointers[getShard(node)].emplace_back(node, ptr);
+    return true;
+}
+
+bool PointerAnalysis::addPointsTo(PSNode *node, const PointsToSetT& ptrs)
+{
+    if (!round_updates) {
+        if (!diff_propagation || deltas.count(node) == 0)
+            return saturate_unknown ? addSaturated(node, ptrs)
+                                    : node->addPointsTo(ptrs);
+
+        // the pointers that are not in the set yet go to the log
+        PointsToSetT added;
+#ifdef ENABLE_SPARSE_PTSETS
+        added = ptrs;
+        added.remove(node->pointsTo);
+#else
+        std::set_difference(ptrs.begin(), ptrs.end(),
+                            node->pointsTo.begin(), node->pointsTo.end(),
+                            std::inserter(added, added.end()));
+#endif
+        if (added.empty())
+            return false;
+
+        bool changed = saturate_unknown ? addSaturated(node, added)
+                                        : node->addPointsTo(added);
+        if (changed)
+            logNewPointers(node, added);
+
+        return changed;
+    }
+
+    return recordNewPointers(node->pointsTo, ptrs,
+                             [this, node](const Pointer& ptr) {
+                                 return addPointsTo(node, ptr);
+                             });
+}
+
+bool PointerAnalysis::addPointsTo(MemoryObject *o, const Offset& off,
+                                  const Pointer& ptr)
+{
+    if (!round_updates)
+        return saturate_unknown ? addSaturated(o, off, ptr)
+                                : o->addPointsTo(off, ptr);
+
+    if (saturate_unknown && o->isTop() && !isFunctionPointer(ptr))
+        return false;
+
+    auto it = o->pointsTo.find(off);
+    if (it != o->pointsTo.end()
+        && ((saturate_unknown && isTopSet(it->second)
+             && !isFunctionPointer(ptr))
+            || it->second.count(ptr)))
+        return false;
+
+    round_updates->memory[getShard(o)].emplace_back(o, off, ptr);
+    return true;
+}
+
+bool PointerAnalysis::addPointsTo(MemoryObject *o, const Offset& off,
+                                  const PointsToSetT& ptrs)
+{
+    if (!round_updates)
+        return saturate_unknown ? addSaturated(o, off, ptrs)
+                                : o->addPointsTo(off, ptrs);
+
+    auto it = o->pointsTo.find(off);
+    if (it == o->pointsTo.end()) {
+        bool changed = false;
+        for (const Pointer& ptr : ptrs)
+            changed |= addPointsTo(o, off, ptr);
+
+        return changed;
+    }
+
+    return recordNewPointers(it->second, ptrs,
+                             [this, o, &off](const Pointer& ptr) {
+                                 return addPointsTo(o, off, ptr);
+                             });
+}
+
+// the pointers to all the functions in the subgraph
+const PointsToSetT& PointerAnalysis::getFunctionPointers()
+{
+    if (!function_pointers_valid) {
+        function_pointers.clear();
+        for (PSNode *n : PS->getNodes(PS->getRoot())) {
+            if (n->getType() == FUNCTION)
+                function_pointers.insert(Pointer(n, 0));
+        }
+
+        function_pointers_valid = true;
+    }
+
+    return function_pointers;
+}
+
+// the node may have any pointer - the unknown pointer
+// and the pointer to any function
+bool PointerAnalysis::addTopPointsTo(PSNode *node)
+{
+    bool changed = addPointsTo(node, PointerUnknown);
+    changed |= addPointsTo(node, getFunctionPointers());
+    return changed;
+}
+
+bool PointerAnalysis::addTopPointsTo(MemoryObject *o)
+{
+    bool changed = addPointsTo(o, UNKNOWN_OFFSET, PointerUnknown);
+    changed |= addPointsTo(o, UNKNOWN_OFFSET, getFunctionPointers());
+    return changed;
+}
+
+void PointerAnalysis::setZeroInitialized(PSNode *node)
+{
+    if (round_updates)
+        round_updates->zero_initialized.push_back(node);
+    else
+        node->setZeroInitialized();
+}
+
+// the hooks are called at the end of the round in the parallel solving,
+// so the value returned from the hook is not seen by the node processing,
+// but it still enqueues the node
+bool PointerAnalysis::reportError(PSNode *at, const char *msg)
+{
+    if (!round_updates)
+        return error(at, msg);
+
+    round_updates->errors.emplace_back(round_updates->current, at, msg);
+    return false;
+}
+
+bool PointerAnalysis::reportEmptyPointsTo(PSNode *from, PSNode *to)
+{
+    if (!round_updates)
+        return errorEmptyPointsTo(from, to);
+
+    round_updates->empty_points_to.emplace_back(from, to);
+    return false;
+}
+
+void PointerAnalysis::callFunctionPointer(PSNode *where, PSNode *what)
+{
+    if (round_updates) {
+        round_updates->funcptr_calls.emplace_back(where, what);
+        return;
+    }
+
+    if (functionPointerCall(where, what)) {
+        ps_changed = true;
+        // new copy edges and functions may have been added
+        copy_users_valid = false;
+        function_pointers_valid = false;
+        // the call may have added pointers to the nodes
+        // directly (e. g. unknown pointer to the return value)
+        clearDeltas();
+        PS->structureChanged();
+    }
+}
+
 bool PointerAnalysis::processLoad(PSNode *node)
 {
     bool changed = false;
-    PSNode *operand = node->getOperand(0);
+    PSNode *operand = getOperandRepr(node, 0);
 
     if (operand->pointsTo.empty())
-        return error(operand, "Load's operand has no points-to set");
+        return reportError(operand, "Load's operand has no points-to set");
+
+    // load via the pointer that may point anywhere
+    // may yield any pointer, there's nothing more to do
+    if (isTop(operand))
+        return addTopPointsTo(node);
 
+    bool has_memory = false;
     for (const Pointer& ptr : operand->pointsTo) {
         if (ptr.isNull())
             continue;
 
+        has_memory = true;
+
         // find memory objects holding relevant points-to
         // information
         std::vector<MemoryObject *> objects;
@@ -61,9 +533,9 @@ bool PointerAnalysis::processLoad(PSNode *node)
             if (ptr.target->isZeroInitialized())
                 // if the memory is zero initialized, then everything
                 // is fine, we add nullptr
-                changed |= node->addPointsTo(NULLPTR);
+                changed |= addPointsTo(node, PointerNull);
             else
-                changed |= errorEmptyPointsTo(node, ptr.target);
+                changed |= reportEmptyPointsTo(node, ptr.target);
 
             continue;
         }
@@ -78,55 +550,141 @@ bool PointerAnalysis::processLoad(PSNode *node)
                 // FIXME: don't duplicate the code
                 if (o->pointsTo.empty()) {
                     if (ptr.target->isZeroInitialized())
-                        changed |= node->addPointsTo(NULLPTR);
+                        changed |= addPointsTo(node, PointerNull);
                     else if (objects.size() == 1)
-                        changed |= errorEmptyPointsTo(node, ptr.target);
+                        changed |= reportEmptyPointsTo(node, ptr.target);
                 }
 
                 // we have some pointers - copy them all,
                 // since the offset is unknown
-                for (auto& it : o->pointsTo) {
-                    for (const Pointer &p : it.second) {
-                        changed |= node->addPointsTo(p);
-                    }
-                }
+                for (auto& it : o->pointsTo)
+                    changed |= addPointsTo(node, it.second);
 
                 // this is all that we can do here...
                 continue;
             }
 
+            const PointsToSetT *exact;
+            bool aliased = false;
+            if (ptr.offset.isConcrete() && !o->pointsTo.hasStrided()) {
+                // the common case - only the pointers at the offset
+                // and at UNKNOWN_OFFSET (these can be what we need too)
+                // may be loaded, get both with one search
+                auto sets = o->pointsTo.getWithUnknown(ptr.offset);
+                exact = sets.first;
+                if (sets.second) {
+                    aliased = true;
+                    changed |= addPointsTo(node, *sets.second);
+                }
+            } else {
+                // add the pointers stored at the offsets that may be
+                // the same as the offset of the pointer: for concrete
+                // offset these are the strided offsets and UNKNOWN_OFFSET,
+                // which are greater than the concrete offsets.
+                // For strided offset these may be also the concrete offsets
+                exact = o->pointsTo.get(ptr.offset);
+                auto it = ptr.offset.isConcrete()
+                            ? o->pointsTo.lower_bound(Offset(Offset::STRIDED_FLAG))
+                            : o->pointsTo.begin();
+                for (; it != o->pointsTo.end(); ++it) {
+                    if (it->first == ptr.offset
+                        || !it->first.mayAlias(ptr.offset))
+                        continue;
+
+                    aliased = true;
+                    changed |= addPointsTo(node, it->second);
+                }
+            }
+
             // load from empty points-to set
             // - that is load from unknown memory
-            if (!o->pointsTo.count(ptr.offset)) {
+            if (!exact) {
                 // if the memory is zero initialized, then everything
                 // is fine, we add nullptr
                 if (ptr.target->isZeroInitialized())
-                    changed |= node->addPointsTo(NULLPTR);
-                // if we don't have a definition even with unknown offset
-                // it is an error
+                    changed |= addPointsTo(node, PointerNull);
+                // if we don't have a definition even with other offset
+                // that may be the same, it is an error
                 // FIXME: don't triplicate the code!
-                else if (!o->pointsTo.count(UNKNOWN_OFFSET))
-                    changed |= errorEmptyPointsTo(node, ptr.target);
+                else if (!aliased)
+                    changed |= reportEmptyPointsTo(node, ptr.target);
             } else {
                 // we have pointers on that memory, so we can
                 // do the work
-                for (const Pointer& memptr : o->pointsTo[ptr.offset])
-                    changed |= node->addPointsTo(memptr);
+                changed |= addPointsTo(node, *exact);
             }
+        }
+    }
 
-            // plus always add the pointers at unknown offset,
-            // since these can be what we need too
-            if (o->pointsTo.count(UNKNOWN_OFFSET)) {
-                for (const Pointer& memptr : o->pointsTo[UNKNOWN_OFFSET]) {
-                    changed |= node->addPointsTo(memptr);
-                }
-            }
+    if (has_memory && saturate_unknown)
+        changed |= loadStoredViaUnknown(node);
+
+    return changed;
+}
+
+// the pointers stored via a pointer to unknown memory may be stored
+// anywhere, so every load from memory may read them
+bool PointerAnalysis::loadStoredViaUnknown(PSNode *node)
+{
+    bool changed = false;
+    std::vector<MemoryObject *> objects;
+    getMemoryObjects(node, PointerUnknown, objects);
+    for (MemoryObject *o : objects) {
+        for (auto& it : o->pointsTo) {
+            for (const Pointer& p : it.second)
+                changed |= addPointsTo(node, p);
         }
     }
 
     return changed;
 }
 
+bool PointerAnalysis::processStore(PSNode *node)
+{
+    bool changed = false;
+    std::vector<MemoryObject *> objects;
+    PSNode *valNode = getOperandRepr(node, 0);
+    PSNode *ptrNode = getOperandRepr(node, 1);
+
+    // If the memory objects for a pointer never change, it is enough
+    // to store the new values to the old pointers and all values
+    // to the new pointers. Otherwise we must store everything again,
+    // since the pointers can have new memory objects
+    bool diff = diff_propagation && hasStableMemoryObjects();
+    PointsToSetT newValues, newPointers;
+    if (diff) {
+        getOperandDelta(node, 0, newValues);
+        getOperandDelta(node, 1, newPointers);
+
+        // nothing new to store
+        if (newValues.empty() && newPointers.empty())
+            return false;
+    }
+
+    // with no new values, only the new pointers are interesting
+    const PointsToSetT& pointers
+        = (diff && newValues.empty()) ? newPointers : ptrNode->pointsTo;
+
+    for (const Pointer& ptr : pointers) {
+        assert(ptr.target && "Got nullptr as target");
+
+        if (ptr.isNull())
+            continue;
+
+        const PointsToSetT& values
+            = (!diff || newPointers.count(ptr)) ? valNode->pointsTo : newValues;
+        if (values.empty())
+            continue;
+
+        objects.clear();
+        getMemoryObjects(node, ptr, objects);
+        for (MemoryObject *o : objects)
+            changed |= addPointsTo(o, ptr.offset, values);
+    }
+
+    return changed;
+}
+
 bool PointerAnalysis::processMemcpy(PSNode *node)
 {
     bool changed = false;
@@ -143,37 +701,53 @@ bool PointerAnalysis::processMemcpy(PSNode *node)
     if ((!destNode->isZeroInitialized() && srcNode->isZeroInitialized())
         && ((*node->offset == 0 && node->len.isUnknown())
             || node->offset.isUnknown())) {
-        destNode->setZeroInitialized();
+        setZeroInitialized(destNode);
         changed = true;
     }
 
-    // gather srcNode pointer objects
-    for (const Pointer& ptr : srcNode->pointsTo) {
-        assert(ptr.target && "Got nullptr as target");
+    // gather destNode objects
+    for (const Pointer& dptr : getOperandRepr(node, 1)->pointsTo) {
+        assert(dptr.target && "Got nullptr as target");
 
-        if (ptr.isNull())
+        if (dptr.isNull())
             continue;
 
-        getMemoryObjects(node, ptr, srcObjects);
+        getMemoryObjects(node, dptr, destObjects);
     }
 
-    // gather destNode objects
-    for (const Pointer& dptr : destNode->pointsTo) {
-        assert(dptr.target && "Got nullptr as target");
+    // copying from memory that may be anywhere
+    // may copy any pointer to anywhere
+    if (isTop(getOperandRepr(node, 0))) {
+        for (MemoryObject *o : destObjects)
+            changed |= addTopPointsTo(o);
 
-        if (dptr.isNull())
+        return changed;
+    }
+
+    // gather srcNode pointer objects
+    bool has_memory = false;
+    for (const Pointer& ptr : getOperandRepr(node, 0)->pointsTo) {
+        assert(ptr.target && "Got nullptr as target");
+
+        if (ptr.isNull())
             continue;
 
-        getMemoryObjects(node, dptr, destObjects);
+        getMemoryObjects(node, ptr, srcObjects);
+        has_memory = true;
     }
 
+    // the memory may contain also the pointers
+    // stored via a pointer to unknown memory
+    if (has_memory && saturate_unknown && !srcObjects.empty())
+        getMemoryObjects(node, PointerUnknown, srcObjects);
+
     if (srcObjects.empty()){
         if (srcNode->isZeroInitialized()) {
             // if the memory is zero initialized,
             // then everything is fine, we add nullptr
-            changed |= node->addPointsTo(NULLPTR);
+            changed |= addPointsTo(node, PointerNull);
         } else {
-            changed |= errorEmptyPointsTo(node, srcNode);
+            changed |= reportEmptyPointsTo(node, srcNode);
         }
 
         return changed;
@@ -183,12 +757,22 @@ bool PointerAnalysis::processMemcpy(PSNode *node)
         // copy every pointer from srcObjects that is in
         // the range to these objects
         for (MemoryObject *so : srcObjects) {
-            for (auto& src : so->pointsTo) {
+            // adding new offsets invalidates the iterators of the map,
+            // so copy the map if we copy to the same object. In the
+            // parallel solving the changes are only recorded, so there
+            // is no need to copy (and the threads must not copy the sets,
+            // the shared sets are reference counted without locking)
+            PointsToMapT same;
+            if (so == o && !round_updates)
+                same = so->pointsTo;
+
+            for (auto& src : so == o && !round_updates ? same : so->pointsTo) {
                 // src.first is offset, src.second is a PointToSet
 
                 // we need to copy ptrs at UNKNOWN_OFFSET always
-                if (src.first.isUnknown() || node->offset.isUnknown()) {
-                    changed |= o->addPointsTo(src.first, src.second);
+                // (and at strided offsets, these may be in the range)
+                if (!src.first.isConcrete() || node->offset.isUnknown()) {
+                    changed |= addPointsTo(o, src.first, src.second);
                     continue;
                 }
 
@@ -201,7 +785,7 @@ bool PointerAnalysis::processMemcpy(PSNode *node)
                     continue;
                 }
 
-                changed |= o->addPointsTo(src.first, src.second);
+                changed |= addPointsTo(o, src.first, src.second);
             }
         }
 
@@ -222,7 +806,7 @@ bool PointerAnalysis::processMemcpy(PSNode *node)
             && !((*node->offset == 0 && node->len.isUnknown())
                  || node->offset.isUnknown()))
             // src is zeroed and we don't copy whole memory?
-            changed |= o->addPointsTo(UNKNOWN_OFFSET, NULLPTR);
+            changed |= addPointsTo(o, UNKNOWN_OFFSET, PointerNull);
     }
 
     return changed;
@@ -231,7 +815,8 @@ bool PointerAnalysis::processMemcpy(PSNode *node)
 bool PointerAnalysis::processNode(PSNode *node)
 {
     bool changed = false;
-    std::vector<MemoryObject *> objects;
+    // the new pointers of operands with difference propagation
+    PointsToSetT delta;
 
 #ifdef DEBUG_ENABLED
     size_t prev_size = node->pointsTo.size();
@@ -242,44 +827,36 @@ bool PointerAnalysis::processNode(PSNode *node)
             changed |= processLoad(node);
             break;
         case STORE:
-            for (const Pointer& ptr : node->getOperand(1)->pointsTo) {
-                PSNode *target = ptr.target;
-                assert(target && "Got nullptr as target");
-
-                if (ptr.isNull())
-                    continue;
-
-                objects.clear();
-                getMemoryObjects(node, ptr, objects);
-                for (MemoryObject *o : objects) {
-                    for (const Pointer& to : node->getOperand(0)->pointsTo)
-                        changed |= o->addPointsTo(ptr.offset, to);
-                }
-            }
+            changed |= processStore(node);
             break;
         case GEP:
-            for (const Pointer& ptr : node->getOperand(0)->pointsTo) {
-                uint64_t new_offset;
-                if (ptr.offset.isUnknown() || node->offset.isUnknown())
-                    // set it like this to avoid overflow when adding
-                    new_offset = UNKNOWN_OFFSET;
-                else
-                    new_offset = *ptr.offset + *node->offset;
+            for (const Pointer& ptr : getOperandPointsTo(node, 0, delta)) {
+                Offset new_offset = ptr.offset + node->offset;
 
                 // in the case the memory has size 0, then every pointer
                 // will have unknown offset with the exception that it points
-                // to the begining of the memory - therefore make 0 exception
-                if ((new_offset == 0 || new_offset < ptr.target->getSize())
-                    && new_offset < max_offset)
-                    changed |= node->addPointsTo(ptr.target, new_offset);
+                // to the begining of the memory - therefore make 0 exception.
+                // Strided offset is kept if its base is in the memory,
+                // there is only a bounded number of such offsets
+                // for the given stride
+                if (new_offset.isStrided()) {
+                    uint64_t base = new_offset.getBase();
+                    if ((ptr.target->getSize() == 0
+                         || base < ptr.target->getSize())
+                        && base < max_offset)
+                        changed |= addPointsTo(node, Pointer(ptr.target, new_offset));
+                    else
+                        changed |= addPointsTo(node, Pointer(ptr.target, UNKNOWN_OFFSET));
+                } else if ((*new_offset == 0 || *new_offset < ptr.target->getSize())
+                    && *new_offset < max_offset)
+                    changed |= addPointsTo(node, Pointer(ptr.target, new_offset));
                 else
-                    changed |= node->addPointsToUnknownOffset(ptr.target);
+                    changed |= addPointsTo(node, Pointer(ptr.target, UNKNOWN_OFFSET));
             }
             break;
         case CAST:
             // cast only copies the pointers
-            for (const Pointer& ptr : node->getOperand(0)->pointsTo)
-                changed |= node->addPointsTo(ptr);
+            changed |= processCopy(node, 0, delta);
             break;
         case CONSTANT:
             // maybe warn? It has no sense to insert the constants into the graph.
@@ -293,22 +870,24 @@ bool PointerAnalysis::processNode(PSNode *node)
             // gather pointers returned from subprocedure - the same way
             // as PHI works
         case PHI:
-            for (PSNode *op : node->operands)
-                changed |= node->addPointsTo(op->pointsTo);
+            for (unsigned i = 0; i < node->getOperandsNum(); ++i) {
+                delta.clear();
+                changed |= processCopy(node, i, delta);
+            }
             break;
         case CALL_FUNCPTR:
             // call via function pointer:
             // first gather the pointers that can be used to the
             // call and if something changes, let backend take some action
             // (for example build relevant subgraph)
-            for (const Pointer& ptr : node->getOperand(0)->pointsTo) {
-                if (node->addPointsTo(ptr)) {
+            for (const Pointer& ptr : getOperandPointsTo(node, 0, delta)) {
+                if (addPointsTo(node, ptr)) {
                     changed = true;
 
                     if (ptr.isValid()) {
-                        functionPointerCall(node, ptr.target);
+                        callFunctionPointer(node, ptr.target);
                     } else {
-                        error(node, "Calling invalid pointer as a function!");
+                        reportError(node, "Calling invalid pointer as a function!");
                         continue;
                     }
                 }
@@ -344,6 +923,786 @@ bool PointerAnalysis::processNode(PSNode *node)
     return changed;
 }
 
+// copy the pointers of the idx-th operand to the node (or to its
+// representative with cycle detection) and if the node and
+// the operand have the same points-to sets afterwards,
+// look whether they lie on a cycle
+bool PointerAnalysis::processCopy(PSNode *node, unsigned idx,
+                                  PointsToSetT& delta)
+{
+    if (!cycle_detection)
+        return addPointsTo(node, getOperandPointsTo(node, idx, delta));
+
+    PSNode *rep = representatives.find(node);
+    PSNode *op = getOperandRepr(node, idx);
+    // the operand was collapsed together with this node
+    if (op == rep)
+        return false;
+
+    bool changed = addPointsTo(rep, getOperandPointsTo(node, idx, delta));
+
+    // the same points-to sets are a hint that the nodes may lie
+    // on a cycle. Search for each edge only once, otherwise we
+    // would be searching repeatedly for cycles that are not there
+    if (!rep->pointsTo.empty() && rep->pointsTo == op->pointsTo
+        && checked_edges.insert(std::make_pair(op, rep)).second)
+        changed |= collapseCycle(op, rep);
+
+    return changed;
+}
+
+// can the node be collapsed with other nodes?
+// Only nodes that just copy the pointers from their operands can be.
+bool PointerAnalysis::isCollapsible(PSNode *n) const
+{
+    switch (n->getType()) {
+        case CAST:
+        case PHI:
+        case RETURN:
+        case CALL_RETURN:
+            return not_collapsible.count(n) == 0;
+        default:
+            return false;
+    }
+}
+
+void PointerAnalysis::buildCopyUsers()
+{
+    copy_users.clear();
+    not_collapsible.clear();
+
+    const auto nodes = PS->getNodes(PS->getRoot());
+
+    // the backend changes the points-to sets of the nodes
+    // paired with calls via function pointers
+    for (PSNode *n : nodes) {
+        if (n->getType() == CALL_FUNCPTR && n->getPairedNode())
+            not_collapsible.insert(n->getPairedNode());
+    }
+
+    for (PSNode *n : nodes) {
+        if (!isCollapsible(n))
+            continue;
+
+        // the operands may have been substituted by equivalent nodes
+        for (unsigned i = 0; i < n->getOperandsNum(); ++i) {
+            PSNode *op = getOperandRepr(n, i);
+            if (isCollapsible(op))
+                copy_users[op].push_back(n);
+        }
+    }
+
+    copy_users_valid = true;
+}
+
+// get all nodes represented by the given representative
+void PointerAnalysis::getCollapsed(PSNode *rep, std::vector<PSNode *>& nodes)
+{
+    auto it = collapsed.find(rep);
+    if (it == collapsed.end())
+        nodes.push_back(rep);
+    else
+        nodes.insert(nodes.end(), it->second.begin(), it->second.end());
+}
+
+// Search for the cycle of copy edges op -> node -> ... -> op
+// (where the nodes are already collapsed nodes represented by
+// @op and @node) and collapse all the nodes on it.
+// The nodes on such cycles are the nodes that are reachable from
+// @node and from which @node is reachable. Return true if some
+// nodes were collapsed.
+bool PointerAnalysis::collapseCycle(PSNode *op, PSNode *node)
+{
+    if (!copy_users_valid)
+        buildCopyUsers();
+
+    if (!isCollapsible(op) || !isCollapsible(node))
+        return false;
+
+    std::vector<PSNode *> members;
+
+    // the representatives reachable from @node via copy edges
+    std::set<PSNode *> reachable;
+    std::vector<PSNode *> stack;
+    reachable.insert(node);
+    stack.push_back(node);
+    while (!stack.empty()) {
+        PSNode *cur = stack.back();
+        stack.pop_back();
+
+        members.clear();
+        getCollapsed(cur, members);
+        for (PSNode *m : members) {
+            for (PSNode *user : copy_users[m]) {
+                PSNode *r = representatives.find(user);
+                if (reachable.insert(r).second)
+                    stack.push_back(r);
+            }
+        }
+    }
+
+    if (reachable.count(op) == 0)
+        return false;
+
+    // the representatives that reach @node and are reachable from it
+    std::set<PSNode *> cycle;
+    cycle.insert(node);
+    stack.push_back(node);
+    while (!stack.empty()) {
+        PSNode *cur = stack.back();
+        stack.pop_back();
+
+        members.clear();
+        getCollapsed(cur, members);
+        for (PSNode *m : members) {
+            if (!isCollapsible(m))
+                continue;
+
+            for (unsigned i = 0; i < m->getOperandsNum(); ++i) {
+                PSNode *r = representatives.find(m->getOperand(i));
+                if (reachable.count(r) > 0 && cycle.insert(r).second)
+                    stack.push_back(r);
+            }
+        }
+    }
+
+    assert(cycle.size() > 1 && cycle.count(op) > 0);
+
+    // collapse the nodes into one and merge their points-to sets
+    // into the new representative
+    PSNode *rep = node;
+    for (PSNode *r : cycle)
+        rep = representatives.unite(rep, r);
+
+    std::vector<PSNode *>& rep_members = collapsed[rep];
+    if (rep_members.empty())
+        rep_members.push_back(rep);
+
+    for (PSNode *r : cycle) {
+        if (r == rep)
+            continue;
+
+        // through addPointsTo(), so that the users of rep
+        // get the pointers of r
+        addPointsTo(rep, r->pointsTo);
+        r->pointsTo.clear();
+
+        auto it = collapsed.find(r);
+        if (it == collapsed.end()) {
+            rep_members.push_back(r);
+            ++collapsed_nodes_num;
+        } else {
+            collapsed_nodes_num += it->second.size();
+            rep_members.insert(rep_members.end(),
+                               it->second.begin(), it->second.end());
+            collapsed.erase(it);
+        }
+    }
+
+    return true;
+}
+
+// the collapsed nodes share the points-to set of their representative,
+// copy it to the nodes so that the results look like without collapsing
+void PointerAnalysis::propagateToCollapsedNodes()
+{
+    for (auto& it : collapsed) {
+        for (PSNode *n : it.second) {
+            if (n != it.first)
+                n->pointsTo = it.first->pointsTo;
+        }
+    }
+
+    for (PSNode *n : substituted)
+        n->pointsTo = representatives.find(n)->pointsTo;
+}
+
+// find nodes that have the same points-to set as some other node
+// and remove them from the graph (see merge_equivalent)
+void PointerAnalysis::substituteEquivalentNodes()
+{
+    PSNode *root = PS->getRoot();
+    std::vector<PSNode *> nodes = PS->getNodes(root);
+
+    // calls via function pointers add operands to PHI nodes (arguments
+    // of functions and return sites) during the analysis,
+    // so with them we cannot say that a PHI has a single operand
+    bool phis_may_change = false;
+    for (PSNode *n : nodes) {
+        if (n->getType() == CALL_FUNCPTR) {
+            phis_may_change = true;
+            break;
+        }
+    }
+
+    // value numbers of GEPs - (operand, offset) -> GEP
+    std::map<std::pair<PSNode *, uint64_t>, PSNode *> geps;
+    std::set<PSNode *> removed;
+
+    // merging some nodes may make other nodes equivalent
+    // (e. g. PHI whose operands were merged), so iterate
+    bool changed;
+    do {
+        changed = false;
+        geps.clear();
+
+        for (PSNode *n : nodes) {
+            // the backend may attach new parts of graph to paired nodes
+            if (n == root || n->getPairedNode() || removed.count(n) > 0)
+                continue;
+
+            PSNode *equiv = nullptr;
+            switch (n->getType()) {
+                case CAST:
+                    equiv = getOperandRepr(n, 0);
+                    break;
+                case PHI:
+                case RETURN:
+                case CALL_RETURN:
+                    if (phis_may_change || n->getOperandsNum() == 0)
+                        break;
+
+                    equiv = getOperandRepr(n, 0);
+                    for (unsigned i = 1; i < n->getOperandsNum(); ++i) {
+                        if (getOperandRepr(n, i) != equiv) {
+                            equiv = nullptr;
+                            break;
+                        }
+                    }
+                    break;
+                case GEP: {
+                    auto key = std::make_pair(getOperandRepr(n, 0), *n->offset);
+                    auto it = geps.find(key);
+                    if (it == geps.end())
+                        geps.emplace(key, n);
+                    else
+                        equiv = it->second;
+                    } break;
+                default:
+                    break;
+            }
+
+            // the node can be its own operand (e. g. PHI in a loop)
+            if (!equiv || equiv == n)
+                continue;
+
+            representatives.merge(n, equiv);
+            removed.insert(n);
+            substituted.push_back(n);
+            n->isolate();
+            changed = true;
+        }
+    } while (changed);
+
+    if (!removed.empty())
+        PS->structureChanged();
+}
+
+bool PointerAnalysis::checkAliasClassesOptions() const
+{
+    if (!saturate_unknown && !cycle_detection && !merge_equivalent)
+        return true;
+
+    fprintf(stderr, "WARNING: pointer analysis: the saturation, the cycle "
+                    "detection and merging equivalent nodes do not work "
+                    "with the alias classes, solving all the nodes together\n");
+    return false;
+}
+
+// Split the nodes into groups by the alias classes of Steensgaard's
+// analysis. The pointers of a node depend only on the nodes in the same
+// class and on the pointers to the memory that they are loaded from
+// (stored to), which are in the class that has the class of the node
+// as its pointee. Every class has at most one pointee, so the classes
+// are ordered topologically along the pointees and the classes
+// on a cycle of pointees go into one group
+void PointerAnalysis::computeAliasGroups(const std::vector<PSNode *>& nodes,
+                                         std::vector<std::vector<PSNode *> >& groups)
+{
+    SteensgaardClasses classes;
+    for (PSNode *n : nodes)
+        classes.unify(n);
+
+    // STORE and MEMCPY compute the pointers stored in the memory
+    std::unordered_map<unsigned, std::vector<PSNode *> > members;
+    for (PSNode *n : nodes) {
+        unsigned c;
+        if (n->getType() == STORE || n->getType() == MEMCPY)
+            c = classes.getPointee(classes.getId(n->getOperand(1)));
+        else
+            c = classes.getId(n);
+
+        members[classes.find(c)].push_back(n);
+    }
+
+    auto getPointee = [&classes](unsigned c) -> unsigned {
+        unsigned p = classes.getStored(c);
+        return p == SteensgaardClasses::NONE ? p : classes.find(p);
+    };
+
+    // the classes without nodes can be on the way between the others
+    std::unordered_map<unsigned, unsigned> indegree;
+    for (auto& it : members) {
+        unsigned c = it.first;
+        while (indegree.emplace(c, 0).second) {
+            c = getPointee(c);
+            if (c == SteensgaardClasses::NONE)
+                break;
+        }
+    }
+
+    for (auto& it : indegree) {
+        unsigned p = getPointee(it.first);
+        if (p != SteensgaardClasses::NONE)
+            ++indegree[p];
+    }
+
+    auto addGroup = [&members, &groups](unsigned c) {
+        auto it = members.find(c);
+        if (it == members.end())
+            return;
+
+        groups.emplace_back(std::move(it->second));
+        members.erase(it);
+    };
+
+    std::vector<unsigned> ready;
+    for (auto& it : indegree) {
+        if (it.second == 0)
+            ready.push_back(it.first);
+    }
+
+    while (!ready.empty()) {
+        unsigned c = ready.back();
+        ready.pop_back();
+        addGroup(c);
+
+        unsigned p = getPointee(c);
+        if (p != SteensgaardClasses::NONE && --indegree[p] == 0)
+            ready.push_back(p);
+    }
+
+    // what is left are the cycles, nothing outside
+    // a cycle depends on the classes on it
+    std::unordered_map<PSNode *, size_t> order;
+    for (size_t i = 0; i < nodes.size(); ++i)
+        order.emplace(nodes[i], i);
+
+    while (!members.empty()) {
+        unsigned start = members.begin()->first;
+        std::vector<PSNode *> group;
+        unsigned c = start;
+        do {
+            auto it = members.find(c);
+            if (it != members.end()) {
+                group.insert(group.end(), it->second.begin(), it->second.end());
+                members.erase(it);
+            }
+
+            c = getPointee(c);
+            assert(c != SteensgaardClasses::NONE && "The class is not on a cycle");
+        } while (c != start);
+
+        // keep the order of the nodes in the subgraph
+        std::sort(group.begin(), group.end(),
+                  [&order](PSNode *a, PSNode *b) { return order[a] < order[b]; });
+        groups.push_back(std::move(group));
+    }
+}
+
+// process the nodes of the group in rounds as runRounds() does,
+// but only the nodes of the group. Returns false if the PointerSubgraph
+// changed (then the groups are not valid anymore)
+bool PointerAnalysis::solveAliasGroup(const std::vector<PSNode *>& group)
+{
+    std::set<PSNode *> in_group(group.begin(), group.end());
+
+    to_process = group;
+    do {
+        unsigned last_processed_num = to_process.size();
+        changed.clear();
+
+        for (PSNode *cur : to_process)
+            processWithHooks(cur);
+
+        if (ps_changed)
+            return false;
+
+        if (!changed.empty()) {
+            std::vector<PSNode *> reachable
+                = PS->getNodes(nullptr /* starting node */,
+                               &changed /* starting set */,
+                               last_processed_num /* expected num */);
+            to_process.clear();
+            for (PSNode *n : reachable) {
+                if (in_group.count(n) > 0)
+                    to_process.push_back(n);
+            }
+        }
+    } while (!changed.empty() && !to_process.empty());
+
+    return true;
+}
+
+// Solve the groups of nodes with different alias classes one after
+// another (see computeAliasGroups()), so that the rounds go only over
+// the nodes whose pointers may change. A group is solved when the groups
+// that it depends on are solved, so it is processed only once.
+// New subgraphs (calls via function pointers) change the classes,
+// the groups are then computed again and solved from the current state
+void PointerAnalysis::runAliasClasses()
+{
+    bool done;
+    do {
+        std::vector<std::vector<PSNode *> > groups;
+        computeAliasGroups(PS->getNodes(PS->getRoot()), groups);
+
+        done = true;
+        ps_changed = false;
+        for (const std::vector<PSNode *>& group : groups) {
+            if (!solveAliasGroup(group)) {
+                done = false;
+                break;
+            }
+        }
+    } while (!done);
+}
+
+// compute the strongly connected components of the PointerSubgraph
+void PointerAnalysis::computeSCCs()
+{
+    PSNode *root = PS->getRoot();
+
+    // the nodes may have been numbered by the previous computation
+    for (PSNode *n : PS->getNodes(root)) {
+        n->dfs_id = n->lowpt = 0;
+        n->on_stack = false;
+    }
+
+    SCC<PSNode> scc_comp;
+    SCCs = std::move(scc_comp.compute(root));
+
+    // process the nodes in a component in the order in which
+    // they were found by the DFS, that is roughly the order
+    // of the control flow
+    for (auto& scc : SCCs) {
+        std::sort(scc.begin(), scc.end(),
+                  [](PSNode *a, PSNode *b) { return a->dfs_id < b->dfs_id; });
+    }
+}
+
+// iterate over the nodes of the component until nothing changes.
+// NOTE: even a single node without a self-loop must be processed again
+// when it changed, since the node may depend on itself outside of
+// the control flow - it can be its own operand (e. g. a PHI) or read
+// the memory that it just changed (e. g. MEMCPY within one object)
+void PointerAnalysis::processSCC(const std::vector<PSNode *>& scc)
+{
+    bool scc_changed;
+    do {
+        scc_changed = false;
+        // the hooks may enqueue the nodes whose state they changed
+        changed.clear();
+
+        for (PSNode *cur : scc) {
+            beforeProcessed(cur);
+
+            ++processed_nodes_num;
+            scc_changed |= processNode(cur);
+
+            afterProcessed(cur);
+
+            // the components are not valid anymore
+            if (ps_changed)
+                return;
+        }
+
+        scc_changed |= !changed.empty();
+    } while (scc_changed);
+}
+
+void PointerAnalysis::runSCCs()
+{
+    computeSCCs();
+
+    // the numbers of components that are waiting for processing.
+    // The scc_id gives a reverse topological order of the components,
+    // so we take the greatest number first
+    ADT::PrioritySet<unsigned, std::greater<unsigned> > worklist;
+    worklist.push(PS->getRoot()->getSCCId());
+
+    while (!worklist.empty()) {
+        unsigned idx = worklist.pop();
+
+        ps_changed = false;
+        processSCC(SCCs[idx]);
+
+        if (ps_changed) {
+            // new nodes were added to the PointerSubgraph,
+            // recompute the components and continue from the
+            // components that were waiting (or being processed).
+            // The edges may have been removed too, so the components
+            // may split - remember all their nodes
+            std::vector<PSNode *> pending = SCCs[idx];
+            while (!worklist.empty()) {
+                const std::vector<PSNode *>& scc = SCCs[worklist.pop()];
+                pending.insert(pending.end(), scc.begin(), scc.end());
+            }
+
+            computeSCCs();
+
+            for (PSNode *n : pending)
+                worklist.push(n->getSCCId());
+
+            continue;
+        }
+
+        // the memory (and thus points-to sets) can change even
+        // behind nodes whose points-to set did not change,
+        // so queue all the successors (as the BFS in run() does)
+        for (PSNode *n : SCCs[idx]) {
+            for (PSNode *succ : n->getSuccessors()) {
+                if (succ->getSCCId() != idx)
+                    worklist.push(succ->getSCCId());
+            }
+        }
+    }
+}
+
+// getMemoryObjects() may create the memory objects lazily,
+// create them before the threads start
+void PointerAnalysis::createMemoryObjects(const std::vector<PSNode *>& nodes)
+{
+    std::vector<MemoryObject *> objects;
+    getMemoryObjects(UNKNOWN_MEMORY, PointerUnknown, objects);
+
+    for (PSNode *n : nodes) {
+        if (n->getType() == ALLOC || n->getType() == DYN_ALLOC)
+            getMemoryObjects(n, Pointer(n, 0), objects);
+    }
+}
+
+// process the nodes in threads. The threads take the nodes
+// in chunks, so that a thread that got cheap nodes takes more of them.
+// Nothing is changed while processing, the changes are recorded
+// into the updates of the thread
+void PointerAnalysis::processInParallel(ADT::ThreadPool& pool,
+                                        const std::vector<PSNode *>& nodes,
+                                        std::vector<RoundUpdates>& updates)
+{
+    const size_t chunk = 64;
+    std::atomic<size_t> next(0);
+
+    pool.run([&](unsigned id) {
+        RoundUpdates& U = updates[id];
+        round_updates = &U;
+
+        size_t start;
+        while ((start = next.fetch_add(chunk)) < nodes.size()) {
+            size_t end = std::min(start + chunk, nodes.size());
+            for (size_t i = start; i < end; ++i) {
+                PSNode *cur = nodes[i];
+                U.current = cur;
+
+                beforeProcessed(cur);
+
+                ++U.processed_nodes_num;
+                if (processNode(cur))
+                    U.changed.push_back(cur);
+
+                afterProcessed(cur);
+            }
+        }
+
+        round_updates = nullptr;
+    });
+}
+
+// do the changes recorded by the threads. The points-to sets are
+// split among the threads (the threads recorded the changes into
+// the shards already), so that every set is changed by one thread.
+// The rest (the hooks) is done in this thread
+void PointerAnalysis::applyUpdates(ADT::ThreadPool& pool,
+                                   std::vector<RoundUpdates>& updates)
+{
+    auto apply = [&](unsigned id) {
+        // gather the updates of every set from all the threads,
+        // so that the set is changed only once
+        std::vector<std::pair<PSNode *, Pointer> >& pointers
+            = updates[0].pointers[id];
+        std::vector<RoundUpdates::MemoryUpdate>& memory
+            = updates[0].memory[id];
+        for (unsigned i = 1; i < updates.size(); ++i) {
+            pointers.insert(pointers.end(), updates[i].pointers[id].begin(),
+                            updates[i].pointers[id].end());
+            memory.insert(memory.end(), updates[i].memory[id].begin(),
+                          updates[i].memory[id].end());
+        }
+
+        std::sort(pointers.begin(), pointers.end(),
+                  [](const std::pair<PSNode *, Pointer>& a,
+                     const std::pair<PSNode *, Pointer>& b) {
+                      return a.first < b.first;
+                  });
+        std::sort(memory.begin(), memory.end(),
+                  [](const RoundUpdates::MemoryUpdate& a,
+                     const RoundUpdates::MemoryUpdate& b) {
+                      return a.object < b.object
+                             || (a.object == b.object && a.offset < b.offset);
+                  });
+
+        std::vector<Pointer> batch;
+        for (size_t i = 0; i < pointers.size();) {
+            PSNode *node = pointers[i].first;
+            batch.clear();
+            for (; i < pointers.size() && pointers[i].first == node; ++i)
+                batch.push_back(pointers[i].second);
+
+            PointsToSetT ptrs;
+            ptrs.insert(batch.begin(), batch.end());
+            if (saturate_unknown)
+                addSaturated(node, ptrs);
+            else
+                node->addPointsTo(ptrs);
+        }
+
+        for (size_t i = 0; i < memory.size();) {
+            MemoryObject *o = memory[i].object;
+            Offset off = memory[i].offset;
+            batch.clear();
+            for (; i < memory.size() && memory[i].object == o
+                   && memory[i].offset == off; ++i)
+                batch.push_back(memory[i].ptr);
+
+            PointsToSetT ptrs;
+            ptrs.insert(batch.begin(), batch.end());
+            if (saturate_unknown)
+                addSaturated(o, off, ptrs);
+            else
+                o->addPointsTo(off, ptrs);
+        }
+    };
+
+    if (shards_num > 1)
+        pool.run(apply);
+    else
+        apply(0);
+
+    for (RoundUpdates& U : updates) {
+        processed_nodes_num += U.processed_nodes_num;
+
+        for (PSNode *n : U.zero_initialized)
+            n->setZeroInitialized();
+
+        for (auto& it : U.empty_points_to) {
+            if (errorEmptyPointsTo(it.first, it.second))
+                enqueue(it.first);
+        }
+
+        for (RoundUpdates::Error& e : U.errors) {
+            if (error(e.at, e.msg))
+                enqueue(e.node);
+        }
+
+        for (auto& it : U.funcptr_calls)
+            callFunctionPointer(it.first, it.second);
+
+        for (PSNode *n : U.changed)
+            enqueue(n);
+    }
+}
+
+void PointerAnalysis::RoundUpdates::reset(unsigned shards)
+{
+    pointers.resize(shards);
+    for (auto& P : pointers)
+        P.clear();
+    memory.resize(shards);
+    for (auto& M : memory)
+        M.clear();
+
+    zero_initialized.clear();
+    empty_points_to.clear();
+    errors.clear();
+    funcptr_calls.clear();
+    changed.clear();
+    current = nullptr;
+    processed_nodes_num = 0;
+}
+
+// the difference propagation and the cycle detection change the shared
+// state while processing the nodes, they cannot be used with threads
+bool PointerAnalysis::checkParallelOptions() const
+{
+    if (!diff_propagation && !cycle_detection)
+        return true;
+
+    fprintf(stderr, "WARNING: pointer analysis: the difference propagation "
+                    "and the cycle detection do not work with more threads, "
+                    "solving in one thread\n");
+    return false;
+}
+
+// Parallel solving. Every round is processed in two phases - first
+// the threads process the nodes and record the changes that the nodes
+// do (all the threads see the state from the beginning of the round)
+// and then the changes are done. The changes only add pointers, so it
+// does not matter in which order they are done, the nodes just may
+// need more rounds to see the changes of other nodes.
+// The same threads are used for all the rounds and both the phases
+void PointerAnalysis::runParallel()
+{
+    assert(!diff_propagation && !cycle_detection);
+
+#ifdef ENABLE_SPARSE_PTSETS
+    // the bitvector-based sets share global tables
+    // that must not be changed from more threads
+    shards_num = 1;
+#else
+    shards_num = threads_num;
+#endif
+
+    // compress the paths in the representatives,
+    // so that the threads only search them
+    for (PSNode *n : substituted)
+        representatives.find(n);
+
+    to_process = PS->getNodes(PS->getRoot());
+    createMemoryObjects(to_process);
+    // the pointers to functions are gathered lazily too
+    if (saturate_unknown)
+        getFunctionPointers();
+
+    ADT::ThreadPool pool(threads_num);
+    std::vector<RoundUpdates> updates(threads_num);
+    do {
+        unsigned last_processed_num = to_process.size();
+        changed.clear();
+        ps_changed = false;
+
+        for (RoundUpdates& U : updates)
+            U.reset(shards_num);
+
+        processInParallel(pool, to_process, updates);
+        applyUpdates(pool, updates);
+
+        if (!changed.empty()) {
+            to_process.clear();
+            to_process = PS->getNodes(nullptr /* starting node */,
+                                      &changed /* starting set */,
+                                      last_processed_num /* expected num */);
+            assert(!to_process.empty());
+
+            // calls via function pointers may have added new nodes
+            if (ps_changed) {
+                createMemoryObjects(to_process);
+                if (saturate_unknown)
+                    getFunctionPointers();
+            }
+        }
+    } while (!changed.empty());
+}
+
 } // namespace pta
 } // namespace analysis
 } // namespace dg
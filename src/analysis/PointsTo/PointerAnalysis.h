@@ -2,11 +2,16 @@
 #define _DG_POINTER_ANALYSIS_H_
 
 #include <cassert>
+#include <cstdint>
 #include <vector>
+#include <set>
+#include <unordered_map>
 
 #include "Pointer.h"
 #include "PointerSubgraph.h"
 #include "ADT/Queue.h"
+#include "ADT/ThreadPool.h"
+#include "ADT/UnionFind.h"
 
 #include "analysis/SCC.h"
 
@@ -34,21 +39,215 @@ class PointerAnalysis
     // Flow sensitive flag (contol loop optimization execution)
     bool preprocess_geps;
 
+    // Difference propagation - process only the pointers that
+    // were added to the operands since the node was processed
+    // the last time instead of processing all of them again
+    bool diff_propagation;
+
+    // pointers added to a node that some of its users did not
+    // process yet (used with difference propagation).
+    // The users read the log from their position to the end
+    // and the log is cleared once all of them have read it,
+    // so a node keeps only what was added since its last propagation
+    struct ProducerDelta {
+        std::vector<Pointer> log;
+        // the position of log[0] in all the pointers ever logged
+        size_t base = 0;
+        // the number of operands that read the log
+        unsigned consumers = 0;
+        // the number of operands that did not read the whole log
+        unsigned behind = 0;
+
+        size_t end() const { return base + log.size(); }
+    };
+
+    // the position of an operand in the log of its producer
+    struct OperandCursor {
+        PSNode *producer = nullptr;
+        size_t pos = 0;
+    };
+
+    std::unordered_map<PSNode *, ProducerDelta> deltas;
+    std::unordered_map<PSNode *, std::vector<OperandCursor> > cursors;
+
+    // Process the strongly connected components of the PointerSubgraph
+    // in topological order and iterate to a local fixpoint inside every
+    // component instead of processing everything reachable from
+    // the changed nodes in every round
+    bool scc_scheduling;
+
+    // Solve the nodes grouped by the alias classes of Steensgaard's
+    // analysis (see runAliasClasses()). Only for analyses with stable
+    // memory objects (flow-insensitive)
+    bool alias_classes;
+
+    // set when the PointerSubgraph changed during processing a node
+    // (e. g. a subgraph for function pointer call was built)
+    bool ps_changed;
+
+    // the number of processed nodes (statistics)
+    size_t processed_nodes_num;
+
+    // Online (lazy) cycle detection - when a copy node (CAST, PHI, ...)
+    // ends up with the same points-to set as its operand, look for
+    // a cycle of copy edges that goes back to the operand. All the nodes
+    // on such cycle must have the same points-to set, so collapse them
+    // into one representative node that keeps the set for all of them
+    bool cycle_detection;
+
+    // mapping of the collapsed nodes to their representatives
+    ADT::UnionFind<PSNode *> representatives;
+    // the nodes that are represented by a node (if there's more of them)
+    std::unordered_map<PSNode *, std::vector<PSNode *> > collapsed;
+    // copy nodes that use the node as an operand
+    std::unordered_map<PSNode *, std::vector<PSNode *> > copy_users;
+    bool copy_users_valid;
+    // the nodes that must not be collapsed, because the points-to
+    // sets of these nodes are changed also from the outside
+    std::set<PSNode *> not_collapsible;
+    // the copy edges that we already searched for a cycle
+    std::set<std::pair<PSNode *, PSNode *> > checked_edges;
+    size_t collapsed_nodes_num;
+
+    // Offline pointer equivalence - before the fixpoint computation,
+    // remove the nodes that provably have the same points-to set
+    // as some other node (casts, PHIs with a single operand, GEPs
+    // with the same operand and offset) from the graph. The removed
+    // nodes are represented by the equivalent node (using the same
+    // mapping as the cycle detection) and get its points-to set
+    // when the analysis finishes.
+    bool merge_equivalent;
+    std::vector<PSNode *> substituted;
+
+    // Saturation - the points-to set with the unknown pointer may point
+    // anywhere, so it takes only the pointers to functions (that are
+    // needed to resolve calls) and nothing else ("top", see isTopSet()).
+    // The operations with top pointers are then short-circuited.
+    // The stores via a top pointer store only to the unknown memory,
+    // so the loads from any memory must read it too, that makes
+    // the results less precise
+    bool saturate_unknown;
+    // the pointers to all functions in the subgraph - the pointers that
+    // a load via a top pointer may yield besides the unknown pointer
+    PointsToSetT function_pointers;
+    bool function_pointers_valid;
+
+    // Parallel solving - process the nodes of every round in more
+    // threads (see runParallel()). Only for analyses with stable
+    // memory objects (flow-insensitive), the hooks of the analysis
+    // (beforeProcessed(), afterProcessed() and the getMemoryObjects()
+    // for existing objects) must be safe to call from more threads
+    unsigned threads_num;
+
+    // the changes done by processing the nodes in one thread
+    // during a round of the parallel solving
+    struct RoundUpdates {
+        struct MemoryUpdate {
+            MemoryObject *object;
+            Offset offset;
+            Pointer ptr;
+
+            MemoryUpdate(MemoryObject *o, const Offset& off, const Pointer& p)
+            : object(o), offset(off), ptr(p) {}
+        };
+
+        struct Error {
+            PSNode *node; // the node that was processed
+            PSNode *at;
+            const char *msg;
+
+            Error(PSNode *n, PSNode *a, const char *m)
+            : node(n), at(a), msg(m) {}
+        };
+
+        // the pointers and the memory updates are split
+        // by the shard of the changed set (see getShard())
+        std::vector<std::vector<std::pair<PSNode *, Pointer> > > pointers;
+        std::vector<std::vector<MemoryUpdate> > memory;
+        std::vector<PSNode *> zero_initialized;
+        std::vector<std::pair<PSNode *, PSNode *> > empty_points_to;
+        std::vector<Error> errors;
+        std::vector<std::pair<PSNode *, PSNode *> > funcptr_calls;
+        // the nodes for which processNode() returned true
+        std::vector<PSNode *> changed;
+        // the node that is being processed
+        PSNode *current;
+        size_t processed_nodes_num;
+
+        RoundUpdates() : current(nullptr), processed_nodes_num(0) {}
+
+        // forget the updates, but keep the allocated memory
+        void reset(unsigned shards);
+    };
+
+    // the number of parts into which the changed points-to sets
+    // are split, every part is changed by one thread
+    unsigned shards_num;
+    unsigned getShard(const void *p) const
+    {
+        // the objects are aligned, ignore the lowest bits
+        return (reinterpret_cast<uintptr_t>(p) >> 4) % shards_num;
+    }
+
+    // the updates of the thread, if it is running
+    // a round of the parallel solving
+    static thread_local RoundUpdates *round_updates;
+
 protected:
     // a set of changed nodes that are going to be
     // processed by the analysis
     std::vector<PSNode *> to_process;
     std::vector<PSNode *> changed;
 
+    // process one node, for the analyses that
+    // schedule the processing of nodes on their own
+    bool processNode(PSNode *);
+
+    // process one node together with the hooks and enqueue it
+    // if it changed (as the rounds in run() do)
+    void processWithHooks(PSNode *n)
+    {
+        beforeProcessed(n);
+
+        ++processed_nodes_num;
+        if (processNode(n))
+            enqueue(n);
+
+        afterProcessed(n);
+    }
+
+    // was the PointerSubgraph changed (a subgraph for a call
+    // via function pointer was built) since the last call
+    // of this method?
+    bool takeSubgraphChanged()
+    {
+        bool ret = ps_changed;
+        ps_changed = false;
+        return ret;
+    }
+
     // protected constructor for child classes
     PointerAnalysis() : PS(nullptr), max_offset(UNKNOWN_OFFSET),
-                         preprocess_geps(true) {}
+                         preprocess_geps(true), diff_propagation(false),
+                         scc_scheduling(false), alias_classes(false),
+                         ps_changed(false),
+                         processed_nodes_num(0), cycle_detection(false),
+                         copy_users_valid(false), collapsed_nodes_num(0),
+                         merge_equivalent(false), saturate_unknown(false),
+                         function_pointers_valid(false), threads_num(1),
+                         shards_num(1) {}
 
 public:
     PointerAnalysis(PointerSubgraph *ps,
                     uint64_t max_off = UNKNOWN_OFFSET,
                     bool prepro_geps = true)
-    : PS(ps), max_offset(max_off), preprocess_geps(prepro_geps)
+    : PS(ps), max_offset(max_off), preprocess_geps(prepro_geps),
+      diff_propagation(false), scc_scheduling(false), alias_classes(false),
+      ps_changed(false),
+      processed_nodes_num(0), cycle_detection(false),
+      copy_users_valid(false), collapsed_nodes_num(0),
+      merge_equivalent(false), saturate_unknown(false),
+      function_pointers_valid(false), threads_num(1), shards_num(1)
     {
         assert(PS && "Need valid PointerSubgraph object");
 
@@ -82,6 +281,14 @@ public:
         changed.push_back(n);
     }
 
+    // make sure that the points-to set of the node is computed.
+    // The analyses that compute everything in run() need not
+    // do anything, the demand-driven analyses compute it here
+    virtual void resolve(PSNode *n)
+    {
+        (void) n;
+    }
+
     /* hooks for analysis - optional */
     virtual void beforeProcessed(PSNode *n)
     {
@@ -95,24 +302,87 @@ public:
 
     PointerSubgraph *getPS() const { return PS; }
 
+    void setDifferencePropagation(bool diff) { diff_propagation = diff; }
+    bool getDifferencePropagation() const { return diff_propagation; }
+
+    void setSCCScheduling(bool scc) { scc_scheduling = scc; }
+    bool getSCCScheduling() const { return scc_scheduling; }
+
+    void setAliasClassesScheduling(bool ac) { alias_classes = ac; }
+    bool getAliasClassesScheduling() const { return alias_classes; }
+
+    size_t getProcessedNodesNum() const { return processed_nodes_num; }
+
+    void setCycleDetection(bool cd) { cycle_detection = cd; }
+    bool getCycleDetection() const { return cycle_detection; }
+
+    size_t getCollapsedNodesNum() const { return collapsed_nodes_num; }
+
+    void setMergeEquivalent(bool me) { merge_equivalent = me; }
+    bool getMergeEquivalent() const { return merge_equivalent; }
+
+    size_t getSubstitutedNodesNum() const { return substituted.size(); }
+
+    void setSaturateUnknown(bool sat) { saturate_unknown = sat; }
+    bool getSaturateUnknown() const { return saturate_unknown; }
+
+    // may the node point anywhere? (with the saturation only)
+    bool isTop(PSNode *n) const
+    {
+        return saturate_unknown && n->isTop();
+    }
+
+    void setThreadsNum(unsigned num) { threads_num = num > 0 ? num : 1; }
+    unsigned getThreadsNum() const { return threads_num; }
+
+    // get the node that keeps the points-to set for the given node
+    // (the node itself if it was not collapsed with other nodes)
+    PSNode *getRepresentative(PSNode *n)
+    {
+        return representatives.empty() ? n : representatives.find(n);
+    }
+
+    // get the node that keeps the points-to set of idx-th operand
+    PSNode *getOperandRepr(PSNode *n, unsigned idx)
+    {
+        return getRepresentative(n->getOperand(idx));
+    }
+
+    // do the memory objects returned by getMemoryObjects()
+    // for a pointer stay the same during the whole analysis?
+    // If so, we can store only the new pointers in difference propagation
+    virtual bool hasStableMemoryObjects() const
+    {
+        return false;
+    }
+
     void preprocessGEPs()
     {
         // if a node is in a loop (a scc that has more than one node),
         // then every GEP that is also stored to the same memory afterwards
         // in the loop will end up with UNKNOWN_OFFSET after some
         // number of iterations, so we can do that right now
-        // and save iterations
+        // and save iterations. If the offset of the GEP is concrete,
+        // the pointer is moved by its multiples, so use the offset
+        // as the stride instead. The strided offsets stay as they are,
+        // they have only a bounded number of values
         for (const auto& scc : SCCs) {
             if (scc.size() > 1) {
                 for (PSNode *n : scc) {
-                    if (n->getType() == GEP)
-                        n->setOffset(UNKNOWN_OFFSET);
+                    if (n->getType() != GEP
+                        || n->offset.isUnknown() || n->offset.isStrided()
+                        || *n->offset == 0)
+                        continue;
+
+                    // the offset may be negative
+                    int64_t off = static_cast<int64_t>(*n->offset);
+                    n->setOffset(*Offset::getStrided(0, off < 0 ? -off : off));
                 }
             }
         }
     }
 
-    void run()
+    virtual void run()
     {
         PSNode *root = PS->getRoot();
         assert(root && "Do not have root of PS");
@@ -121,6 +391,31 @@ public:
         if (preprocess_geps)
             preprocessGEPs();
 
+        // must go after preprocessing GEPs, that may change the offsets
+        if (merge_equivalent)
+            substituteEquivalentNodes();
+
+        if (threads_num > 1 && hasStableMemoryObjects()
+            && checkParallelOptions())
+            runParallel();
+        else if (alias_classes && hasStableMemoryObjects()
+                 && checkAliasClassesOptions())
+            runAliasClasses();
+        else if (scc_scheduling)
+            runSCCs();
+        else
+            runRounds();
+
+        // the collapsed nodes have the points-to set
+        // only in their representative, copy it to them
+        if (!representatives.empty())
+            propagateToCollapsedNodes();
+    }
+
+    void runRounds()
+    {
+        PSNode *root = PS->getRoot();
+
         // rely on C++11 move semantics
         to_process = PS->getNodes(root);
 
@@ -129,14 +424,8 @@ public:
             unsigned last_processed_num = to_process.size();
             changed.clear();
 
-            for (PSNode *cur : to_process) {
-                beforeProcessed(cur);
-
-                if (processNode(cur))
-                    enqueue(cur);
-
-                afterProcessed(cur);
-            }
+            for (PSNode *cur : to_process)
+                processWithHooks(cur);
 
             if (!changed.empty()) {
                 to_process.clear();
@@ -180,9 +469,59 @@ public:
     }
 
 private:
-    bool processNode(PSNode *);
+    bool isCollapsible(PSNode *n) const;
+    void buildCopyUsers();
+    void getCollapsed(PSNode *rep, std::vector<PSNode *>& nodes);
+    bool collapseCycle(PSNode *op, PSNode *node);
+    void propagateToCollapsedNodes();
+    void substituteEquivalentNodes();
+
+    // the changes of the state done by processing the nodes,
+    // in the parallel solving these are only recorded and done
+    // at the end of the round
+    bool addPointsTo(PSNode *node, const Pointer& ptr);
+    bool addPointsTo(PSNode *node, const PointsToSetT& ptrs);
+    bool addPointsTo(MemoryObject *o, const Offset& off, const Pointer& ptr);
+    bool addPointsTo(MemoryObject *o, const Offset& off,
+                     const PointsToSetT& ptrs);
+    bool addTopPointsTo(PSNode *node);
+    bool addTopPointsTo(MemoryObject *o);
+    const PointsToSetT& getFunctionPointers();
+    void setZeroInitialized(PSNode *node);
+    bool reportError(PSNode *at, const char *msg);
+    bool reportEmptyPointsTo(PSNode *from, PSNode *to);
+    void callFunctionPointer(PSNode *where, PSNode *what);
+
+    bool checkParallelOptions() const;
+    void runParallel();
+    void createMemoryObjects(const std::vector<PSNode *>& nodes);
+    void processInParallel(ADT::ThreadPool& pool,
+                           const std::vector<PSNode *>& nodes,
+                           std::vector<RoundUpdates>& updates);
+    void applyUpdates(ADT::ThreadPool& pool,
+                      std::vector<RoundUpdates>& updates);
+
+    bool checkAliasClassesOptions() const;
+    void computeAliasGroups(const std::vector<PSNode *>& nodes,
+                            std::vector<std::vector<PSNode *> >& groups);
+    bool solveAliasGroup(const std::vector<PSNode *>& group);
+    void runAliasClasses();
+
+    void computeSCCs();
+    void runSCCs();
+    void processSCC(const std::vector<PSNode *>& scc);
+
     bool processLoad(PSNode *node);
+    bool loadStoredViaUnknown(PSNode *node);
+    bool processStore(PSNode *node);
     bool processMemcpy(PSNode *node);
+    bool processCopy(PSNode *node, unsigned idx, PointsToSetT& delta);
+
+    bool getOperandDelta(PSNode *node, unsigned idx, PointsToSetT& delta);
+    void logNewPointers(PSNode *node, const PointsToSetT& added);
+    void clearDeltas();
+    const PointsToSetT& getOperandPointsTo(PSNode *node, unsigned idx,
+                                           PointsToSetT& delta);
 };
 
 } // namespace pta
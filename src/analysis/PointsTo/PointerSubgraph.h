@@ -4,9 +4,14 @@
 #include <cassert>
 #include <vector>
 #include <cstdarg>
+#include <cstdint>
 #include <cstring> // for strdup
+#include <memory>
+#include <unordered_map>
+#include <utility>
 
 #include "Pointer.h"
+#include "ADT/Arena.h"
 #include "ADT/Queue.h"
 #include "analysis/SubgraphNode.h"
 
@@ -236,6 +241,10 @@ public:
     // reason the PointerSubgraph node exists, so don't hide it
     PointsToSetT pointsTo;
 
+    // the node may point anywhere (see isTopSet())
+    bool isTop() const { return isTopSet(pointsTo); }
+    bool makeTop() { return makeTopSet(pointsTo); }
+
     // convenient helper
     bool addPointsTo(PSNode *n, Offset o)
     {
@@ -255,13 +264,38 @@ public:
         return addPointsTo(ptr.target, ptr.offset);
     }
 
-    bool addPointsTo(const std::set<Pointer>& ptrs)
+    bool addPointsTo(const PointsToSetT& ptrs)
     {
+#ifdef ENABLE_SHARED_PTSETS
+        // copy-like edges - just share the set
+        if (pointsTo.empty()) {
+            pointsTo = ptrs;
+            return !ptrs.empty();
+        }
+
+        // union the interned sets at once (the union is memoized)
+        // and then drop the concrete offsets that the union covers
+        // by UNKNOWN_OFFSET. Inserting the pointers one by one would
+        // intern a new set for every pointer. The handle copy is cheap
+        PointsToSetT old = pointsTo;
+        if (!pointsTo.add(ptrs))
+            return false;
+
+        removeCoveredOffsets();
+        return pointsTo != old;
+#else
+#ifdef ENABLE_SPARSE_PTSETS
+        // cheap word-level check - in most cases (when re-processing
+        // nodes in the fixpoint) all the pointers are already there
+        if (ptrs.isSubsetOf(pointsTo))
+            return false;
+#endif
         bool changed = false;
         for (const Pointer& ptr: ptrs)
             changed |= addPointsTo(ptr);
 
         return changed;
+#endif // ENABLE_SHARED_PTSETS
     }
 
     bool doesPointsTo(const Pointer& p)
@@ -275,10 +309,144 @@ public:
     }
 
     bool addPointsToUnknownOffset(PSNode *target);
+    // remove the pointers with concrete offset to the targets
+    // that are pointed with UNKNOWN_OFFSET too
+    void removeCoveredOffsets();
 
     // FIXME: maybe get rid of these friendships?
     friend class PointerAnalysis;
     friend class PointerSubgraph;
+    friend class FrozenPointerSubgraph;
+};
+
+// Compact form of a PointerSubgraph for the traversals. The nodes
+// reachable from the root get dense ids (in BFS order from the root)
+// and the successors are stored in CSR arrays (the successors
+// of the node with id i are succ_ids[succ_start[i] .. succ_start[i + 1]) ).
+// It is a snapshot of the subgraph, it must be built again
+// when the subgraph changes.
+// Only the successors are frozen, that is the only part of the subgraph
+// that is walked without touching the nodes. Processing a node reads and
+// writes the points-to sets of the node and of its operands, so the type,
+// offset and operands are read from the node that is in the cache anyway.
+class FrozenPointerSubgraph
+{
+    // id -> node
+    std::vector<PSNode *> nodes;
+    std::unordered_map<const PSNode *, uint32_t> ids;
+
+    std::vector<uint32_t> succ_start, succ_ids;
+
+    // the stamps of visited nodes for traversals
+    std::vector<uint32_t> visited;
+    uint32_t stamp;
+
+    uint32_t getOrCreateId(PSNode *n)
+    {
+        auto it = ids.emplace(n, static_cast<uint32_t>(nodes.size()));
+        if (it.second)
+            nodes.push_back(n);
+
+        return it.first->second;
+    }
+
+public:
+    // a range of ids in the CSR arrays
+    class IdRange {
+        const uint32_t *b, *e;
+
+    public:
+        IdRange(const uint32_t *bb, const uint32_t *ee) : b(bb), e(ee) {}
+        const uint32_t *begin() const { return b; }
+        const uint32_t *end() const { return e; }
+        size_t size() const { return e - b; }
+    };
+
+    FrozenPointerSubgraph(PSNode *root) : stamp(0)
+    {
+        // number the nodes in BFS order (the vector is the queue)
+        getOrCreateId(root);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            for (PSNode *succ : nodes[i]->getSuccessors())
+                getOrCreateId(succ);
+        }
+
+        succ_start.reserve(nodes.size() + 1);
+        succ_start.push_back(0);
+        for (PSNode *n : nodes) {
+            for (PSNode *succ : n->getSuccessors())
+                succ_ids.push_back(ids[succ]);
+            succ_start.push_back(static_cast<uint32_t>(succ_ids.size()));
+        }
+
+        visited.resize(nodes.size(), 0);
+    }
+
+    uint32_t getNodesNum() const { return nodes.size(); }
+    PSNode *getNode(uint32_t id) const { return nodes[id]; }
+
+    // return false if the node is not in the frozen subgraph
+    bool getId(const PSNode *n, uint32_t& id) const
+    {
+        auto it = ids.find(n);
+        if (it == ids.end())
+            return false;
+
+        id = it->second;
+        return true;
+    }
+
+    IdRange getSuccessors(uint32_t id) const
+    {
+        return IdRange(succ_ids.data() + succ_start[id],
+                       succ_ids.data() + succ_start[id + 1]);
+    }
+
+    // get the nodes reachable from the starting nodes in BFS order
+    // (the same order as PointerSubgraph::getNodes() gives).
+    // Return false if some of the starting nodes is not reachable
+    // from the root
+    bool getNodes(const std::vector<PSNode *>& start,
+                  std::vector<PSNode *>& cont, unsigned expected_num)
+    {
+        // the queue is the result
+        std::vector<uint32_t> queue;
+        queue.reserve(expected_num > 0 ? expected_num : start.size());
+
+        if (++stamp == 0) {
+            // overflow, start again
+            std::fill(visited.begin(), visited.end(), 0);
+            stamp = 1;
+        }
+
+        for (PSNode *s : start) {
+            uint32_t id;
+            if (!getId(s, id))
+                return false;
+
+            // the set may contain a node more times
+            if (visited[id] == stamp)
+                continue;
+
+            visited[id] = stamp;
+            queue.push_back(id);
+        }
+
+        for (size_t i = 0; i < queue.size(); ++i) {
+            for (uint32_t succ : getSuccessors(queue[i])) {
+                if (visited[succ] != stamp) {
+                    visited[succ] = stamp;
+                    queue.push_back(succ);
+                }
+            }
+        }
+
+        cont.reserve(queue.size());
+        for (uint32_t id : queue)
+            cont.push_back(nodes[id]);
+
+        return true;
+    }
 };
 
 class PointerSubgraph
@@ -288,13 +456,69 @@ class PointerSubgraph
     // root of the pointer state subgraph
     PSNode *root;
 
+    // memory for the nodes and for the objects of the analyses
+    // (memory objects, memory maps), it is released all at once
+    // when the subgraph is destroyed
+    ADT::Arena arena;
+
+    // the compact form of the subgraph (if it is frozen)
+    // and whether it must be built again
+    std::unique_ptr<FrozenPointerSubgraph> frozen;
+    bool frozen_stale;
+
 public:
-    PointerSubgraph() : dfsnum(0), root(nullptr) {}
-    PointerSubgraph(PSNode *r) : dfsnum(0), root(r)
+    PointerSubgraph() : dfsnum(0), root(nullptr), frozen_stale(false) {}
+    PointerSubgraph(PSNode *r) : dfsnum(0), root(r), frozen_stale(false)
     {
         assert(root && "Cannot create PointerSubgraph with null root");
     }
 
+    // Build the compact form of the subgraph, the traversals
+    // of the subgraph then go over it instead over the nodes.
+    // The subgraph can still be changed, but then structureChanged()
+    // must be called
+    void freeze()
+    {
+        assert(root && "Do not have root");
+        frozen.reset(new FrozenPointerSubgraph(root));
+        frozen_stale = false;
+    }
+
+    void unfreeze() { frozen.reset(); }
+    bool isFrozen() const { return frozen != nullptr; }
+
+    // the nodes or edges were changed, the compact form
+    // will be built again when it is needed
+    void structureChanged()
+    {
+        if (frozen)
+            frozen_stale = true;
+    }
+
+    // the compact form of the subgraph (nullptr if not frozen)
+    FrozenPointerSubgraph *getFrozen()
+    {
+        if (frozen && frozen_stale)
+            freeze();
+
+        return frozen.get();
+    }
+
+    // create a node that is owned by the subgraph,
+    // the arguments are the same as for the PSNode constructor
+    template <typename... Args>
+    PSNode *createNode(PSNodeType t, Args&&... args)
+    {
+        return arena.create<PSNode>(t, std::forward<Args>(args)...);
+    }
+
+    // create an object that lives as long as the subgraph
+    template <typename T, typename... Args>
+    T *createObject(Args&&... args)
+    {
+        return arena.create<T>(std::forward<Args>(args)...);
+    }
+
     PSNode *getRoot() const { return root; }
     void setRoot(PSNode *r) { root = r; }
 
@@ -385,11 +609,31 @@ public:
         assert(!(start_set && start_node)
                && "Need either starting set or starting node, not both");
 
+        if (FrozenPointerSubgraph *F = getFrozen()) {
+            std::vector<PSNode *> cont;
+            bool ret;
+            if (start_set) {
+                ret = F->getNodes(*start_set, cont, expected_num);
+            } else {
+                std::vector<PSNode *> start(1, start_node ? start_node : root);
+                ret = F->getNodes(start, cont, expected_num);
+            }
+
+            if (ret)
+                return cont;
+            // the starting nodes are not in the frozen subgraph,
+            // go over the nodes
+        }
+
         ++dfsnum;
         ADT::QueueFIFO<PSNode *> fifo;
 
         if (start_set) {
             for (PSNode *s : *start_set) {
+                // the set may contain a node more times
+                if (s->dfsid == dfsnum)
+                    continue;
+
                 fifo.push(s);
                 s->dfsid = dfsnum;
             }
@@ -0,0 +1,366 @@
+#ifndef _DG_ANALYSIS_POINTS_TO_DEMAND_DRIVEN_H_
+#define _DG_ANALYSIS_POINTS_TO_DEMAND_DRIVEN_H_
+
+#include <cassert>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Pointer.h"
+#include "PointerSubgraph.h"
+#include "PointerAnalysis.h"
+#include "PointsToFlowInsensitive.h"
+#include "SteensgaardClasses.h"
+#include "ADT/Queue.h"
+
+namespace dg {
+namespace analysis {
+namespace pta {
+
+// Flow-insensitive pointer analysis that computes the points-to sets
+// only for the nodes that somebody asks about (see resolve()).
+// run() does not solve anything, a query solves the subgraph
+// restricted to the nodes that the points-to set of the queried node
+// depends on:
+//
+//  - the operands of the node (transitively)
+//  - the stores (and memcpys) that may write to the memory that
+//    the relevant loads read. To find them without solving
+//    the pointer operands of all the stores, the stores are indexed
+//    by the Steensgaard's alias class of their pointer operand
+//    (see SteensgaardClasses). Only the stores in the classes
+//    of the relevant loads are solved. The classes are computed
+//    for the whole subgraph, but that is almost linear
+//
+// The calls via function pointers change the subgraph, so all of them
+// are resolved with the first query. The results of the queries stay
+// in the nodes, so the next queries start from them. The results are
+// the same as the results of PointsToFlowInsensitive.
+//
+// When a query processes more nodes than the budget allows (if set),
+// the analysis falls back to solving the whole subgraph.
+class PointsToDemandDriven : public PointsToFlowInsensitive
+{
+public:
+    PointsToDemandDriven(PointerSubgraph *ps)
+    : PointsToFlowInsensitive(ps), budget(0), initialized(false),
+      exhaustive(false), classes_valid(false), reads_indexed(0),
+      queries_num(0), demand_processed_num(0), fallbacks_num(0) {}
+
+    // just prepare the subgraph, the points-to sets
+    // are computed on demand
+    virtual void run()
+    {
+        preprocessGEPs();
+    }
+
+    virtual void resolve(PSNode *n)
+    {
+        if (!n || exhaustive)
+            return;
+
+        ++queries_num;
+        // the node is resolved if it was relevant for some query
+        if (relevant.count(n) > 0)
+            return;
+
+        size_t processed_before = demand_processed_num;
+        if (!initialized) {
+            initialized = true;
+            buildIndex();
+        }
+
+        demand(n);
+        if (!solve(processed_before)) {
+            // the query was too expensive, solve everything
+            ++fallbacks_num;
+            exhaustive = true;
+            PointerAnalysis::run();
+        }
+    }
+
+    // the maximal number of nodes processed by one query
+    // before falling back to the exhaustive analysis (0 = unlimited)
+    void setBudget(size_t b) { budget = b; }
+    size_t getBudget() const { return budget; }
+
+    // did some query fall back to the exhaustive analysis?
+    bool isExhaustive() const { return exhaustive; }
+
+    size_t getQueriesNum() const { return queries_num; }
+    size_t getDemandProcessedNodesNum() const { return demand_processed_num; }
+    size_t getFallbacksNum() const { return fallbacks_num; }
+    size_t getRelevantNodesNum() const { return relevant.size(); }
+
+private:
+    size_t budget;
+    bool initialized;
+    bool exhaustive;
+
+    // the nodes whose points-to sets are being computed
+    std::unordered_set<PSNode *> relevant;
+    // the nodes that use the node as an operand
+    std::unordered_map<PSNode *, std::vector<PSNode *> > users;
+    // all STORE and MEMCPY nodes
+    std::vector<PSNode *> stores;
+    // the stores that may write to the memory read by relevant nodes
+    std::unordered_set<PSNode *> active_stores;
+
+    // the alias classes of the memory in the subgraph,
+    // they are computed again when the subgraph changes
+    SteensgaardClasses classes;
+    bool classes_valid;
+    // alias class -> the stores that write to the memory in the class
+    std::unordered_map<unsigned, std::vector<PSNode *> > class_stores;
+    // the alias classes read by the relevant nodes
+    std::unordered_set<unsigned> read_classes;
+    // the relevant LOAD and MEMCPY nodes, the first
+    // reads_indexed of them have their class in read_classes
+    std::vector<PSNode *> reads;
+    size_t reads_indexed;
+    // memory (allocation site) -> relevant nodes that read it
+    std::unordered_map<PSNode *, std::set<PSNode *> > readers;
+
+    ADT::QueueFIFO<PSNode *> queue;
+    std::unordered_set<PSNode *> queued;
+
+    // statistics
+    size_t queries_num;
+    size_t demand_processed_num;
+    size_t fallbacks_num;
+
+    void push(PSNode *n)
+    {
+        if (queued.insert(n).second)
+            queue.push(n);
+    }
+
+    void buildIndex()
+    {
+        PointerSubgraph *PS = getPS();
+
+        users.clear();
+        stores.clear();
+        classes_valid = false;
+        for (PSNode *n : PS->getNodes(PS->getRoot())) {
+            for (PSNode *op : n->getOperands())
+                users[op].push_back(n);
+
+            switch (n->getType()) {
+                case STORE:
+                case MEMCPY:
+                    stores.push_back(n);
+                    break;
+                case CALL_FUNCPTR:
+                    // calls via function pointers change the subgraph,
+                    // resolve them right away
+                    demand(n);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // unify the whole subgraph and index the stores by the class
+    // of the memory they write to
+    void computeClasses()
+    {
+        PointerSubgraph *PS = getPS();
+        std::vector<PSNode *> loads;
+
+        classes.clear();
+        for (PSNode *n : PS->getNodes(PS->getRoot())) {
+            classes.unify(n);
+            if (n->getType() == LOAD)
+                loads.push_back(n);
+        }
+
+        // as in PointsToSteensgaard::run()
+        unsigned unknown = classes.getAliasClass(UNKNOWN_MEMORY);
+        if (getSaturateUnknown() && unknown != SteensgaardClasses::NONE) {
+            for (PSNode *load : loads)
+                classes.join(classes.getId(load), classes.getPointee(unknown));
+        }
+
+        class_stores.clear();
+        for (PSNode *s : stores)
+            class_stores[classes.getAliasClass(s->getOperand(1))].push_back(s);
+
+        read_classes.clear();
+        reads_indexed = 0;
+        classes_valid = true;
+    }
+
+    // make the node and everything it depends on relevant
+    void demand(PSNode *n)
+    {
+        std::vector<PSNode *> stack(1, n);
+        while (!stack.empty()) {
+            PSNode *cur = stack.back();
+            stack.pop_back();
+
+            if (!relevant.insert(cur).second)
+                continue;
+
+            // the special nodes (null, unknown memory) are not
+            // in the subgraph and they have fixed points-to sets
+            if (cur->getType() == NULL_ADDR || cur->getType() == UNKNOWN_MEM)
+                continue;
+
+            push(cur);
+            if (cur->getType() == LOAD || cur->getType() == MEMCPY)
+                reads.push_back(cur);
+
+            for (PSNode *op : cur->getOperands())
+                stack.push_back(op);
+        }
+    }
+
+    // remember the memory that the node reads
+    void addReads(PSNode *n)
+    {
+        for (const Pointer& ptr : n->getOperand(0)->pointsTo) {
+            if (ptr.isNull())
+                continue;
+
+            readers[getMemoryNode(ptr.target)].insert(n);
+            // with the saturation, any memory may contain
+            // what was stored via a pointer to unknown memory
+            if (getSaturateUnknown())
+                readers[UNKNOWN_MEMORY].insert(n);
+        }
+    }
+
+    // the memory was changed, process the nodes that read it again
+    void memoryChanged(PSNode *n)
+    {
+        for (const Pointer& ptr : n->getOperand(1)->pointsTo) {
+            if (ptr.isNull())
+                continue;
+
+            auto it = readers.find(getMemoryNode(ptr.target));
+            if (it == readers.end())
+                continue;
+
+            for (PSNode *reader : it->second)
+                push(reader);
+        }
+    }
+
+    void activateStore(PSNode *s)
+    {
+        if (active_stores.insert(s).second) {
+            demand(s);
+            // the store may be relevant already
+            push(s);
+        }
+    }
+
+    // make relevant the stores that write to the memory in the class
+    void activateClass(unsigned c)
+    {
+        if (!read_classes.insert(c).second)
+            return;
+
+        auto it = class_stores.find(c);
+        if (it == class_stores.end())
+            return;
+
+        for (PSNode *s : it->second)
+            activateStore(s);
+    }
+
+    // find the stores that may write to the memory read
+    // by relevant nodes and make them relevant
+    void activateStores()
+    {
+        if (reads.empty())
+            return;
+
+        if (!classes_valid)
+            computeClasses();
+
+        // the stores can make new loads relevant
+        // (via the loaded pointer operands)
+        for (; reads_indexed < reads.size(); ++reads_indexed) {
+            PSNode *ptr = reads[reads_indexed]->getOperand(0);
+            unsigned c = classes.getAliasClass(ptr);
+            if (c != SteensgaardClasses::NONE) {
+                activateClass(c);
+                continue;
+            }
+
+            // the read is not in the subgraph,
+            // we know nothing about the memory
+            for (PSNode *s : stores)
+                activateStore(s);
+        }
+
+        // with the saturation, any memory may contain
+        // what was stored via a pointer to unknown memory
+        unsigned unknown = classes.getAliasClass(UNKNOWN_MEMORY);
+        if (getSaturateUnknown() && unknown != SteensgaardClasses::NONE)
+            activateClass(unknown);
+    }
+
+    // compute the points-to sets of the relevant nodes,
+    // return false if the budget was exceeded
+    bool solve(size_t processed_before)
+    {
+        do {
+            while (!queue.empty()) {
+                if (budget > 0
+                    && demand_processed_num - processed_before >= budget)
+                    return false;
+
+                PSNode *n = queue.pop();
+                queued.erase(n);
+
+                ++demand_processed_num;
+                bool changed = processNode(n);
+
+                if (n->getType() == LOAD || n->getType() == MEMCPY)
+                    addReads(n);
+
+                if (takeSubgraphChanged()) {
+                    // new operands and nodes were added, find them
+                    // and process all the relevant nodes again
+                    buildIndex();
+                    std::vector<PSNode *> nodes(relevant.begin(),
+                                                relevant.end());
+                    for (PSNode *r : nodes) {
+                        for (PSNode *op : r->getOperands())
+                            demand(op);
+                        push(r);
+                    }
+                }
+
+                if (!changed)
+                    continue;
+
+                if (n->getType() == STORE || n->getType() == MEMCPY)
+                    memoryChanged(n);
+
+                auto it = users.find(n);
+                if (it != users.end()) {
+                    for (PSNode *user : it->second) {
+                        if (relevant.count(user) > 0)
+                            push(user);
+                    }
+                }
+            }
+
+            activateStores();
+        } while (!queue.empty());
+
+        return true;
+    }
+};
+
+} // namespace pta
+} // namespace analysis
+} // namespace dg
+
+#endif // _DG_ANALYSIS_POINTS_TO_DEMAND_DRIVEN_H_
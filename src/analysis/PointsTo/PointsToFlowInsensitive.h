@@ -14,28 +14,31 @@ class PointsToFlowInsensitive : public PointerAnalysis
 {
     PointerSubgraph *ps;
 
+    // the memory object for the unknown memory. The node for unknown
+    // memory is shared by all the subgraphs, so we do not store
+    // the object into it
+    MemoryObject *unknown_memory;
+
 protected:
-    PointsToFlowInsensitive() {}
+    PointsToFlowInsensitive() : ps(nullptr), unknown_memory(nullptr) {}
 
 public:
-    PointsToFlowInsensitive(PointerSubgraph *ps)
-    : PointerAnalysis(ps), ps(ps) {}
+    PointsToFlowInsensitive(PointerSubgraph *ps, bool prepro_geps = true)
+    : PointerAnalysis(ps, UNKNOWN_OFFSET, prepro_geps), ps(ps),
+      unknown_memory(nullptr) {}
 
     ~PointsToFlowInsensitive() {
+        // the memory objects are owned by the PointerSubgraph,
+        // just do not let other analyses find them in the nodes
         std::vector<PSNode *> nodes = ps->getNodes();
-        for (PSNode *n : nodes) {
-            MemoryObject *mo = n->getData<MemoryObject>();
-            delete mo;
-        }
+        for (PSNode *n : nodes)
+            n->setData<MemoryObject>(nullptr);
     }
 
-    virtual void getMemoryObjects(PSNode *where, const Pointer& pointer,
-                                  std::vector<MemoryObject *>& objects)
+    // get the node that keeps the memory object
+    // for the memory pointed by a pointer to @n
+    static PSNode *getMemoryNode(PSNode *n)
     {
-        // irrelevant in flow-insensitive
-        (void) where;
-        PSNode *n = pointer.target;
-
         // we want to have memory in allocation sites
         if (n->getType() == pta::CAST || n->getType() == pta::GEP)
             n = n->getOperand(0);
@@ -44,21 +47,45 @@ public:
             n = (n->pointsTo.begin())->target;
         }
 
+        return n;
+    }
+
+    virtual void getMemoryObjects(PSNode *where, const Pointer& pointer,
+                                  std::vector<MemoryObject *>& objects)
+    {
+        // irrelevant in flow-insensitive
+        (void) where;
+        PSNode *n = getMemoryNode(pointer.target);
+
         if (n->getType() == pta::FUNCTION)
             return;
 
         assert(n->getType() == pta::ALLOC || n->getType() == pta::DYN_ALLOC
                || n->getType() == pta::UNKNOWN_MEM);
 
+        if (n == UNKNOWN_MEMORY) {
+            if (!unknown_memory)
+                unknown_memory = ps->createObject<MemoryObject>(n);
+
+            objects.push_back(unknown_memory);
+            return;
+        }
+
         MemoryObject *mo = n->getData<MemoryObject>();
         if (!mo) {
-            mo = new MemoryObject(n);
+            mo = ps->createObject<MemoryObject>(n);
             n->setData<MemoryObject>(mo);
         }
 
         objects.push_back(mo);
     }
 
+    // there is one memory object per allocation site
+    virtual bool hasStableMemoryObjects() const
+    {
+        return true;
+    }
+
     virtual void afterProcessed(PSNode *n)
     {
         (void) n;
@@ -2,9 +2,15 @@
 #define _DG_ANALYSIS_POINTS_TO_FLOW_SENSITIVE_H_
 
 #include <cassert>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
 
 #include "Pointer.h"
 #include "PointerSubgraph.h"
+#include "ADT/PersistentHashMap.h"
 
 namespace dg {
 namespace analysis {
@@ -14,10 +20,15 @@ class PointsToFlowSensitive : public PointerAnalysis
 {
 public:
     typedef std::set<MemoryObject *> MemoryObjectsSetT;
-    typedef std::map<const Pointer, MemoryObjectsSetT> MemoryMapT;
+    // the memory objects for the pointers to one allocation site
+    typedef std::map<const Pointer, MemoryObjectsSetT> ObjectsMapT;
+    typedef std::shared_ptr<const ObjectsMapT> ObjectsMapPtrT;
+    // memory map - persistent map from allocation sites to their
+    // memory objects. The maps of different nodes share the parts
+    // that are the same. ObjectsMapT is never changed once it is
+    // in a map, it is copied on write.
+    typedef ADT::PersistentHashMap<PSNode *, ObjectsMapPtrT> MemoryMapT;
 
-    // this is an easy but not very efficient implementation,
-    // works for testing
     PointsToFlowSensitive(PointerSubgraph *ps) : PointerAnalysis(ps,
                                                  UNKNOWN_OFFSET, false) {}
 
@@ -27,38 +38,19 @@ public:
         if (!mm) {
             // on these nodes the memory map can change
             if (n->predecessorsNum() == 0) { // root node
-                // FIXME: we're leaking the memory maps
-                mm = new MemoryMapT();
-            } else if (n->getType() == pta::STORE) {
-                mm = new MemoryMapT();
-
-                // create empty memory object so that STORE can
-                // store the pointers into it
-                for (const Pointer& ptr : n->getOperand(1)->pointsTo) {
-                    // FIXME: we're leaking the mem. objects, use autoptr?
-                    (*mm)[ptr].insert(new MemoryObject(ptr.target));
-                }
-            }  else if (n->getType() == pta::MEMCPY) {
-                mm = new MemoryMapT();
-
-                // create empty memory object so that MEMCPY can
-                // store the pointers into it
-                for (const Pointer& ptr : n->getOperand(1)->pointsTo) {
-                    // FIXME: we're leaking the mem. objects, use autoptr?
-                    (*mm)[ptr].insert(new MemoryObject(ptr.target));
-                }
+                mm = newMemoryMap();
+            } else if (n->getType() == pta::STORE
+                       || n->getType() == pta::MEMCPY) {
+                mm = newMemoryMap();
+
+                // create empty memory object so that STORE (MEMCPY)
+                // can store the pointers into it
+                for (const Pointer& ptr : getOperandRepr(n, 1)->pointsTo)
+                    addMemoryObject(mm, ptr, newMemoryObject(ptr.target));
             } else if (n->predecessorsNum() > 1) {
-                // this is a join node, create new map and
-                // merge the predecessors to it
-                mm = new MemoryMapT();
-
-                // merge information from predecessors into new map
-                for (PSNode *p : n->getPredecessors()) {
-                    MemoryMapT *pm = p->getData<MemoryMapT>();
-                    // merge pm to mm (if pm was already created)
-                    if (pm)
-                        mergeMaps(mm, pm, nullptr);
-                }
+                // this is a join node, create new map,
+                // the predecessors are merged to it below
+                mm = newMemoryMap();
             } else {
                 PSNode *pred = n->getSinglePredecessor();
                 mm = pred->getData<MemoryMapT>();
@@ -69,21 +61,64 @@ public:
             // so that we won't initialize it again
             n->setData<MemoryMapT>(mm);
         }
+
+        // merge the predecessors before processing the node,
+        // so that the node works with the up-to-date memory
+        // (the predecessors may have changed since the last time)
+        mergePredecessors(n, mm);
     }
 
-    virtual void afterProcessed(PSNode *n)
+    virtual void getMemoryObjects(PSNode *where, const Pointer& pointer,
+                                  std::vector<MemoryObject *>& objects)
     {
-        PointsToSetT *strong_update = nullptr;
+        MemoryMapT *mm= where->getData<MemoryMapT>();
+        assert(mm && "Node does not have memory map");
 
-        MemoryMapT *mm = n->getData<MemoryMapT>();
-        // we must have the memory map, we created it
-        // in the beforeProcessed method
-        assert(mm && "Do not have memory map");
+        const ObjectsMapPtrT *objs = mm->find(pointer.target);
+        if (!objs)
+            return;
+
+        for (const auto& it : **objs) {
+            assert(it.first.target == pointer.target
+                    && "Wrong objects in memory map");
+
+            for (MemoryObject *mo : it.second)
+                objects.push_back(mo);
+        }
+    }
+
+protected:
+    PointsToFlowSensitive() {}
+
+private:
+    // the memory maps and objects are owned by the PointerSubgraph
+    MemoryMapT *newMemoryMap()
+    {
+        return getPS()->createObject<MemoryMapT>();
+    }
+
+    MemoryObject *newMemoryObject(PSNode *target)
+    {
+        return getPS()->createObject<MemoryObject>(target);
+    }
+
+    static void addMemoryObject(MemoryMapT *mm, const Pointer& ptr,
+                                MemoryObject *mo)
+    {
+        const ObjectsMapPtrT *old = mm->find(ptr.target);
+        ObjectsMapT *objs = old ? new ObjectsMapT(**old) : new ObjectsMapT();
+        (*objs)[ptr].insert(mo);
+        mm->set(ptr.target, ObjectsMapPtrT(objs));
+    }
+
+    void mergePredecessors(PSNode *n, MemoryMapT *mm)
+    {
+        PointsToSetT *strong_update = nullptr;
 
         // every store is strong update
         // FIXME: memcpy can be strong update too
         if (n->getType() == pta::STORE)
-            strong_update = &n->getOperand(1)->pointsTo;
+            strong_update = &getOperandRepr(n, 1)->pointsTo;
 
         // merge information from predecessors if there's
         // more of them (if there's just one predecessor
@@ -100,51 +135,79 @@ public:
         }
     }
 
-    virtual void getMemoryObjects(PSNode *where, const Pointer& pointer,
-                                  std::vector<MemoryObject *>& objects)
+    // return the union of the objects, or @a if there is nothing new in @b
+    static ObjectsMapPtrT mergeObjects(const ObjectsMapPtrT& a,
+                                       const ObjectsMapPtrT& b)
     {
-        MemoryMapT *mm= where->getData<MemoryMapT>();
-        assert(mm && "Node does not have memory map");
-
-        auto bounds = getObjectRange(mm, pointer);
-        for (MemoryMapT::iterator I = bounds.first;
-             I != bounds.second; ++I) {
-            assert(I->first.target == pointer.target
-                    && "Bug in getObjectRange");
-
-            for (MemoryObject *mo : I->second)
-                objects.push_back(mo);
+        if (a == b)
+            return a;
+
+        bool subset = true;
+        for (const auto& it : *b) {
+            auto ait = a->find(it.first);
+            if (ait == a->end()
+                || !std::includes(ait->second.begin(), ait->second.end(),
+                                  it.second.begin(), it.second.end())) {
+                subset = false;
+                break;
+            }
         }
-    }
 
-protected:
-    PointsToFlowSensitive() {}
+        if (subset)
+            return a;
 
-private:
+        ObjectsMapT *objs = new ObjectsMapT(*a);
+        for (const auto& it : *b)
+            (*objs)[it.first].insert(it.second.begin(), it.second.end());
 
-    static bool comp(const std::pair<const Pointer, MemoryObjectsSetT>& a,
-                     const std::pair<const Pointer, MemoryObjectsSetT>& b)
-    {
-        return a.first.target < b.first.target;
+        return ObjectsMapPtrT(objs);
     }
 
-    std::pair<MemoryMapT::iterator, MemoryMapT::iterator>
-    getObjectRange(MemoryMapT *mm, const Pointer& ptr)
+    void mergeMaps(MemoryMapT *mm, MemoryMapT *pm, PointsToSetT *strong_update)
     {
-        std::pair<const Pointer, MemoryObjectsSetT> what(ptr, MemoryObjectsSetT());
-        return std::equal_range(mm->begin(), mm->end(), what, comp);
+        if (!strong_update) {
+            mm->merge(*pm, mergeObjects);
+            return;
+        }
+
+        // merge the whole maps (that can use the shared parts)
+        // and then put back the objects of the strongly updated
+        // pointers. Copying the map is cheap.
+        MemoryMapT old = *mm;
+        if (!mm->merge(*pm, mergeObjects))
+            return;
+
+        for (const Pointer& ptr : *strong_update)
+            restoreObjects(mm, old, ptr);
     }
 
-    void mergeMaps(MemoryMapT *mm, MemoryMapT *pm, PointsToSetT *strong_update)
+    static void restoreObjects(MemoryMapT *mm, const MemoryMapT& old,
+                               const Pointer& ptr)
     {
-        for (auto& it : *pm) {
-            const Pointer& ptr = it.first;
-            if (strong_update && strong_update->count(ptr))
-                continue;
-
-            MemoryObjectsSetT& S = (*mm)[ptr];
-            S.insert(it.second.begin(), it.second.end());
-        }
+        const ObjectsMapPtrT *cur = mm->find(ptr.target);
+        const ObjectsMapPtrT *prev = old.find(ptr.target);
+        if (!cur || (prev && *cur == *prev))
+            return;
+
+        auto cit = (*cur)->find(ptr);
+        bool had = prev && (*prev)->count(ptr) > 0;
+        if (cit == (*cur)->end() && !had)
+            return;
+        if (had && cit != (*cur)->end()
+            && cit->second == (*prev)->find(ptr)->second)
+            return;
+
+        ObjectsMapT *objs = new ObjectsMapT(**cur);
+        if (had)
+            (*objs)[ptr] = (*prev)->find(ptr)->second;
+        else
+            objs->erase(ptr);
+
+        if (objs->empty()) {
+            delete objs;
+            mm->erase(ptr.target);
+        } else
+            mm->set(ptr.target, ObjectsMapPtrT(objs));
     }
 };
 
@@ -0,0 +1,477 @@
+#ifndef _DG_ANALYSIS_POINTS_TO_FLOW_SENSITIVE_SPARSE_H_
+#define _DG_ANALYSIS_POINTS_TO_FLOW_SENSITIVE_SPARSE_H_
+
+#include <cassert>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Pointer.h"
+#include "PointerSubgraph.h"
+#include "PointerAnalysis.h"
+#include "PointsToFlowInsensitive.h"
+#include "PointsToFlowSensitive.h"
+#include "ADT/PersistentHashMap.h"
+
+namespace dg {
+namespace analysis {
+namespace pta {
+
+// Flow-sensitive pointer analysis that does not push the memory maps
+// along every edge of the PointerSubgraph. It works in stages:
+//
+//  1) run the flow-insensitive analysis to find out which memory
+//     (allocation sites) every STORE and MEMCPY may define
+//  2) compute which of these definitions reach every node
+//     (for every allocation site) - these are sparse def-use chains
+//     for the memory, like memory SSA
+//  3) run the flow-sensitive analysis where the memory objects are
+//     kept only in the definitions and the uses of memory take them
+//     directly from the definitions that reach them. A changed node
+//     is followed only by the nodes that use its pointers (operands)
+//     or its memory (the def-use chains), not by all the nodes
+//     behind it in the PointerSubgraph
+//
+// The results are the same as with PointsToFlowSensitive, with one
+// exception - the calls via function pointers are resolved using the
+// flow-insensitive results.
+class PointsToFlowSensitiveSparse : public PointerAnalysis
+{
+public:
+    typedef PointsToFlowSensitive::MemoryObjectsSetT MemoryObjectsSetT;
+    typedef PointsToFlowSensitive::ObjectsMapT ObjectsMapT;
+    typedef PointsToFlowSensitive::ObjectsMapPtrT ObjectsMapPtrT;
+    typedef PointsToFlowSensitive::MemoryMapT MemoryMapT;
+
+    // definitions of memory (sorted)
+    typedef std::shared_ptr<const std::vector<PSNode *> > DefsPtrT;
+    // allocation site -> definitions of its memory
+    typedef ADT::PersistentHashMap<PSNode *, DefsPtrT> DefsMapT;
+
+    PointsToFlowSensitiveSparse(PointerSubgraph *ps)
+    : PointerAnalysis(ps, UNKNOWN_OFFSET, false) {}
+
+    virtual void run()
+    {
+        runFlowInsensitive();
+        computeReachingDefinitions();
+        computeUses();
+
+        PointerSubgraph *PS = getPS();
+        for (PSNode *n : PS->getNodes(PS->getRoot()))
+            queue(n);
+
+        while (!worklist.empty()) {
+            PSNode *n = worklist.pop();
+            queued.erase(n);
+
+            processWithHooks(n);
+        }
+    }
+
+    // the pointers or the memory of the node changed,
+    // process the nodes that use them
+    virtual void enqueue(PSNode *n)
+    {
+        auto it = users.find(n);
+        if (it != users.end()) {
+            for (PSNode *user : it->second)
+                queue(user);
+        }
+
+        auto iit = infos.find(n);
+        if (iit != infos.end()) {
+            for (PSNode *use : iit->second.uses)
+                queue(use);
+        }
+    }
+
+    virtual void beforeProcessed(PSNode *n)
+    {
+        if (n->getType() != pta::STORE && n->getType() != pta::MEMCPY)
+            return;
+
+        NodeInfo& info = infos[n];
+        if (!info.initialized) {
+            info.initialized = true;
+
+            // create empty memory object so that STORE (MEMCPY)
+            // can store the pointers into it
+            for (const Pointer& ptr : n->getOperand(1)->pointsTo)
+                addMemoryObject(info.memory, ptr, newMemoryObject(ptr.target));
+        }
+
+        // every store is strong update
+        // FIXME: memcpy can be strong update too
+        const PointsToSetT *strong_update = nullptr;
+        if (n->getType() == pta::STORE)
+            strong_update = &n->getOperand(1)->pointsTo;
+
+        // gather the objects from the definitions that reach this node
+        bool changed = false;
+        for (PSNode *target : info.defines) {
+            const DefsPtrT *defs = info.reaching.find(target);
+            if (!defs)
+                continue;
+
+            for (PSNode *def : **defs)
+                changed |= mergeObjects(info.memory, target,
+                                        infos[def].memory, strong_update);
+        }
+
+        // the uses of this definition must be processed again
+        if (changed)
+            enqueue(n);
+    }
+
+    virtual void getMemoryObjects(PSNode *where, const Pointer& pointer,
+                                  std::vector<MemoryObject *>& objects)
+    {
+        auto it = infos.find(where);
+        if (it == infos.end())
+            return;
+
+        NodeInfo& info = it->second;
+        PSNode *target = pointer.target;
+
+        // the node defines the memory itself
+        const ObjectsMapPtrT *objs = info.memory.find(target);
+        if (objs) {
+            addObjects(**objs, objects);
+            return;
+        }
+
+        const DefsPtrT *defs = info.reaching.find(target);
+        if (!defs)
+            return;
+
+        size_t start = objects.size();
+        for (PSNode *def : **defs) {
+            objs = infos[def].memory.find(target);
+            if (objs)
+                addObjects(**objs, objects);
+        }
+
+        // more definitions can have the same objects
+        std::sort(objects.begin() + start, objects.end());
+        objects.erase(std::unique(objects.begin() + start, objects.end()),
+                      objects.end());
+    }
+
+protected:
+    PointsToFlowSensitiveSparse() {}
+
+private:
+    struct NodeInfo {
+        // the definitions of memory that reach the node
+        DefsMapT reaching;
+        // the memory (allocation sites) that the node may define
+        // (according to the flow-insensitive analysis)
+        std::vector<PSNode *> defines;
+        // the memory (allocation sites) that the node may read
+        // (according to the flow-insensitive analysis)
+        std::vector<PSNode *> reads;
+        // the nodes that read or merge the memory defined by this node
+        std::vector<PSNode *> uses;
+        // the memory objects for the memory defined by the node
+        MemoryMapT memory;
+        bool initialized;
+
+        NodeInfo() : initialized(false) {}
+    };
+
+    std::unordered_map<PSNode *, NodeInfo> infos;
+    // the nodes that have the node as an operand
+    std::unordered_map<PSNode *, std::vector<PSNode *> > users;
+
+    ADT::QueueFIFO<PSNode *> worklist;
+    std::set<PSNode *> queued;
+
+    void queue(PSNode *n)
+    {
+        if (queued.insert(n).second)
+            worklist.push(n);
+    }
+
+    // the flow-insensitive analysis that builds the same
+    // subgraphs for calls via function pointers as this analysis
+    class PreAnalysis : public PointsToFlowInsensitive
+    {
+        PointsToFlowSensitiveSparse *parent;
+
+    public:
+        PreAnalysis(PointerSubgraph *ps, PointsToFlowSensitiveSparse *p)
+        : PointsToFlowInsensitive(ps, false), parent(p) {}
+
+        virtual bool functionPointerCall(PSNode *where, PSNode *what)
+        {
+            return parent->functionPointerCall(where, what);
+        }
+
+        virtual bool error(PSNode *at, const char *msg)
+        {
+            return parent->error(at, msg);
+        }
+
+        virtual bool errorEmptyPointsTo(PSNode *from, PSNode *to)
+        {
+            return parent->errorEmptyPointsTo(from, to);
+        }
+    };
+
+    static bool hasInitialPointsTo(PSNode *n)
+    {
+        switch (n->getType()) {
+            case ALLOC:
+            case DYN_ALLOC:
+            case FUNCTION:
+            case CONSTANT:
+            case NULL_ADDR:
+            case UNKNOWN_MEM:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void runFlowInsensitive()
+    {
+        PointerSubgraph *PS = getPS();
+
+        {
+            PreAnalysis FI(PS, this);
+            FI.run();
+        }
+
+        for (PSNode *n : PS->getNodes(PS->getRoot())) {
+            if (n->getType() == pta::STORE || n->getType() == pta::MEMCPY)
+                getTargets(n->getOperand(1), infos[n].defines);
+            if (n->getType() == pta::LOAD || n->getType() == pta::MEMCPY)
+                getTargets(n->getOperand(0), infos[n].reads);
+        }
+
+        // start from scratch, but keep the pointers of calls
+        // via function pointers, so that we do not build
+        // the subgraphs for the called functions again
+        for (PSNode *n : PS->getNodes(PS->getRoot())) {
+            if (n->getType() == pta::CALL_FUNCPTR) {
+                // the backend sets unknown pointer to return
+                // values of undefined functions
+                PSNode *ret = n->getPairedNode();
+                if (ret && !hasInitialPointsTo(ret)) {
+                    bool unknown = ret->doesPointsTo(PointerUnknown);
+                    ret->pointsTo.clear();
+                    if (unknown)
+                        ret->addPointsTo(PointerUnknown);
+                }
+            } else if (!hasInitialPointsTo(n)
+                       && (!n->getPairedNode()
+                           || n->getPairedNode()->getType() != pta::CALL_FUNCPTR)) {
+                n->pointsTo.clear();
+            }
+        }
+    }
+
+    static void getTargets(PSNode *op, std::vector<PSNode *>& targets)
+    {
+        for (const Pointer& ptr : op->pointsTo)
+            targets.push_back(ptr.target);
+
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()),
+                      targets.end());
+    }
+
+    // compute the def-use chains along which the analysis goes:
+    // the users of the pointers of nodes and the uses of the memory
+    // defined by STORE and MEMCPY (the LOAD and MEMCPY that read it
+    // and the definitions that take the objects from it)
+    void computeUses()
+    {
+        PointerSubgraph *PS = getPS();
+        for (PSNode *n : PS->getNodes(PS->getRoot())) {
+            for (PSNode *op : n->getOperands())
+                users[op].push_back(n);
+
+            auto it = infos.find(n);
+            if (it == infos.end())
+                continue;
+
+            NodeInfo& info = it->second;
+            for (const std::vector<PSNode *> *targets
+                    : {&info.reads, &info.defines}) {
+                for (PSNode *target : *targets) {
+                    const DefsPtrT *defs = info.reaching.find(target);
+                    if (!defs)
+                        continue;
+
+                    for (PSNode *def : **defs)
+                        infos[def].uses.push_back(n);
+                }
+            }
+        }
+
+        for (auto& it : infos) {
+            std::vector<PSNode *>& uses = it.second.uses;
+            std::sort(uses.begin(), uses.end());
+            uses.erase(std::unique(uses.begin(), uses.end()), uses.end());
+        }
+    }
+
+    // merge two sorted vectors of definitions,
+    // return @a if there's nothing new in @b
+    static DefsPtrT mergeDefs(const DefsPtrT& a, const DefsPtrT& b)
+    {
+        if (a == b || std::includes(a->begin(), a->end(),
+                                    b->begin(), b->end()))
+            return a;
+
+        std::vector<PSNode *> *defs = new std::vector<PSNode *>();
+        std::set_union(a->begin(), a->end(), b->begin(), b->end(),
+                       std::back_inserter(*defs));
+        return DefsPtrT(defs);
+    }
+
+    // compute the definitions of memory reaching every node
+    // (as a forward data-flow analysis on the PointerSubgraph)
+    void computeReachingDefinitions()
+    {
+        PointerSubgraph *PS = getPS();
+        std::vector<PSNode *> nodes = PS->getNodes(PS->getRoot());
+
+        // the definitions after a node
+        std::unordered_map<PSNode *, DefsMapT> out;
+
+        ADT::QueueFIFO<PSNode *> queue;
+        std::set<PSNode *> queued;
+        for (PSNode *n : nodes) {
+            queue.push(n);
+            queued.insert(n);
+        }
+
+        while (!queue.empty()) {
+            PSNode *n = queue.pop();
+            queued.erase(n);
+
+            NodeInfo& info = infos[n];
+            for (PSNode *pred : n->getPredecessors()) {
+                auto it = out.find(pred);
+                if (it != out.end())
+                    info.reaching.merge(it->second, mergeDefs);
+            }
+
+            DefsMapT new_out = info.reaching;
+            if (!info.defines.empty()) {
+                DefsPtrT self(new std::vector<PSNode *>(1, n));
+                for (PSNode *target : info.defines)
+                    new_out.set(target, self);
+            }
+
+            auto it = out.find(n);
+            if (it != out.end() && definitionsEqual(it->second, new_out))
+                continue;
+
+            out[n] = new_out;
+            for (PSNode *succ : n->getSuccessors()) {
+                if (queued.insert(succ).second)
+                    queue.push(succ);
+            }
+        }
+    }
+
+    // the maps are equal if they share the trie or if they have
+    // the same definitions (the definitions of a node are
+    // created again, so the maps do not share them)
+    static bool definitionsEqual(const DefsMapT& a, const DefsMapT& b)
+    {
+        if (a.shares(b))
+            return true;
+
+        size_t num = 0;
+        for (const auto& it : a) {
+            const DefsPtrT *defs = b.find(it.first);
+            if (!defs || **defs != *it.second)
+                return false;
+            ++num;
+        }
+
+        for (const auto& it : b) {
+            (void) it;
+            if (num-- == 0)
+                return false;
+        }
+
+        return num == 0;
+    }
+
+    // the memory objects are owned by the PointerSubgraph
+    MemoryObject *newMemoryObject(PSNode *target)
+    {
+        return getPS()->createObject<MemoryObject>(target);
+    }
+
+    static void addMemoryObject(MemoryMapT& mm, const Pointer& ptr,
+                                MemoryObject *mo)
+    {
+        const ObjectsMapPtrT *old = mm.find(ptr.target);
+        ObjectsMapT *objs = old ? new ObjectsMapT(**old) : new ObjectsMapT();
+        (*objs)[ptr].insert(mo);
+        mm.set(ptr.target, ObjectsMapPtrT(objs));
+    }
+
+    static void addObjects(const ObjectsMapT& objs,
+                           std::vector<MemoryObject *>& objects)
+    {
+        for (const auto& it : objs)
+            objects.insert(objects.end(), it.second.begin(), it.second.end());
+    }
+
+    // add the objects of the target from @from to @to, except
+    // the objects of the pointers that are strongly updated
+    static bool mergeObjects(MemoryMapT& to, PSNode *target,
+                             const MemoryMapT& from,
+                             const PointsToSetT *strong_update)
+    {
+        const ObjectsMapPtrT *src = from.find(target);
+        if (!src)
+            return false;
+
+        const ObjectsMapPtrT *dst = to.find(target);
+        if (dst && *dst == *src)
+            return false;
+
+        ObjectsMapT *objs = nullptr;
+        for (const auto& it : **src) {
+            if (strong_update && strong_update->count(it.first))
+                continue;
+
+            if (!objs) {
+                // is there anything new?
+                if (dst) {
+                    auto dit = (*dst)->find(it.first);
+                    if (dit != (*dst)->end()
+                        && std::includes(dit->second.begin(), dit->second.end(),
+                                         it.second.begin(), it.second.end()))
+                        continue;
+                }
+
+                objs = dst ? new ObjectsMapT(**dst) : new ObjectsMapT();
+            }
+
+            (*objs)[it.first].insert(it.second.begin(), it.second.end());
+        }
+
+        if (!objs)
+            return false;
+
+        to.set(target, ObjectsMapPtrT(objs));
+        return true;
+    }
+};
+
+} // namespace pta
+} // namespace analysis
+} // namespace dg
+
+#endif // _DG_ANALYSIS_POINTS_TO_FLOW_SENSITIVE_SPARSE_H_
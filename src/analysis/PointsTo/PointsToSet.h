@@ -0,0 +1,558 @@
+#ifndef _DG_POINTS_TO_SET_H_
+#define _DG_POINTS_TO_SET_H_
+
+#include <cassert>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "ADT/SparseBitvector.h"
+
+namespace dg {
+namespace analysis {
+namespace pta {
+
+// Mapping between pointers and dense numbers. It is shared by all
+// the points-to sets that are based on bitvectors, so that we can do
+// the operations on sets on the level of bitvectors. The numbers are
+// never released, the table grows with the number of different pointers
+// that has been ever created. NOTE: it is not thread-safe.
+template <typename PointerT>
+class PointerIdTable
+{
+    struct PointerHash {
+        size_t operator()(const PointerT& ptr) const
+        {
+            return std::hash<const void *>()(ptr.target)
+                    ^ (std::hash<uint64_t>()(*ptr.offset) << 1);
+        }
+    };
+
+    std::unordered_map<PointerT, size_t, PointerHash> ids;
+    // we use deque, so that the references that we return
+    // from iterators are not invalidated by adding new pointers
+    std::deque<PointerT> pointers;
+
+    static PointerIdTable& get()
+    {
+        static PointerIdTable table;
+        return table;
+    }
+
+public:
+    static size_t getOrCreateId(const PointerT& ptr)
+    {
+        PointerIdTable& table = get();
+        auto it = table.ids.find(ptr);
+        if (it != table.ids.end())
+            return it->second;
+
+        size_t id = table.pointers.size();
+        table.pointers.push_back(ptr);
+        table.ids.emplace(ptr, id);
+
+        return id;
+    }
+
+    // return false if the pointer has not been assigned any id yet
+    // (and thus it cannot be in any set)
+    static bool getId(const PointerT& ptr, size_t& id)
+    {
+        PointerIdTable& table = get();
+        auto it = table.ids.find(ptr);
+        if (it == table.ids.end())
+            return false;
+
+        id = it->second;
+        return true;
+    }
+
+    static const PointerT& getPointer(size_t id)
+    {
+        return get().pointers[id];
+    }
+
+    // iterator over bitvector that yields pointers instead of numbers
+    class const_iterator
+    {
+        ADT::SparseBitvector::const_iterator it;
+
+    public:
+        const_iterator(const ADT::SparseBitvector::const_iterator& i)
+        : it(i) {}
+
+        const PointerT& operator*() const
+        {
+            return getPointer(*it);
+        }
+
+        const PointerT *operator->() const
+        {
+            return &getPointer(*it);
+        }
+
+        const_iterator& operator++()
+        {
+            ++it;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator tmp = *this;
+            ++it;
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& oth) const { return it == oth.it; }
+        bool operator!=(const const_iterator& oth) const { return it != oth.it; }
+    };
+};
+
+// Points-to set that maps every pointer (target, offset) to a dense
+// number and keeps the numbers in a sparse bitvector. That way
+// the set takes a few words instead of a tree node per pointer
+// and union of two sets (the most common operation in the
+// analysis) is done word by word.
+//
+// It mimics the interface of std::set<Pointer> that is used
+// throughout the analysis, so that these two representations
+// can be interchanged (see ENABLE_SPARSE_PTSETS)
+template <typename PointerT>
+class SparseBitvectorPointsToSet
+{
+    typedef PointerIdTable<PointerT> IdTable;
+
+    ADT::SparseBitvector bits;
+
+public:
+    typedef typename IdTable::const_iterator const_iterator;
+    typedef const_iterator iterator;
+    typedef PointerT value_type;
+
+    std::pair<const_iterator, bool> insert(const PointerT& ptr)
+    {
+        size_t id = IdTable::getOrCreateId(ptr);
+        bool changed = bits.set(id);
+        return std::make_pair(const_iterator(bits.find(id)), changed);
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+            bits.set(IdTable::getOrCreateId(*first));
+    }
+
+    // union, return true if this set changed
+    bool add(const SparseBitvectorPointsToSet& oth)
+    {
+        return bits.set(oth.bits);
+    }
+
+    // intersection, return true if this set changed
+    bool intersect(const SparseBitvectorPointsToSet& oth)
+    {
+        return bits.intersect(oth.bits);
+    }
+
+    // set difference, return true if this set changed
+    bool remove(const SparseBitvectorPointsToSet& oth)
+    {
+        return bits.unset(oth.bits);
+    }
+
+    bool intersects(const SparseBitvectorPointsToSet& oth) const
+    {
+        return bits.intersects(oth.bits);
+    }
+
+    bool isSubsetOf(const SparseBitvectorPointsToSet& oth) const
+    {
+        return bits.isSubsetOf(oth.bits);
+    }
+
+    size_t erase(const PointerT& ptr)
+    {
+        size_t id;
+        if (!IdTable::getId(ptr, id))
+            return 0;
+
+        return bits.unset(id);
+    }
+
+    size_t count(const PointerT& ptr) const
+    {
+        size_t id;
+        if (!IdTable::getId(ptr, id))
+            return 0;
+
+        return bits.get(id);
+    }
+
+    const_iterator find(const PointerT& ptr) const
+    {
+        size_t id;
+        if (!IdTable::getId(ptr, id) || !bits.get(id))
+            return end();
+
+        return const_iterator(bits.find(id));
+    }
+
+    bool empty() const { return bits.empty(); }
+    size_t size() const { return bits.size(); }
+    void clear() { bits.clear(); }
+    void swap(SparseBitvectorPointsToSet& oth) { bits.swap(oth.bits); }
+
+    bool operator==(const SparseBitvectorPointsToSet& oth) const
+    {
+        return bits == oth.bits;
+    }
+
+    bool operator!=(const SparseBitvectorPointsToSet& oth) const
+    {
+        return bits != oth.bits;
+    }
+
+    const_iterator begin() const { return const_iterator(bits.begin()); }
+    const_iterator end() const { return const_iterator(bits.end()); }
+
+    const ADT::SparseBitvector& getBits() const { return bits; }
+};
+
+// Hash-consed points-to set. Equal sets are stored only once
+// in a table of interned bitvectors and the set is just a handle
+// to the table. Copying the set (propagation along copy-like edges
+// -- CAST, PHI, CALL_RETURN, ...) is thus just a handle assignment.
+// The interned sets are immutable, every change of the set
+// creates (or looks up) another interned set. Results of unions
+// are memoized, so repeated union of the same sets is a table lookup.
+//
+// The interned sets are reference counted and released when
+// no set refers to them anymore. The memo table holds references too,
+// so it is flushed when it grows too big. NOTE: it is not thread-safe.
+template <typename PointerT>
+class SharedPointsToSet
+{
+    typedef PointerIdTable<PointerT> IdTable;
+
+    struct Entry {
+        const ADT::SparseBitvector bits;
+        const size_t hash;
+        unsigned refcount;
+
+        Entry(ADT::SparseBitvector& b)
+        : bits(std::move(b)), hash(bits.hash()), refcount(0) {}
+    };
+
+    struct EntryHash {
+        size_t operator()(const Entry *e) const { return e->hash; }
+    };
+
+    struct EntryEq {
+        bool operator()(const Entry *a, const Entry *b) const
+        {
+            return a->hash == b->hash && a->bits == b->bits;
+        }
+    };
+
+    struct PairHash {
+        size_t operator()(const std::pair<Entry *, Entry *>& p) const
+        {
+            return std::hash<Entry *>()(p.first)
+                    ^ (std::hash<Entry *>()(p.second) << 1);
+        }
+    };
+
+    // flush the memoized unions when there are more of them,
+    // so that the memo table does not keep alive too many sets
+    static const size_t MAX_MEMOIZED_UNIONS = 1 << 16;
+
+    struct SetsTable {
+        std::unordered_set<Entry *, EntryHash, EntryEq> sets;
+        std::unordered_map<std::pair<Entry *, Entry *>, Entry *, PairHash> unions;
+    };
+
+    static SetsTable& getTable()
+    {
+        // the table is never destroyed, so that the sets that
+        // are destroyed after it (e.g. global objects) are still valid
+        static SetsTable *table = new SetsTable();
+        return *table;
+    }
+
+    static Entry *ref(Entry *e)
+    {
+        if (e)
+            ++e->refcount;
+        return e;
+    }
+
+    static void unref(Entry *e)
+    {
+        if (!e || --e->refcount > 0)
+            return;
+
+        getTable().sets.erase(e);
+        delete e;
+    }
+
+    // get the interned set for the bitvector, take the bitvector
+    static Entry *intern(ADT::SparseBitvector& bits)
+    {
+        // empty set is represented by nullptr
+        if (bits.empty())
+            return nullptr;
+
+        Entry *e = new Entry(bits);
+        auto it = getTable().sets.insert(e);
+        if (!it.second)
+            delete e;
+
+        return *it.first;
+    }
+
+    static Entry *memoizedUnion(Entry *a, Entry *b)
+    {
+        // union is commutative, so use only one order of the pair
+        if (b < a)
+            std::swap(a, b);
+
+        SetsTable& table = getTable();
+        auto key = std::make_pair(a, b);
+        auto it = table.unions.find(key);
+        if (it != table.unions.end())
+            return it->second;
+
+        // flush before interning the result - the interned set may be
+        // referenced only by the memo table and flushing would release it
+        if (table.unions.size() >= MAX_MEMOIZED_UNIONS)
+            flushUnions();
+
+        ADT::SparseBitvector tmp = a->bits;
+        tmp.set(b->bits);
+        Entry *result = intern(tmp);
+
+        // the memo table holds references to all the sets in it,
+        // so that the sets cannot be released and the pointers reused
+        ref(a);
+        ref(b);
+        table.unions.emplace(key, ref(result));
+        return result;
+    }
+
+    static void flushUnions()
+    {
+        SetsTable& table = getTable();
+        auto unions = std::move(table.unions);
+        table.unions.clear();
+
+        for (auto& it : unions) {
+            unref(it.first.first);
+            unref(it.first.second);
+            unref(it.second);
+        }
+    }
+
+    static const ADT::SparseBitvector& emptyBits()
+    {
+        static const ADT::SparseBitvector empty;
+        return empty;
+    }
+
+    Entry *entry;
+
+    void assign(Entry *e)
+    {
+        if (e == entry)
+            return;
+
+        ref(e);
+        unref(entry);
+        entry = e;
+    }
+
+    // replace the set with the given bitvector
+    void assign(ADT::SparseBitvector& bits)
+    {
+        assign(intern(bits));
+    }
+
+public:
+    typedef typename IdTable::const_iterator const_iterator;
+    typedef const_iterator iterator;
+    typedef PointerT value_type;
+
+    SharedPointsToSet() : entry(nullptr) {}
+    SharedPointsToSet(const SharedPointsToSet& oth) : entry(ref(oth.entry)) {}
+    SharedPointsToSet(SharedPointsToSet&& oth) : entry(oth.entry)
+    {
+        oth.entry = nullptr;
+    }
+
+    ~SharedPointsToSet() { unref(entry); }
+
+    SharedPointsToSet& operator=(const SharedPointsToSet& oth)
+    {
+        assign(oth.entry);
+        return *this;
+    }
+
+    SharedPointsToSet& operator=(SharedPointsToSet&& oth)
+    {
+        std::swap(entry, oth.entry);
+        return *this;
+    }
+
+    std::pair<const_iterator, bool> insert(const PointerT& ptr)
+    {
+        size_t id = IdTable::getOrCreateId(ptr);
+        if (getBits().get(id))
+            return std::make_pair(const_iterator(getBits().find(id)), false);
+
+        ADT::SparseBitvector tmp = getBits();
+        tmp.set(id);
+        assign(tmp);
+
+        return std::make_pair(const_iterator(getBits().find(id)), true);
+    }
+
+    // insert more pointers at once, so that only the result is interned
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        ADT::SparseBitvector tmp = getBits();
+        bool changed = false;
+        for (; first != last; ++first)
+            changed |= tmp.set(IdTable::getOrCreateId(*first));
+
+        if (changed)
+            assign(tmp);
+    }
+
+    // union, return true if this set changed
+    bool add(const SharedPointsToSet& oth)
+    {
+        if (!oth.entry || oth.entry == entry)
+            return false;
+
+        if (!entry) {
+            assign(oth.entry);
+            return true;
+        }
+
+        Entry *result = memoizedUnion(entry, oth.entry);
+        if (result == entry)
+            return false;
+
+        assign(result);
+        return true;
+    }
+
+    // intersection, return true if this set changed
+    bool intersect(const SharedPointsToSet& oth)
+    {
+        if (oth.entry == entry)
+            return false;
+
+        ADT::SparseBitvector tmp = getBits();
+        if (!tmp.intersect(oth.getBits()))
+            return false;
+
+        assign(tmp);
+        return true;
+    }
+
+    // set difference, return true if this set changed
+    bool remove(const SharedPointsToSet& oth)
+    {
+        if (!intersects(oth))
+            return false;
+
+        ADT::SparseBitvector tmp = getBits();
+        tmp.unset(oth.getBits());
+        assign(tmp);
+        return true;
+    }
+
+    bool intersects(const SharedPointsToSet& oth) const
+    {
+        if (!entry || !oth.entry)
+            return false;
+
+        return entry == oth.entry || entry->bits.intersects(oth.entry->bits);
+    }
+
+    bool isSubsetOf(const SharedPointsToSet& oth) const
+    {
+        if (!entry || entry == oth.entry)
+            return true;
+
+        return entry->bits.isSubsetOf(oth.getBits());
+    }
+
+    size_t erase(const PointerT& ptr)
+    {
+        size_t id;
+        if (!IdTable::getId(ptr, id) || !getBits().get(id))
+            return 0;
+
+        ADT::SparseBitvector tmp = getBits();
+        tmp.unset(id);
+        assign(tmp);
+        return 1;
+    }
+
+    size_t count(const PointerT& ptr) const
+    {
+        size_t id;
+        if (!IdTable::getId(ptr, id))
+            return 0;
+
+        return getBits().get(id);
+    }
+
+    const_iterator find(const PointerT& ptr) const
+    {
+        size_t id;
+        if (!IdTable::getId(ptr, id) || !getBits().get(id))
+            return end();
+
+        return const_iterator(getBits().find(id));
+    }
+
+    bool empty() const { return entry == nullptr; }
+    size_t size() const { return getBits().size(); }
+    void clear() { assign(static_cast<Entry *>(nullptr)); }
+    void swap(SharedPointsToSet& oth) { std::swap(entry, oth.entry); }
+
+    // equal sets are interned only once, so comparing handles is enough
+    bool operator==(const SharedPointsToSet& oth) const
+    {
+        return entry == oth.entry;
+    }
+
+    bool operator!=(const SharedPointsToSet& oth) const
+    {
+        return entry != oth.entry;
+    }
+
+    const_iterator begin() const { return const_iterator(getBits().begin()); }
+    const_iterator end() const { return const_iterator(getBits().end()); }
+
+    const ADT::SparseBitvector& getBits() const
+    {
+        return entry ? entry->bits : emptyBits();
+    }
+
+    // the number of different sets that are stored, for statistics
+    static size_t getInternedSetsNum() { return getTable().sets.size(); }
+};
+
+} // namespace pta
+} // namespace analysis
+} // namespace dg
+
+#endif // _DG_POINTS_TO_SET_H_
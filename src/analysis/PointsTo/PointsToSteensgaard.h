@@ -0,0 +1,224 @@
+#ifndef _DG_ANALYSIS_POINTS_TO_STEENSGAARD_H_
+#define _DG_ANALYSIS_POINTS_TO_STEENSGAARD_H_
+
+#include <cassert>
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Pointer.h"
+#include "PointerSubgraph.h"
+#include "PointerAnalysis.h"
+#include "PointsToFlowInsensitive.h"
+#include "SteensgaardClasses.h"
+
+namespace dg {
+namespace analysis {
+namespace pta {
+
+// Unification-based (Steensgaard's) pointer analysis (see
+// SteensgaardClasses). The analysis runs in almost linear time
+// in the size of the PointerSubgraph, but it is much less precise
+// than the inclusion-based analyses (it is field-insensitive,
+// all pointers to memory have unknown offset).
+//
+// The results are an over-approximation of the results of
+// PointsToFlowInsensitive, therefore the memory in different classes
+// cannot be aliased and the classes can be used to split the work
+// for the more precise analyses (see getAliasClasses() and
+// PointerAnalysis::setAliasClassesScheduling()).
+class PointsToSteensgaard : public PointsToFlowInsensitive
+{
+public:
+    PointsToSteensgaard(PointerSubgraph *ps)
+    : PointsToFlowInsensitive(ps, false) {}
+
+    virtual void run()
+    {
+        PointerSubgraph *PS = getPS();
+        std::vector<PSNode *> nodes;
+        std::vector<PSNode *> funcptr_calls;
+        std::vector<PSNode *> loads;
+        std::set<std::pair<PSNode *, PSNode *> > called;
+
+        bool changed;
+        do {
+            // unification is idempotent, so after building
+            // new subgraphs for calls via function pointers
+            // we can just go over all the nodes again
+            nodes = PS->getNodes(PS->getRoot());
+            funcptr_calls.clear();
+            loads.clear();
+            for (PSNode *n : nodes) {
+                classes.unify(n);
+                if (n->getType() == CALL_FUNCPTR)
+                    funcptr_calls.push_back(n);
+                else if (n->getType() == LOAD)
+                    loads.push_back(n);
+            }
+
+            // with the saturation, the pointers stored via a pointer
+            // to unknown memory may be stored anywhere, so every load
+            // may read them (as in PointerAnalysis::loadStoredViaUnknown())
+            unsigned unknown = classes.getAliasClass(UNKNOWN_MEMORY);
+            if (getSaturateUnknown() && unknown != SteensgaardClasses::NONE) {
+                for (PSNode *load : loads)
+                    classes.join(classes.getId(load),
+                                 classes.getPointee(unknown));
+            }
+
+            changed = false;
+            for (PSNode *call : funcptr_calls) {
+                // copy the objects, the call may change the classes
+                std::vector<PSNode *> targets
+                    = classes.getObjects(classes.getId(call->getOperand(0)));
+                for (PSNode *target : targets) {
+                    if (target->getType() != FUNCTION)
+                        continue;
+
+                    if (called.insert(std::make_pair(call, target)).second
+                        && functionPointerCall(call, target)) {
+                        changed = true;
+                        // the backend may set pointers of the return site
+                        if (PSNode *ret = call->getPairedNode())
+                            classes.joinPointsTo(ret);
+                    }
+                }
+            }
+
+            if (changed)
+                PS->structureChanged();
+        } while (changed);
+
+        addZeroInitialized();
+        setPointsTo(nodes);
+    }
+
+    // the alias class of the memory pointed by the node,
+    // pointers to memory in different classes cannot alias.
+    // Returns ~0u for the nodes that the analysis does not know
+    unsigned getAliasClass(PSNode *n)
+    {
+        return classes.getAliasClass(n);
+    }
+
+    // get the allocation sites partitioned into the alias classes
+    void getAliasClasses(std::vector<std::vector<PSNode *> >& cls)
+    {
+        classes.getAliasClasses(cls);
+    }
+
+    size_t getAliasClassesNum()
+    {
+        return classes.getAliasClassesNum();
+    }
+
+private:
+    SteensgaardClasses classes;
+
+    static bool hasObject(const std::vector<PSNode *>& objs, PSNode *n)
+    {
+        return std::find(objs.begin(), objs.end(), n) != objs.end();
+    }
+
+    // loading from zero-initialized memory yields null
+    void addZeroInitialized()
+    {
+        std::set<unsigned> zeroed;
+        for (auto& it : classes.getIds()) {
+            if (SteensgaardClasses::isObject(it.first)
+                && it.first->isZeroInitialized())
+                zeroed.insert(classes.find(it.second));
+        }
+
+        std::vector<PSNode *> memcpys;
+        for (auto& it : classes.getIds()) {
+            if (it.first->getType() == MEMCPY)
+                memcpys.push_back(it.first);
+        }
+
+        // memcpy copies zeroed memory
+        bool changed;
+        do {
+            changed = false;
+            for (PSNode *n : memcpys) {
+                if (zeroed.count(classes.getAliasClass(n->getOperand(0))) > 0)
+                    changed |= zeroed.insert(
+                        classes.getAliasClass(n->getOperand(1))).second;
+            }
+        } while (changed);
+
+        for (unsigned c : zeroed) {
+            std::vector<PSNode *>& objs
+                = classes.getObjects(classes.getPointee(c));
+            if (!hasObject(objs, NULLPTR))
+                objs.push_back(NULLPTR);
+        }
+    }
+
+    static Pointer getPointer(PSNode *target)
+    {
+        if (target->getType() == NULL_ADDR || target->getType() == FUNCTION)
+            return Pointer(target, 0);
+
+        return Pointer(target, UNKNOWN_OFFSET);
+    }
+
+    // store the results into the nodes and memory objects
+    void setPointsTo(const std::vector<PSNode *>& nodes)
+    {
+        // the points-to sets of the classes
+        std::unordered_map<unsigned, PointsToSetT> sets;
+        auto getSet = [this, &sets](unsigned c) -> const PointsToSetT& {
+            c = classes.find(c);
+            auto it = sets.find(c);
+            if (it != sets.end())
+                return it->second;
+
+            PointsToSetT& S = sets[c];
+            for (PSNode *target : classes.getObjects(c))
+                S.insert(getPointer(target));
+
+            // the class with unknown memory may be anything
+            if (getSaturateUnknown() && isTopSet(S))
+                makeTopSet(S);
+            return S;
+        };
+
+        for (auto& it : classes.getIds()) {
+            PSNode *n = it.first;
+            if (SteensgaardClasses::isObject(n) || n->getType() == CONSTANT)
+                continue;
+
+            n->pointsTo = getSet(it.second);
+        }
+
+        // the memory of allocation sites
+        std::vector<MemoryObject *> mos;
+        for (PSNode *n : nodes) {
+            if (n->getType() != ALLOC && n->getType() != DYN_ALLOC)
+                continue;
+
+            unsigned p = classes.getStored(classes.getId(n));
+            if (p == SteensgaardClasses::NONE)
+                continue;
+
+            const PointsToSetT& S = getSet(p);
+            if (S.empty())
+                continue;
+
+            mos.clear();
+            getMemoryObjects(n, Pointer(n, 0), mos);
+            for (MemoryObject *mo : mos)
+                mo->addPointsTo(UNKNOWN_OFFSET, S);
+        }
+    }
+};
+
+} // namespace pta
+} // namespace analysis
+} // namespace dg
+
+#endif // _DG_ANALYSIS_POINTS_TO_STEENSGAARD_H_
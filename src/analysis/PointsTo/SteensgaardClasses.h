@@ -0,0 +1,262 @@
+#ifndef _DG_ANALYSIS_POINTS_TO_STEENSGAARD_CLASSES_H_
+#define _DG_ANALYSIS_POINTS_TO_STEENSGAARD_CLASSES_H_
+
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Pointer.h"
+#include "PointerSubgraph.h"
+
+namespace dg {
+namespace analysis {
+namespace pta {
+
+// The equivalence classes of Steensgaard's analysis. Every node gets
+// a class of memory (allocation sites) that it may point to and every
+// class has one class of memory that the pointers stored in it may
+// point to. Assignments unify the classes. The classes only read
+// the PointerSubgraph, so other analyses can compute them on the side
+// to find out what may alias (see PointsToDemandDriven) or to split
+// the nodes for solving (see PointerAnalysis::runAliasClasses()).
+class SteensgaardClasses
+{
+public:
+    enum : unsigned { NONE = ~0u };
+
+    void clear()
+    {
+        parent.clear();
+        rank.clear();
+        pointee.clear();
+        objects.clear();
+        ids.clear();
+    }
+
+    // unify the classes according to the semantics of the node
+    void unify(PSNode *n)
+    {
+        switch (n->getType()) {
+            case CAST:
+            case GEP:
+            case PHI:
+            case CALL_RETURN:
+            case RETURN:
+            case CALL_FUNCPTR:
+                // the pointers are copied (field-insensitive GEP)
+                for (PSNode *op : n->getOperands())
+                    join(getId(n), getId(op));
+                break;
+            case LOAD:
+                join(getId(n), getPointee(getId(n->getOperand(0))));
+                break;
+            case STORE:
+                join(getPointee(getId(n->getOperand(1))),
+                     getId(n->getOperand(0)));
+                break;
+            case MEMCPY:
+                join(getPointee(getId(n->getOperand(1))),
+                     getPointee(getId(n->getOperand(0))));
+                break;
+            default:
+                // create the class for the node
+                getId(n);
+                break;
+        }
+    }
+
+    // the alias class of the memory pointed by the node,
+    // pointers to memory in different classes cannot alias.
+    // Returns NONE for the nodes that were not unified
+    unsigned getAliasClass(PSNode *n)
+    {
+        auto it = ids.find(n);
+        if (it == ids.end())
+            return NONE;
+
+        return find(it->second);
+    }
+
+    // get the allocation sites partitioned into the alias classes
+    void getAliasClasses(std::vector<std::vector<PSNode *> >& classes)
+    {
+        for (unsigned i = 0; i < parent.size(); ++i) {
+            if (find(i) == i && !objects[i].empty())
+                classes.push_back(objects[i]);
+        }
+    }
+
+    size_t getAliasClassesNum()
+    {
+        size_t num = 0;
+        for (unsigned i = 0; i < parent.size(); ++i) {
+            if (find(i) == i && !objects[i].empty())
+                ++num;
+        }
+
+        return num;
+    }
+
+    unsigned find(unsigned x)
+    {
+        // path halving
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+
+        return x;
+    }
+
+    void join(unsigned a, unsigned b)
+    {
+        std::vector<std::pair<unsigned, unsigned> > work;
+        work.emplace_back(a, b);
+
+        while (!work.empty()) {
+            unsigned ra = find(work.back().first);
+            unsigned rb = find(work.back().second);
+            work.pop_back();
+
+            if (ra == rb)
+                continue;
+
+            if (rank[ra] < rank[rb])
+                std::swap(ra, rb);
+            else if (rank[ra] == rank[rb])
+                ++rank[ra];
+
+            // ra is the new representative
+            parent[rb] = ra;
+
+            if (objects[ra].size() < objects[rb].size())
+                objects[ra].swap(objects[rb]);
+            objects[ra].insert(objects[ra].end(),
+                               objects[rb].begin(), objects[rb].end());
+            objects[rb].clear();
+            objects[rb].shrink_to_fit();
+
+            // the memory pointed by the merged classes
+            // must be merged too
+            unsigned pa = pointee[ra];
+            unsigned pb = pointee[rb];
+            if (pa == NONE)
+                pointee[ra] = pb;
+            else if (pb != NONE)
+                work.emplace_back(pa, pb);
+        }
+    }
+
+    // the class of memory that the pointers stored in the class
+    // point to (created if there is none yet)
+    unsigned getPointee(unsigned c)
+    {
+        unsigned r = find(c);
+        if (pointee[r] == NONE) {
+            unsigned p = newClass();
+            pointee[r] = p;
+        }
+
+        return pointee[r];
+    }
+
+    // the same as getPointee(), but returns NONE
+    // if nothing was stored to the class
+    unsigned getStored(unsigned c)
+    {
+        return pointee[find(c)];
+    }
+
+    // allocation sites in the class
+    std::vector<PSNode *>& getObjects(unsigned c)
+    {
+        return objects[find(c)];
+    }
+
+    // node -> the class of memory it may point to
+    const std::unordered_map<PSNode *, unsigned>& getIds() const
+    {
+        return ids;
+    }
+
+    static bool isObject(PSNode *n)
+    {
+        switch (n->getType()) {
+            case ALLOC:
+            case DYN_ALLOC:
+            case FUNCTION:
+            case NULL_ADDR:
+            case UNKNOWN_MEM:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    unsigned getId(PSNode *n)
+    {
+        auto it = ids.find(n);
+        if (it != ids.end())
+            return it->second;
+
+        // constant points to the memory of its target
+        if (n->getType() == CONSTANT) {
+            assert(n->pointsTo.size() == 1);
+            unsigned id = getId(n->pointsTo.begin()->target);
+            ids.emplace(n, id);
+            return id;
+        }
+
+        unsigned id = newClass();
+        ids.emplace(n, id);
+
+        if (isObject(n))
+            objects[id].push_back(n);
+        else
+            joinPointsTo(n);
+
+        return id;
+    }
+
+    // add the pointers that the node already has
+    // (e. g. unknown pointer returned from undefined function)
+    void joinPointsTo(PSNode *n)
+    {
+        std::vector<PSNode *> targets;
+        for (const Pointer& ptr : n->pointsTo)
+            targets.push_back(ptr.target);
+
+        for (PSNode *target : targets)
+            join(getId(n), getId(target));
+    }
+
+private:
+    // the classes are numbered, the union-find is on the numbers
+    // (the classes that are only pointed to have no node)
+    std::vector<unsigned> parent;
+    std::vector<unsigned> rank;
+    // the class of memory that the pointers stored in the class point to
+    std::vector<unsigned> pointee;
+    // allocation sites in the class (in the representative only)
+    std::vector<std::vector<PSNode *> > objects;
+
+    // node -> the class of memory it may point to
+    std::unordered_map<PSNode *, unsigned> ids;
+
+    unsigned newClass()
+    {
+        unsigned id = parent.size();
+        parent.push_back(id);
+        rank.push_back(0);
+        pointee.push_back(NONE);
+        objects.emplace_back();
+        return id;
+    }
+};
+
+} // namespace pta
+} // namespace analysis
+} // namespace dg
+
+#endif // _DG_ANALYSIS_POINTS_TO_STEENSGAARD_CLASSES_H_
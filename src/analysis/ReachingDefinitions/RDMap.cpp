@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <iterator>
 
 #include "RDMap.h"
 #include "ReachingDefinitions.h"
@@ -11,14 +12,99 @@ namespace rd {
 
 class RDNode;
 
-RDMap::RDMap(const RDMap& o)
+StdRDMap::StdRDMap(const StdRDMap& o)
 {
     merge(&o);
 }
 
-static bool comp_ds(const DefSite& a, const DefSite& b)
+// the def-sites of the target in the ordered container @C
+// (the def-sites are ordered by the target first).
+// Use lower_bound() and upper_bound() of the container,
+// std::equal_range() would walk the whole container
+// since the iterators are not random-access
+template <typename ContainerT>
+static auto getTargetRange(ContainerT& C, RDNode *target)
+    -> std::pair<decltype(C.begin()), decltype(C.begin())>
 {
-    return a.target < b.target;
+    // the smallest and the greatest def-site of the target
+    // (the length of a def-site at offset 0 is never 0)
+    return std::make_pair(C.lower_bound(DefSite(target, 0, 1)),
+                          C.upper_bound(DefSite(target, UNKNOWN_OFFSET,
+                                                UNKNOWN_OFFSET)));
+}
+
+// should the definition @ds from the merged map be overwritten by
+// the definitions from @no_update (strong update)? Sets @is_unknown
+// if @no_update defines the target at unknown offset, because then
+// all the values must be kept
+static bool isOverwritten(const DefSite& ds, DefSiteSetT& no_update,
+                          bool strong_update_unknown, bool& is_unknown)
+{
+    // should we update this def-site (strong update)?
+    // but only if the offset is concrete, because if
+    // it is not concrete, we want to do weak update
+    // Also, we don't want to do strong updates for
+    // heap allocated objects, since they are all represented
+    // by the call site.
+    //
+    // If the memory is defined at unknown offset, we can
+    // still do a strong update provided this is the update
+    // of whole memory (so we need to know the size of the memory).
+    if (strong_update_unknown &&
+        is_unknown && ds.target->getSize() > 0) {
+        // get the writes that should overwrite this definition
+        auto range = getTargetRange(no_update, ds.target);
+        // XXX: we could check wether all the strong updates
+        // together overwrite the memory, but that could be
+        // to much work. Just check wether there's is just a one
+        // update that overwrites the whole memory
+        bool overwrites_whole_memory = false;
+        for (auto I = range.first; I!= range.second; ++I) {
+            const DefSite& ds2 = *I;
+            assert(ds.target == ds2.target);
+            if (*ds2.offset == 0 && *ds2.len >= ds.target->getSize()) {
+                overwrites_whole_memory = true;
+                break;
+            }
+        }
+
+        // do strong update - do not merge
+        // this definition into our map
+        if (overwrites_whole_memory)
+            return true;
+    } else if (ds.target->getType() != DYN_ALLOC) {
+        bool skip = false;
+        auto range = getTargetRange(no_update, ds.target);
+        for (auto I = range.first; I!= range.second; ++I) {
+            const DefSite& ds2 = *I;
+            assert(ds.target == ds2.target);
+            // if the 'no_update' set contains target with unknown
+            // pointer, we should always keep that value
+            // and the value being merged (just all possible definitions)
+            if (ds2.offset.isUnknown()) {
+                // break no_update skip = true, thus adding
+                // the values for UNKOWN to our map
+                is_unknown = true;
+                break;
+            }
+
+            // targets are the same, check if the what we have
+            // in 'no_update' set overwrites the values that are in
+            // the other map
+            if ((*ds.offset >= *ds2.offset)
+                && (*ds.offset + *ds.len <= *ds2.offset + *ds2.len)) {
+                skip = true;
+                break;
+            }
+        }
+
+        // if values in 'no_update' map overwrite the coresponding values
+        // in the other map, don't update our map
+        if (skip)
+            return true;
+    }
+
+    return false;
 }
 
 ///
@@ -55,11 +141,11 @@ static bool comp_ds(const DefSite& a, const DefSite& b)
 //
 // This is useful when we have a lot of concrete and unknown definitions
 // in the map
-bool RDMap::merge(const RDMap *oth,
-                  DefSiteSetT *no_update,
-                  bool strong_update_unknown,
-                  uint32_t max_set_size,
-                  bool merge_unknown)
+bool StdRDMap::merge(const StdRDMap *oth,
+                     DefSiteSetT *no_update,
+                     bool strong_update_unknown,
+                     uint32_t max_set_size,
+                     bool merge_unknown)
 {
     if (this == oth)
         return false;
@@ -71,74 +157,9 @@ bool RDMap::merge(const RDMap *oth,
 
         // STRONG UPDATE
         // --------------------
-        // should we update this def-site (strong update)?
-        // but only if the offset is concrete, because if
-        // it is not concrete, we want to do weak update
-        // Also, we don't want to do strong updates for
-        // heap allocated objects, since they are all represented
-        // by the call site
-        if (no_update) { // do we have anything for strong update at all?
-            // if the memory is defined at unknown offset, we can
-            // still do a strong update provided this is the update
-            // of whole memory (so we need to know the size of the memory).
-            if (strong_update_unknown &&
-                is_unknown && ds.target->getSize() > 0) {
-                // get the writes that should overwrite this definition
-                auto range = std::equal_range(no_update->begin(),
-                                              no_update->end(),
-                                              ds, comp_ds);
-                // XXX: we could check wether all the strong updates
-                // together overwrite the memory, but that could be
-                // to much work. Just check wether there's is just a one
-                // update that overwrites the whole memory
-                bool overwrites_whole_memory = false;
-                for (auto I = range.first; I!= range.second; ++I) {
-                    const DefSite& ds2 = *I;
-                    assert(ds.target == ds2.target);
-                    if (*ds2.offset == 0 && *ds2.len >= ds.target->getSize()) {
-                        overwrites_whole_memory = true;
-                        break;
-                    }
-                }
-
-                // do strong update - just continue the loop without
-                // merging this definition into our map
-                if (overwrites_whole_memory)
-                    continue;
-            } else if (ds.target->getType() != DYN_ALLOC) {
-                bool skip = false;
-                auto range = std::equal_range(no_update->begin(),
-                                              no_update->end(),
-                                              ds, comp_ds);
-                for (auto I = range.first; I!= range.second; ++I) {
-                    const DefSite& ds2 = *I;
-                    assert(ds.target == ds2.target);
-                    // if the 'no_update' set contains target with unknown
-                    // pointer, we should always keep that value
-                    // and the value being merged (just all possible definitions)
-                    if (ds2.offset.isUnknown()) {
-                        // break no_update skip = true, thus adding
-                        // the values for UNKOWN to our map
-                        is_unknown = true;
-                        break;
-                    }
-
-                    // targets are the same, check if the what we have
-                    // in 'no_update' set overwrites the values that are in
-                    // the other map
-                    if ((*ds.offset >= *ds2.offset)
-                        && (*ds.offset + *ds.len <= *ds2.offset + *ds2.len)) {
-                        skip = true;
-                        break;
-                    }
-                }
-
-                // if values in 'no_update' map overwrite the coresponding values
-                // in the other map, don't update our map
-                if (skip)
-                    continue;
-            }
-        }
+        if (no_update && isOverwritten(ds, *no_update,
+                                       strong_update_unknown, is_unknown))
+            continue;
 
         // MERGE CONCRETE OFFSETS (if desired)
         // ------------------------------------
@@ -162,8 +183,7 @@ bool RDMap::merge(const RDMap *oth,
 
                 // merge values with concrete offset to
                 // this unknown offset
-                for (RDNode *defnode : cur->second)
-                    changed |= our_vals->insert(defnode);
+                changed |= our_vals->add(cur->second);
 
                 // erase the def-site with concrete offset
                 defs.erase(cur);
@@ -178,25 +198,25 @@ bool RDMap::merge(const RDMap *oth,
         assert(our_vals && "BUG");
 
         // copy values that have the map 'oth' for the defsite 'ds' to our map
-        for (RDNode *defnode : it.second)
-            changed |= our_vals->insert(defnode);
+        changed |= our_vals->add(it.second);
 
         // crop the set to UNKNOWN_MEMORY if it is too big.
         // But only in the case that the  DefSite is not also UNKNOWN,
         // because then we would be 'unknown memory defined @ unknown place'
-        if (!ds.target->isUnknown() && our_vals->size() > max_set_size)
+        if (!ds.target->isUnknown() && !our_vals->isUnknown()
+            && our_vals->size() > max_set_size)
             our_vals->makeUnknown();
     }
 
     return changed;
 }
 
-bool RDMap::add(const DefSite& p, RDNode *n)
+bool StdRDMap::add(const DefSite& p, RDNode *n)
 {
     return defs[p].insert(n);
 }
 
-bool RDMap::update(const DefSite& p, RDNode *n)
+bool StdRDMap::update(const DefSite& p, RDNode *n)
 {
     bool ret;
     RDNodesSet& dfs = defs[p];
@@ -208,30 +228,32 @@ bool RDMap::update(const DefSite& p, RDNode *n)
     return ret;
 }
 
-bool RDMap::definesWithAnyOffset(const DefSite& ds)
+bool StdRDMap::definesWithAnyOffset(const DefSite& ds)
 {
     auto range = getObjectRange(ds);
     return range.first != range.second;
 }
 
-size_t RDMap::get(RDNode *n, const Offset& off,
-                  const Offset& len, std::set<RDNode *>& ret)
+size_t StdRDMap::get(RDNode *n, const Offset& off,
+                     const Offset& len, std::set<RDNode *>& ret) const
 {
     DefSite ds(n, off, len);
     return get(ds, ret);
 }
 
-size_t RDMap::get(DefSite& ds, std::set<RDNode *>& ret)
+// gather the definitions from the def-sites [I, E) of the target
+// of @ds that may define the memory described by @ds
+template <typename IteratorT>
+static void gatherDefinitions(IteratorT I, IteratorT E, const DefSite& ds,
+                              std::set<RDNode *>& ret)
 {
     if (ds.offset.isUnknown()) {
-        auto range = getObjectRange(ds);
-        for (auto I = range.first; I != range.second; ++I) {
+        for (; I != E; ++I) {
             assert(I->first.target == ds.target);
             ret.insert(I->second.begin(), I->second.end());
         }
     } else {
-        auto range = getObjectRange(ds);
-        for (auto I = range.first; I != range.second; ++I) {
+        for (; I != E; ++I) {
             assert(I->first.target == ds.target);
                 // if we found a definition with UNKNOWN_OFFSET,
                 // it is possibly a definition that we need */
@@ -249,22 +271,287 @@ size_t RDMap::get(DefSite& ds, std::set<RDNode *>& ret)
             }
         }
     }
+}
 
+size_t StdRDMap::get(const DefSite& ds, std::set<RDNode *>& ret) const
+{
+    auto range = getObjectRange(ds.target);
+    gatherDefinitions(range.first, range.second, ds, ret);
     return ret.size();
 }
 
+std::pair<StdRDMap::iterator, StdRDMap::iterator>
+StdRDMap::getObjectRange(const DefSite& ds)
+{
+    return getTargetRange(defs, ds.target);
+}
+
+std::pair<StdRDMap::iterator, StdRDMap::iterator>
+StdRDMap::getObjectRange(RDNode *n)
+{
+    return getTargetRange(defs, n);
+}
+
+std::pair<StdRDMap::const_iterator, StdRDMap::const_iterator>
+StdRDMap::getObjectRange(RDNode *n) const
+{
+    return getTargetRange(defs, n);
+}
+
+///
+// FlatRDNodesSet
+///
+
+bool FlatRDNodesSet::insert(RDNode *n)
+{
+    if (is_unknown)
+        return false;
+
+    if (n == UNKNOWN_MEMORY) {
+        makeUnknown();
+        return true;
+    }
+
+    if (nodes.empty()) {
+        if (!single) {
+            single = n;
+            return true;
+        }
+
+        if (single == n)
+            return false;
+
+        // the second node, move the nodes to the vector
+        nodes.reserve(2);
+        nodes.push_back(std::min(single, n));
+        nodes.push_back(std::max(single, n));
+        single = nullptr;
+        return true;
+    }
+
+    auto it = std::lower_bound(nodes.begin(), nodes.end(), n);
+    if (it != nodes.end() && *it == n)
+        return false;
+
+    nodes.insert(it, n);
+    return true;
+}
+
+bool FlatRDNodesSet::add(const FlatRDNodesSet& oth)
+{
+    if (is_unknown)
+        return false;
+
+    if (oth.is_unknown) {
+        makeUnknown();
+        return true;
+    }
+
+    if (oth.size() <= 1)
+        return oth.size() == 1 && insert(oth.single);
+
+    // in the fixpoint computation the other set is usually
+    // already included in this set
+    if (std::includes(begin(), end(), oth.begin(), oth.end()))
+        return false;
+
+    std::vector<RDNode *> un;
+    un.reserve(size() + oth.size());
+    std::set_union(begin(), end(), oth.begin(), oth.end(),
+                   std::back_inserter(un));
+    nodes.swap(un);
+    single = nullptr;
+    return true;
+}
+
+size_t FlatRDNodesSet::count(RDNode *n) const
+{
+    return std::binary_search(begin(), end(), n);
+}
+
+///
+// FlatRDMap
+///
+
+static bool compKey(const FlatRDMap::value_type& a, const DefSite& ds)
+{
+    return a.first < ds;
+}
+
+static bool compKeyRev(const DefSite& ds, const FlatRDMap::value_type& a)
+{
+    return ds < a.first;
+}
+
+static bool compEntries(const FlatRDMap::value_type& a,
+                        const FlatRDMap::value_type& b)
+{
+    return a.first < b.first;
+}
+
+// see StdRDMap::merge()
+bool FlatRDMap::merge(const FlatRDMap *oth,
+                      DefSiteSetT *no_update,
+                      bool strong_update_unknown,
+                      uint32_t max_set_size,
+                      bool merge_unknown)
+{
+    if (this == oth)
+        return false;
+
+    bool changed = false;
+    // the def-sites that we do not have yet (sorted),
+    // these are added all at once after the pass
+    MapT missing;
+    // the targets whose definitions are merged to UNKNOWN_OFFSET
+    std::vector<RDNode *> to_unknown;
+
+    // both maps are sorted, so we find our def-sites
+    // by just going forward in our map
+    auto I = defs.begin();
+    auto E = defs.end();
+    for (const auto& it : oth->defs) {
+        const DefSite& ds = it.first;
+        bool is_unknown = ds.offset.isUnknown();
+
+        if (no_update && isOverwritten(ds, *no_update,
+                                       strong_update_unknown, is_unknown))
+            continue;
+
+        if (merge_unknown && is_unknown
+            && (to_unknown.empty() || to_unknown.back() != ds.target))
+            to_unknown.push_back(ds.target);
+
+        while (I != E && I->first < ds)
+            ++I;
+
+        FlatRDNodesSet *our_vals;
+        if (I != E && !(ds < I->first)) {
+            our_vals = &I->second;
+        } else {
+            missing.emplace_back(ds, FlatRDNodesSet());
+            our_vals = &missing.back().second;
+        }
+
+        changed |= our_vals->add(it.second);
+
+        // crop the set to UNKNOWN_MEMORY if it is too big
+        // (see StdRDMap::merge())
+        if (!ds.target->isUnknown() && !our_vals->isUnknown()
+            && our_vals->size() > max_set_size)
+            our_vals->makeUnknown();
+    }
+
+    if (!missing.empty()) {
+        size_t old_size = defs.size();
+        defs.insert(defs.end(), std::make_move_iterator(missing.begin()),
+                    std::make_move_iterator(missing.end()));
+        std::inplace_merge(defs.begin(), defs.begin() + old_size, defs.end(),
+                           compEntries);
+    }
+
+    for (RDNode *target : to_unknown)
+        changed |= mergeToUnknown(target);
+
+    return changed;
+}
+
+bool FlatRDMap::mergeToUnknown(RDNode *target)
+{
+    auto range = getObjectRange(target);
+    size_t b = range.first - defs.begin();
+    size_t e = range.second - defs.begin();
+    if (b == e)
+        return false;
+
+    // the def-site with UNKNOWN_OFFSET is the greatest one
+    DefSite uds(target, UNKNOWN_OFFSET, UNKNOWN_OFFSET);
+    if (defs[e - 1].first < uds) {
+        defs.insert(defs.begin() + e, value_type(uds, FlatRDNodesSet()));
+        ++e;
+    }
+
+    bool changed = false;
+    FlatRDNodesSet& vals = defs[e - 1].second;
+    for (size_t i = b; i < e - 1; ++i)
+        changed |= vals.add(defs[i].second);
+
+    defs.erase(defs.begin() + b, defs.begin() + e - 1);
+    return changed;
+}
+
+FlatRDNodesSet& FlatRDMap::operator[](const DefSite& ds)
+{
+    auto it = std::lower_bound(defs.begin(), defs.end(), ds, compKey);
+    if (it == defs.end() || ds < it->first)
+        it = defs.insert(it, value_type(ds, FlatRDNodesSet()));
+
+    return it->second;
+}
+
+bool FlatRDMap::add(const DefSite& p, RDNode *n)
+{
+    return (*this)[p].insert(n);
+}
+
+bool FlatRDMap::update(const DefSite& p, RDNode *n)
+{
+    FlatRDNodesSet& dfs = (*this)[p];
+
+    bool ret = dfs.count(n) == 0 || dfs.size() > 1;
+    dfs.clear();
+    dfs.insert(n);
+
+    return ret;
+}
+
+bool FlatRDMap::defines(const DefSite& ds)
+{
+    return std::binary_search(defs.begin(), defs.end(),
+                              value_type(ds, FlatRDNodesSet()), compEntries);
+}
+
+bool FlatRDMap::definesWithAnyOffset(const DefSite& ds)
+{
+    auto range = getObjectRange(ds);
+    return range.first != range.second;
+}
+
+size_t FlatRDMap::get(RDNode *n, const Offset& off,
+                      const Offset& len, std::set<RDNode *>& ret) const
+{
+    DefSite ds(n, off, len);
+    return get(ds, ret);
+}
+
+size_t FlatRDMap::get(const DefSite& ds, std::set<RDNode *>& ret) const
+{
+    auto range = getObjectRange(ds.target);
+    gatherDefinitions(range.first, range.second, ds, ret);
+    return ret.size();
+}
+
+// see getTargetRange()
+template <typename IteratorT>
+static std::pair<IteratorT, IteratorT>
+getFlatTargetRange(IteratorT B, IteratorT E, RDNode *target)
+{
+    return std::make_pair(
+        std::lower_bound(B, E, DefSite(target, 0, 1), compKey),
+        std::upper_bound(B, E, DefSite(target, UNKNOWN_OFFSET, UNKNOWN_OFFSET),
+                         compKeyRev));
+}
 
-static inline bool comp(const std::pair<const DefSite, RDNodesSet>& a,
-                        const std::pair<const DefSite, RDNodesSet>& b)
+std::pair<FlatRDMap::iterator, FlatRDMap::iterator>
+FlatRDMap::getObjectRange(RDNode *n)
 {
-    return a.first.target < b.first.target;
+    return getFlatTargetRange(defs.begin(), defs.end(), n);
 }
 
-std::pair<RDMap::iterator, RDMap::iterator>
-RDMap::getObjectRange(const DefSite& ds)
+std::pair<FlatRDMap::const_iterator, FlatRDMap::const_iterator>
+FlatRDMap::getObjectRange(RDNode *n) const
 {
-    std::pair<const DefSite, RDNodesSet> what(ds, RDNodesSet());
-    return std::equal_range(defs.begin(), defs.end(), what, comp);
+    return getFlatTargetRange(defs.begin(), defs.end(), n);
 }
 
 } // rd
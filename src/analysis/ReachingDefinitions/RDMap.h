@@ -3,6 +3,8 @@
 
 #include <set>
 #include <map>
+#include <memory>
+#include <vector>
 #include <cassert>
 
 #include "analysis/Offset.h"
@@ -87,6 +89,23 @@ public:
             return nodes.insert(n).second;
     }
 
+    // union, return true if this set changed. The unknown set
+    // contains everything, so merging with it is constant time
+    bool add(const RDNodesSet& oth)
+    {
+        if (is_unknown)
+            return false;
+
+        if (oth.is_unknown) {
+            makeUnknown();
+            return true;
+        }
+
+        size_t old_size = nodes.size();
+        nodes.insert(oth.nodes.begin(), oth.nodes.end());
+        return nodes.size() != old_size;
+    }
+
     size_t count(RDNode *n) const
     {
         return nodes.count(n);
@@ -120,19 +139,74 @@ public:
 
 };
 
+// The set of reaching definitions stored in a sorted vector,
+// the same interface as RDNodesSet has. Most of the sets contain
+// just one definition, that one is stored inline without
+// allocating any memory
+class FlatRDNodesSet {
+    // the only node if the set has at most one node
+    RDNode *single;
+    // all the nodes if the set has more nodes than one
+    std::vector<RDNode *> nodes;
+    bool is_unknown;
+
+public:
+    typedef RDNode * const *const_iterator;
+
+    FlatRDNodesSet() : single(nullptr), is_unknown(false) {}
+
+    void makeUnknown()
+    {
+        nodes.clear();
+        single = UNKNOWN_MEMORY;
+        is_unknown = true;
+    }
+
+    bool insert(RDNode *n);
+    bool add(const FlatRDNodesSet& oth);
+
+    size_t count(RDNode *n) const;
+
+    size_t size() const
+    {
+        return nodes.empty() ? (single != nullptr) : nodes.size();
+    }
+
+    void clear()
+    {
+        nodes.clear();
+        single = nullptr;
+        is_unknown = false;
+    }
+
+    bool isUnknown() const
+    {
+        return is_unknown;
+    }
+
+    const_iterator begin() const
+    {
+        return nodes.empty() ? &single : nodes.data();
+    }
+
+    const_iterator end() const { return begin() + size(); }
+};
+
 typedef std::set<DefSite> DefSiteSetT;
 
-class RDMap
+// The map from def-sites to reaching definitions,
+// stored in std::map
+class StdRDMap
 {
 public:
     typedef std::map<DefSite, RDNodesSet> MapT;
     typedef MapT::iterator iterator;
     typedef MapT::const_iterator const_iterator;
 
-    RDMap() {}
-    RDMap(const RDMap& o);
+    StdRDMap() {}
+    StdRDMap(const StdRDMap& o);
 
-    bool merge(const RDMap *o,
+    bool merge(const StdRDMap *o,
                DefSiteSetT *without = nullptr,
                bool strong_update_unknown = true,
                uint32_t max_set_size  = (~((uint32_t) 0)),
@@ -143,11 +217,9 @@ public:
 
     // @return iterators for the range of pointers that has the same object
     // as the given def site
-    std::pair<RDMap::iterator, RDMap::iterator>
-    getObjectRange(const DefSite&);
-
-    std::pair<RDMap::iterator, RDMap::iterator>
-    getObjectRange(RDNode *);
+    std::pair<iterator, iterator> getObjectRange(const DefSite&);
+    std::pair<iterator, iterator> getObjectRange(RDNode *);
+    std::pair<const_iterator, const_iterator> getObjectRange(RDNode *) const;
 
     bool defines(const DefSite& ds) { return defs.count(ds) != 0; }
     bool definesWithAnyOffset(const DefSite& ds);
@@ -165,8 +237,8 @@ public:
     // gather reaching definitions of memory [n + off, n + off + len]
     // and store them to the @ret
     size_t get(RDNode *n, const Offset& off,
-               const Offset& len, std::set<RDNode *>& ret);
-    size_t get(DefSite& ds, std::set<RDNode *>& ret);
+               const Offset& len, std::set<RDNode *>& ret) const;
+    size_t get(const DefSite& ds, std::set<RDNode *>& ret) const;
 
     const MapT& getDefs() const { return defs; }
 
@@ -174,6 +246,102 @@ private:
      MapT defs;
 };
 
+// The map from def-sites to reaching definitions stored
+// in a sorted vector. The maps are merged in one linear pass
+// over both of them (the new def-sites are added at once
+// at the end), so merging the maps of predecessors in the
+// analysis does not allocate unless something new is added.
+// NOTE: adding a def-site invalidates the iterators
+// and the references to the sets in the map.
+class FlatRDMap
+{
+public:
+    typedef std::pair<DefSite, FlatRDNodesSet> value_type;
+    typedef std::vector<value_type> MapT;
+    typedef MapT::iterator iterator;
+    typedef MapT::const_iterator const_iterator;
+
+    bool merge(const FlatRDMap *o,
+               DefSiteSetT *without = nullptr,
+               bool strong_update_unknown = true,
+               uint32_t max_set_size  = (~((uint32_t) 0)),
+               bool merge_unknown     = false);
+    bool add(const DefSite&, RDNode *n);
+    bool update(const DefSite&, RDNode *n);
+    bool empty() const { return defs.empty(); }
+
+    std::pair<iterator, iterator> getObjectRange(const DefSite& ds)
+    {
+        return getObjectRange(ds.target);
+    }
+
+    std::pair<iterator, iterator> getObjectRange(RDNode *);
+    std::pair<const_iterator, const_iterator> getObjectRange(RDNode *) const;
+
+    bool defines(const DefSite& ds);
+    bool definesWithAnyOffset(const DefSite& ds);
+
+    iterator begin() { return defs.begin(); }
+    iterator end() { return defs.end(); }
+    const_iterator begin() const { return defs.begin(); }
+    const_iterator end() const { return defs.end(); }
+
+    FlatRDNodesSet& get(const DefSite& ds) { return (*this)[ds]; }
+    FlatRDNodesSet& operator[](const DefSite& ds);
+
+    size_t get(RDNode *n, const Offset& off,
+               const Offset& len, std::set<RDNode *>& ret) const;
+    size_t get(const DefSite& ds, std::set<RDNode *>& ret) const;
+
+    const MapT& getDefs() const { return defs; }
+
+private:
+    MapT defs;
+
+    // merge the definitions of the target to UNKNOWN_OFFSET
+    bool mergeToUnknown(RDNode *target);
+};
+
+// the map used by the analysis
+#ifdef ENABLE_FLAT_RDMAP
+typedef FlatRDMap RDMap;
+#else
+typedef StdRDMap RDMap;
+#endif
+
+// A version of RDMap that can be shared by more nodes.
+// The nodes that have the same reaching definitions
+// (e.g. a node that does not define anything and its only
+// predecessor) keep just a reference to one map. The shared
+// map is never changed, it is copied when someone wants to change it.
+class SharedRDMap
+{
+    // nullptr is the empty map
+    std::shared_ptr<RDMap> map;
+
+public:
+    const RDMap& get() const
+    {
+        static const RDMap empty;
+        return map ? *map : empty;
+    }
+
+    // get the map for writing, this copies the map
+    // if it is shared with somebody else
+    RDMap& getMutable()
+    {
+        if (!map)
+            map = std::make_shared<RDMap>();
+        else if (isShared())
+            map = std::make_shared<RDMap>(*map);
+
+        return *map;
+    }
+
+    bool isShared() const { return map && map.use_count() > 1; }
+    bool sameAs(const SharedRDMap& o) const { return map == o.map; }
+};
+
 } // rd
 } // analysis
 } // dg
@@ -1,4 +1,7 @@
 #include <set>
+#include <queue>
+#include <algorithm>
+#include <functional>
 
 #include "RDMap.h"
 #include "ReachingDefinitions.h"
@@ -12,20 +15,204 @@ RDNode *UNKNOWN_MEMORY = &UNKNOWN_MEMLOC;
 
 bool ReachingDefinitionsAnalysis::processNode(RDNode *node)
 {
+    // the node has the same definitions as its predecessor,
+    // so just take the predecessor's map
+    if (node->sharesDefinitions()) {
+        RDNode *pred = node->getSinglePredecessor();
+        if (pred == node || node->def_map.sameAs(pred->def_map))
+            return false;
+
+        ++merges_num;
+        node->def_map = pred->def_map;
+        ++node->version;
+        return true;
+    }
+
+    const std::vector<RDNode *>& preds = node->predecessors;
+    std::vector<unsigned int>& merged = node->merged_versions;
+    if (merged.size() != preds.size())
+        merged.assign(preds.size(), 0);
+
+    // merging the same version of the map again would not change
+    // anything, so do nothing if no predecessor changed
+    unsigned i = 0;
+    while (i < preds.size() && merged[i] == preds[i]->version)
+        ++i;
+
+    if (i == preds.size())
+        return false;
+
+    // if our map is shared, the merge creates a new version of it.
+    // Keep the old one if nothing changed, so that the nodes
+    // that share it do not see a new map
+    SharedRDMap old;
+    bool shared = node->def_map.isShared();
+    if (shared)
+        old = node->def_map;
+
     bool changed = false;
+    RDMap& map = node->def_map.getMutable();
+
+    // merge maps from the predecessors that changed
+    for (; i < preds.size(); ++i) {
+        RDNode *n = preds[i];
+        if (merged[i] == n->version)
+            continue;
+
+        merged[i] = n->version;
+        ++merges_num;
+        changed |= map.merge(&n->def_map.get(),
+                             &node->overwrites /* strong update */,
+                             strong_update_unknown,
+                             max_set_size /* max size of set of reaching definition
+                                             of one definition site */,
+                             false /* merge unknown */);
+    }
 
-    // merge maps from predecessors
-    for (RDNode *n : node->predecessors)
-        changed |= node->def_map.merge(&n->def_map,
-                                       &node->overwrites /* strong update */,
-                                       strong_update_unknown,
-                                       max_set_size /* max size of set of reaching definition
-                                                       of one definition site */,
-                                       false /* merge unknown */);
+    if (changed)
+        ++node->version;
+    else if (shared)
+        node->def_map = old;
 
     return changed;
 }
 
+void ReachingDefinitionsAnalysis::runRounds()
+{
+    std::vector<RDNode *> to_process = getNodes(root);
+    std::vector<RDNode *> changed;
+
+    // do fixpoint
+    do {
+        unsigned last_processed_num = to_process.size();
+        changed.clear();
+
+        for (RDNode *cur : to_process) {
+            ++visits_num;
+            if (processNode(cur))
+                changed.push_back(cur);
+        }
+
+        if (!changed.empty()) {
+            to_process.clear();
+            to_process = getNodes(nullptr /* starting node */,
+                                  &changed /* starting set */,
+                                  last_processed_num /* expected num */);
+
+            // since changed was not empty,
+            // the to_process must not be empty too
+            assert(!to_process.empty());
+        }
+    } while (!changed.empty());
+}
+
+// number the nodes reachable from the root in the reverse postorder
+void ReachingDefinitionsAnalysis::computeRPO()
+{
+    ++dfsnum;
+    rpo.clear();
+
+    // the node and the index of its next successor to visit
+    std::vector<std::pair<RDNode *, unsigned> > stack;
+    stack.emplace_back(root, 0);
+    root->dfsid = dfsnum;
+
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        RDNode *cur = top.first;
+        if (top.second < cur->successors.size()) {
+            RDNode *succ = cur->successors[top.second++];
+            if (succ->dfsid != dfsnum) {
+                succ->dfsid = dfsnum;
+                stack.emplace_back(succ, 0);
+            }
+        } else {
+            rpo.push_back(cur);
+            stack.pop_back();
+        }
+    }
+
+    std::reverse(rpo.begin(), rpo.end());
+    for (unsigned i = 0; i < rpo.size(); ++i)
+        rpo[i]->rpoid = i;
+}
+
+void ReachingDefinitionsAnalysis::runWorklist()
+{
+    computeRPO();
+
+    // two buckets of the positions of nodes in the reverse postorder,
+    // the successors that go after the processed node are processed
+    // in this pass over the graph, the successors over back edges
+    // in the next pass, so that the changes go around the loops
+    // only once per pass
+    typedef std::priority_queue<unsigned, std::vector<unsigned>,
+                                std::greater<unsigned> > BucketT;
+    BucketT current, next;
+    std::vector<bool> queued(rpo.size(), true);
+
+    for (unsigned i = 0; i < rpo.size(); ++i)
+        current.push(i);
+
+    while (!current.empty()) {
+        while (!current.empty()) {
+            unsigned idx = current.top();
+            current.pop();
+            queued[idx] = false;
+
+            RDNode *cur = rpo[idx];
+            ++visits_num;
+            if (!processNode(cur))
+                continue;
+
+            for (RDNode *succ : cur->successors) {
+                unsigned sidx = succ->rpoid;
+                if (queued[sidx])
+                    continue;
+
+                queued[sidx] = true;
+                if (sidx > idx)
+                    current.push(sidx);
+                else
+                    next.push(sidx);
+            }
+        }
+
+        current.swap(next);
+    }
+}
+
+// remove the nodes that just pass the definitions from their
+// predecessor to their successor (see compact_graph)
+void ReachingDefinitionsAnalysis::compactGraph()
+{
+    std::vector<RDNode *> nodes = getNodes(root);
+    nodes_num = nodes.size();
+
+    for (RDNode *n : nodes) {
+        if (n == root || !n->sharesDefinitions()
+            || n->successorsNum() != 1)
+            continue;
+
+        RDNode *pred = n->getSinglePredecessor();
+        if (pred == n || n->getSingleSuccessor() == n)
+            continue;
+
+        // the predecessor may be removed later too,
+        // getRepresentative() follows the chain
+        representatives[n] = pred;
+        n->isolate();
+    }
+}
+
+// the removed nodes have the same reaching definitions
+// as their representatives, so just share the maps
+void ReachingDefinitionsAnalysis::shareRepresentativesMaps()
+{
+    for (auto& it : representatives)
+        it.first->def_map = getRepresentative(it.first)->def_map;
+}
+
 } // namespace rd
 } // namespace analysis
 } // namespace dg
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <set>
+#include <unordered_map>
 #include <cassert>
 #include <cstring>
 
@@ -49,9 +50,21 @@ class RDNode : public SubgraphNode<RDNode> {
 
     // marks for DFS/BFS
     unsigned int dfsid;
+    // the position of the node in the reverse postorder
+    // (the order in which the worklist processes the nodes)
+    unsigned int rpoid;
+
+    // the version of def_map, it is increased whenever the map changes
+    unsigned int version;
+    // the versions of the maps of predecessors (at the same indices
+    // as in predecessors) that were merged to our map last time.
+    // There's no need to merge the map of a predecessor again
+    // if it has still the same version
+    std::vector<unsigned int> merged_versions;
 public:
 
-    RDNode(RDNodeType t = NONE) : type(t), dfsid(0) {}
+    RDNode(RDNodeType t = NONE)
+    : type(t), dfsid(0), rpoid(0), version(1) {}
 
     // this is the gro of this node, so make it public
     DefSiteSetT defs;
@@ -59,7 +72,9 @@ public:
     // on this node
     DefSiteSetT overwrites;
 
-    RDMap def_map;
+    // reaching definitions on this node, a node that
+    // has the same definitions as its predecessor shares the map with it
+    SharedRDMap def_map;
 
     RDNodeType getType() const { return type; }
     DefSiteSetT& getDefines() { return defs; }
@@ -71,7 +86,8 @@ public:
         // FIXME: this is not efficient implementation,
         // use the ordering on the nodes
         // (see old DefMap.h in llvm/)
-        if (off.isUnknown()) {
+        // unknown or strided offset (inRange() is false for it)
+        if (!off.isConcrete()) {
             for (const DefSite& ds : defs)
                 if (ds.target == target)
                     return true;
@@ -88,7 +104,8 @@ public:
     void addDef(const DefSite& ds, bool strong_update = false)
     {
         defs.insert(ds);
-        def_map.update(ds, this);
+        def_map.getMutable().update(ds, this);
+        ++version;
 
         // XXX maybe we could do it by some flag in DefSite?
         // instead of strong new copy... but it should not
@@ -117,12 +134,21 @@ public:
         overwrites.insert(ds);
     }
 
-    const RDMap& getReachingDefinitions() const { return def_map; }
-    RDMap& getReachingDefinitions() { return def_map; }
+    const RDMap& getReachingDefinitions() const { return def_map.get(); }
+    // NOTE: this gives this node its own copy of the map if it is shared,
+    // use the const version when just reading the definitions
+    RDMap& getReachingDefinitions() { return def_map.getMutable(); }
     size_t getReachingDefinitions(RDNode *n, const Offset& off,
-                                  const Offset& len, std::set<RDNode *>& ret)
+                                  const Offset& len,
+                                  std::set<RDNode *>& ret) const
     {
-        return def_map.get(n, off, len, ret);
+        return def_map.get().get(n, off, len, ret);
+    }
+
+    // does the node just pass the definitions from its predecessor?
+    bool sharesDefinitions() const
+    {
+        return predecessors.size() == 1 && defs.empty() && overwrites.empty();
     }
 
     bool isUnknown() const
@@ -141,11 +167,45 @@ class ReachingDefinitionsAnalysis
     bool strong_update_unknown;
     uint32_t max_set_size;
 
+    // Graph compaction - before the fixpoint computation, remove
+    // the nodes that do not define anything and have a single
+    // predecessor and a single successor (chains of NOOPs, calls
+    // and returns). Such node has the same reaching definitions
+    // as its predecessor, so it is represented by the predecessor
+    // and gets its map when the analysis finishes.
+    bool compact_graph;
+    // the removed nodes and the nodes that represent them
+    std::unordered_map<RDNode *, RDNode *> representatives;
+    // the number of nodes before the compaction (statistics)
+    size_t nodes_num;
+
+    // Process the nodes in rounds - in every round process all
+    // the nodes reachable from the nodes that changed in the previous
+    // round (the old scheme). By default, the nodes are processed
+    // from a worklist ordered by the reverse postorder and only
+    // the successors of the changed nodes are queued
+    bool rounds_scheduling;
+    // the nodes in the reverse postorder (the worklist scheduling)
+    std::vector<RDNode *> rpo;
+
+    // the number of processed nodes and the number of maps
+    // of predecessors merged to the maps of nodes (statistics)
+    size_t visits_num;
+    size_t merges_num;
+
+    void compactGraph();
+    void shareRepresentativesMaps();
+    void computeRPO();
+    void runRounds();
+    void runWorklist();
+
 public:
     ReachingDefinitionsAnalysis(RDNode *r,
                                 bool field_insens = false,
                                 uint32_t max_set_sz = ~((uint32_t)0))
-    : root(r), dfsnum(0), strong_update_unknown(field_insens), max_set_size(max_set_sz)
+    : root(r), dfsnum(0), strong_update_unknown(field_insens), max_set_size(max_set_sz),
+      compact_graph(false), nodes_num(0), rounds_scheduling(false),
+      visits_num(0), merges_num(0)
     {
         assert(r && "Root cannot be null");
         // with max_set_size == 0 (everything is defined on unknown location)
@@ -153,6 +213,8 @@ public:
         assert(max_set_size > 0 && "The set size must be at least 1");
     }
 
+    // get all the nodes of the graph (including the nodes
+    // removed by the compaction) and store them into the container
     void getNodes(std::set<RDNode *>& cont)
     {
         assert(root && "Do not have root");
@@ -174,6 +236,11 @@ public:
                 }
             }
         }
+
+        // the nodes removed by the compaction are not reachable
+        // from the root, but they have reaching definitions too
+        for (auto& it : representatives)
+            cont.insert(it.first);
     }
 
     // get nodes in BFS order and store them into
@@ -225,36 +292,49 @@ public:
     RDNode *getRoot() const { return root; }
     void setRoot(RDNode *r) { root = r; }
 
+    void setCompactGraph(bool cg) { compact_graph = cg; }
+    bool getCompactGraph() const { return compact_graph; }
+
+    void setRoundsScheduling(bool rs) { rounds_scheduling = rs; }
+    bool getRoundsScheduling() const { return rounds_scheduling; }
+
+    size_t getVisitsNum() const { return visits_num; }
+    size_t getMergesNum() const { return merges_num; }
+
+    // the number of nodes in the graph before the compaction
+    // and the number of nodes that the compaction removed
+    size_t getNodesNum() const { return nodes_num; }
+    size_t getRemovedNodesNum() const { return representatives.size(); }
+
+    // get the node that computes the reaching definitions
+    // for the given node (the node itself if it was not removed)
+    RDNode *getRepresentative(RDNode *n) const
+    {
+        auto it = representatives.find(n);
+        while (it != representatives.end()) {
+            n = it->second;
+            it = representatives.find(n);
+        }
+
+        return n;
+    }
+
     bool processNode(RDNode *n);
 
     void run()
     {
         assert(root && "Do not have root");
 
-        std::vector<RDNode *> to_process = getNodes(root);
-        std::vector<RDNode *> changed;
+        if (compact_graph)
+            compactGraph();
 
-        // do fixpoint
-        do {
-            unsigned last_processed_num = to_process.size();
-            changed.clear();
+        if (rounds_scheduling)
+            runRounds();
+        else
+            runWorklist();
 
-            for (RDNode *cur : to_process) {
-                if (processNode(cur))
-                    changed.push_back(cur);
-            }
-
-            if (!changed.empty()) {
-                to_process.clear();
-                to_process = getNodes(nullptr /* starting node */,
-                                      &changed /* starting set */,
-                                      last_processed_num /* expected num */);
-
-                // since changed was not empty,
-                // the to_process must not be empty too
-                assert(!to_process.empty());
-            }
-        } while (!changed.empty());
+        if (!representatives.empty())
+            shareRepresentativesMaps();
     }
 };
 
@@ -5,6 +5,7 @@
 // PointerSubgraph and reaching definitions subgraph.
 
 #include <vector>
+#include <algorithm>
 
 namespace dg {
 namespace analysis {
@@ -95,6 +96,16 @@ public:
         return operands[idx];
     }
 
+    size_t getOperandsNum() const
+    {
+        return operands.size();
+    }
+
+    const std::vector<NodeT *>& getOperands() const
+    {
+        return operands;
+    }
+
     size_t addOperand(NodeT *n)
     {
         operands.push_back(n);
@@ -220,6 +231,35 @@ public:
         seq.second->addSuccessor(this);
     }
 
+    // remove this node from the graph - connect all its
+    // predecessors directly to all its successors
+    void isolate()
+    {
+        NodeT *self = static_cast<NodeT *>(this);
+
+        for (NodeT *pred : predecessors)
+            removeFrom(pred->successors, self);
+        for (NodeT *succ : successors)
+            removeFrom(succ->predecessors, self);
+
+        for (NodeT *pred : predecessors) {
+            if (pred == self)
+                continue;
+
+            for (NodeT *succ : successors) {
+                if (succ == self)
+                    continue;
+
+                if (std::find(pred->successors.begin(), pred->successors.end(),
+                              succ) == pred->successors.end())
+                    pred->addSuccessor(succ);
+            }
+        }
+
+        predecessors.clear();
+        successors.clear();
+    }
+
     size_t predecessorsNum() const
     {
         return predecessors.size();
@@ -229,6 +269,12 @@ public:
     {
         return successors.size();
     }
+
+private:
+    static void removeFrom(std::vector<NodeT *>& nodes, NodeT *n)
+    {
+        nodes.erase(std::remove(nodes.begin(), nodes.end(), n), nodes.end());
+    }
 };
 
 } // analysis
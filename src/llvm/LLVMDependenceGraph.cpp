@@ -230,7 +230,8 @@ void LLVMDependenceGraph::addSubgraphGlobalParameters(LLVMDependenceGraph *subgr
 }
 
 LLVMDependenceGraph *
-LLVMDependenceGraph::buildSubgraph(LLVMNode *node, llvm::Function *callFunc)
+LLVMDependenceGraph::buildSubgraph(LLVMNode *node, llvm::Function *callFunc,
+                                   bool add_params)
 {
     using namespace llvm;
 
@@ -278,7 +279,8 @@ LLVMDependenceGraph::buildSubgraph(LLVMNode *node, llvm::Function *callFunc)
     // it is necessary if this subgraph was creating due to function
     // pointer call
     addSubgraphGlobalParameters(subgraph);
-    node->addActualParameters(subgraph, callFunc);
+    if (add_params)
+        node->addActualParameters(subgraph, callFunc);
 
     return subgraph;
 }
@@ -367,6 +369,33 @@ void LLVMDependenceGraph::handleInstruction(llvm::Value *val,
             }
         }
 
+        // the library function calls the function pointer
+        // that is passed to it (e.g. qsort)
+        const analysis::LibraryFunctionSummary *S = nullptr;
+        if (func && func->size() == 0 && PTA)
+            S = llvmutils::getLibrarySummary(PTA->getLibrarySummaries(),
+                                             CInst, func);
+        analysis::pta::PSNode *fn = nullptr;
+        if (S && S->call_fn != analysis::LibraryFunctionSummary::NONE)
+            fn = PTA->getPointsTo(CInst->getArgOperand(S->call_fn));
+        if (fn) {
+            using namespace analysis::pta;
+            for (const Pointer& ptr : fn->pointsTo) {
+                if (!ptr.isValid()
+                    || !isa<Function>(ptr.target->getUserData<Value>()))
+                    continue;
+
+                Function *F = ptr.target->getUserData<Function>();
+                if (F->size() == 0
+                    || !llvmutils::callbackIsCompatible(F, S->call_args.size()))
+                    continue;
+
+                LLVMDependenceGraph *subg = buildSubgraph(node, F,
+                                                          false /* add_params */);
+                node->addSubgraph(subg);
+            }
+        }
+
         if (func && gather_callsites &&
             strcmp(func->getName().data(), gather_callsites) == 0) {
             gatheredCallsites->insert(node);
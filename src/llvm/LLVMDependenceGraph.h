@@ -97,9 +97,12 @@ public:
     std::set<LLVMNode *>& getCallNodes() { return callNodes; }
     bool addCallNode(LLVMNode *c) { return callNodes.insert(c).second; }
 
-    // build subgraph for a call node
+    // build subgraph for a call node. Without @add_params the actual
+    // parameters are not added -- the function is not called by the
+    // node itself, but by the library function that it calls (qsort)
     LLVMDependenceGraph *buildSubgraph(LLVMNode *node);
-    LLVMDependenceGraph *buildSubgraph(LLVMNode *node, llvm::Function *);
+    LLVMDependenceGraph *buildSubgraph(LLVMNode *node, llvm::Function *,
+                                       bool add_params = true);
     void addSubgraphGlobalParameters(LLVMDependenceGraph *subgraph);
 
     void makeSelfLoopsControlDependent();
@@ -158,6 +158,20 @@ void LLVMDefUseAnalysis::handleCallInst(LLVMNode *node)
         // memory it reallocates, since that is the memory it copies
         if (strcmp(func->getName().data(), "realloc") == 0)
             addDataDependence(node, CI, CI->getOperand(0), UNKNOWN_OFFSET /* FIXME */);
+
+        // the library functions read the memory of some arguments
+        if (func->size() == 0) {
+            if (const analysis::LibraryFunctionSummary *S
+                    = llvmutils::getLibrarySummary(PTA->getLibrarySummaries(),
+                                                   CI, func)) {
+                for (unsigned i = 0; i < CI->getNumArgOperands(); ++i) {
+                    Value *op = CI->getArgOperand(i);
+                    if (S->reads(i) && op->getType()->isPointerTy()
+                        && PTA->getPointsTo(op))
+                        addDataDependence(node, CI, op, UNKNOWN_OFFSET);
+                }
+            }
+        }
     }
 
     /*
@@ -174,7 +188,7 @@ void LLVMDefUseAnalysis::handleCallInst(LLVMNode *node)
 }
 
 // Add data dependence edges from all memory location that may write
-// to memory pointed by 'pts' to 'node'
+// to memory pointed by 'pts' to 'node' (from all writes if 'pts' is null)
 void LLVMDefUseAnalysis::addUnknownDataDependence(LLVMNode *node, PSNode *pts)
 {
     // iterate over all nodes from ReachingDefinitions Subgraph. It is faster than
@@ -191,6 +205,12 @@ void LLVMDefUseAnalysis::addUnknownDataDependence(LLVMNode *node, PSNode *pts)
         if (!rdVal)
             continue;
 
+        // the pointer may point anywhere, so every store may define it
+        if (!pts || (PTA->getSaturateUnknown() && pts->isTop())) {
+            addDataDependence(node, rdVal);
+            continue;
+        }
+
         // does this store define some value that is in pts?
         for (const analysis::rd::DefSite& ds : rdnode->getDefines()) {
             llvm::Value *llvmVal = ds.target->getUserData<llvm::Value>();
@@ -246,6 +266,19 @@ void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, PSNode *pts,
 {
     using namespace dg::analysis;
 
+    // the pointer may point anywhere (only the unknown pointer and
+    // functions were kept in the saturated set), so any definition
+    // that reaches this place may be used
+    if (PTA->getSaturateUnknown() && pts->isTop()) {
+        addDataDependenceOnAll(node, mem);
+        return;
+    }
+
+    // Get even reaching definitions for UNKNOWN_MEMORY.
+    // Since those can be ours definitions, we must add them always
+    // (they are the same for all the pointers)
+    bool unknown_added = false;
+
     for (const pta::Pointer& ptr : pts->pointsTo) {
         if (!ptr.isValid())
             continue;
@@ -260,10 +293,10 @@ void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, PSNode *pts,
         }
 
         std::set<RDNode *> defs;
-        // Get even reaching definitions for UNKNOWN_MEMORY.
-        // Since those can be ours definitions, we must add them always
-        mem->getReachingDefinitions(rd::UNKNOWN_MEMORY, UNKNOWN_OFFSET, UNKNOWN_OFFSET, defs);
-        if (!defs.empty()) {
+        if (!unknown_added) {
+            unknown_added = true;
+            mem->getReachingDefinitions(rd::UNKNOWN_MEMORY, UNKNOWN_OFFSET,
+                                        UNKNOWN_OFFSET, defs);
             for (RDNode *rd : defs) {
                 assert(!rd->isUnknown() && "Unknown memory defined at unknown location?");
                 addDataDependence(node, rd);
@@ -272,7 +305,9 @@ void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, PSNode *pts,
             defs.clear();
         }
 
-        mem->getReachingDefinitions(val, ptr.offset, size, defs);
+        // reaching definitions do not handle strided offsets
+        Offset off = ptr.offset.isConcrete() ? ptr.offset : UNKNOWN_OFFSET;
+        mem->getReachingDefinitions(val, off, size, defs);
         if (defs.empty()) {
             llvm::GlobalVariable *GV
                 = llvm::dyn_cast<llvm::GlobalVariable>(llvmVal);
@@ -304,6 +339,29 @@ void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, PSNode *pts,
     }
 }
 
+// add data dependence on all the definitions that reach @mem
+void LLVMDefUseAnalysis::addDataDependenceOnAll(LLVMNode *node, RDNode *mem)
+{
+    using namespace dg::analysis;
+
+    bool unknown = false;
+    const RDNode *cmem = mem;
+    for (const auto& it : cmem->getReachingDefinitions()) {
+        for (RDNode *rd : it.second) {
+            if (rd->isUnknown()) {
+                unknown = true;
+                continue;
+            }
+
+            addDataDependence(node, rd);
+        }
+    }
+
+    // some definitions were lost, take all the writes to memory
+    if (unknown)
+        addUnknownDataDependence(node, nullptr);
+}
+
 void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node,
                                            const llvm::Value *where, /* in CFG */
                                            const llvm::Value *ptrOp,
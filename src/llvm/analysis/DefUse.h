@@ -48,6 +48,7 @@ private:
     void addDataDependence(LLVMNode *node, llvm::Value *val);
 
     void addUnknownDataDependence(LLVMNode *node, PSNode *pts);
+    void addDataDependenceOnAll(LLVMNode *node, analysis::rd::RDNode *mem);
 
     void handleLoadInst(llvm::LoadInst *, LLVMNode *);
     void handleCallInst(LLVMNode *);
@@ -0,0 +1,309 @@
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "LibrarySummaries.h"
+
+namespace dg {
+namespace analysis {
+
+// The calls of printf-like functions are summarized as reading
+// all the variadic arguments, the %n conversion is not taken
+// into account. qsort and bsearch call the comparison function
+// with pointers to the elements (and to the key).
+static const char *BUILTIN_SUMMARIES =
+    "# strings\n"
+    "strlen     read=0\n"
+    "strnlen    read=0\n"
+    "strcmp     read=0,1\n"
+    "strncmp    read=0,1\n"
+    "strcasecmp  read=0,1\n"
+    "strncasecmp read=0,1\n"
+    "strcoll    read=0,1\n"
+    "strspn     read=0,1\n"
+    "strcspn    read=0,1\n"
+    "strcpy     read=1 write=0 ret=0\n"
+    "strncpy    read=1 write=0 size=2 ret=0\n"
+    "stpcpy     read=1 write=0 ret=0+\n"
+    "strcat     read=0,1 write=0 ret=0\n"
+    "strncat    read=0,1 write=0 ret=0\n"
+    "strdup     read=0 ret=alloc?\n"
+    "strndup    read=0 ret=alloc?\n"
+    "strchr     read=0 ret=0+?\n"
+    "strrchr    read=0 ret=0+?\n"
+    "strstr     read=0,1 ret=0+?\n"
+    "strpbrk    read=0,1 ret=0+?\n"
+    "# memory\n"
+    "memcmp     read=0,1\n"
+    "memchr     read=0 ret=0+?\n"
+    "memset     write=0 size=2 ret=0\n"
+    "memcpy     read=1 write=0 size=2 copy=1:0 ret=0\n"
+    "memmove    read=1 write=0 size=2 copy=1:0 ret=0\n"
+    "free       write=0\n"
+    "# conversions\n"
+    "atoi       read=0\n"
+    "atol       read=0\n"
+    "atoll      read=0\n"
+    "atof       read=0\n"
+    "strtol     read=0 write=1 store=0:1\n"
+    "strtoul    read=0 write=1 store=0:1\n"
+    "strtoll    read=0 write=1 store=0:1\n"
+    "strtoull   read=0 write=1 store=0:1\n"
+    "strtod     read=0 write=1 store=0:1\n"
+    "strtof     read=0 write=1 store=0:1\n"
+    "# sorting\n"
+    "qsort      read=0 write=0 call=3:0+,0+\n"
+    "bsearch    read=0,1 ret=1+? call=4:0,1+\n"
+    "# input and output\n"
+    "printf     read=0-\n"
+    "puts       read=0\n"
+    "putchar\n"
+    "getchar\n"
+    "perror     read=0\n"
+    "fprintf    read=0- write=0\n"
+    "sprintf    read=1- write=0\n"
+    "snprintf   read=2- write=0 size=1\n"
+    "scanf      read=0 write=1-\n"
+    "fscanf     read=0,1 write=0,2-\n"
+    "sscanf     read=0,1 write=2-\n"
+    "fopen      read=0,1 ret=alloc?\n"
+    "fdopen     read=1 ret=alloc?\n"
+    "fclose     write=0\n"
+    "fflush     write=0\n"
+    "fgets      read=2 write=0,2 size=1 ret=0?\n"
+    "fputs      read=0 write=1\n"
+    "fputc      write=1\n"
+    "fgetc      write=0\n"
+    "getc       write=0\n"
+    "putc       write=1\n"
+    "fread      write=0,3\n"
+    "fwrite     read=0 write=3\n"
+    "feof       read=0\n"
+    "ferror     read=0\n"
+    "fseek      write=0\n"
+    "ftell      read=0\n"
+    "rewind     write=0\n"
+    "open       read=0\n"
+    "close\n"
+    "read       write=1 size=2\n"
+    "write      read=1\n";
+
+static LibrarySummaries createBuiltin()
+{
+    LibrarySummaries builtin;
+    bool ret = builtin.parse(BUILTIN_SUMMARIES);
+    assert(ret && "Malformed builtin library summaries");
+    (void) ret;
+
+    return builtin;
+}
+
+const LibrarySummaries& LibrarySummaries::getBuiltin()
+{
+    static const LibrarySummaries builtin = createBuiltin();
+    return builtin;
+}
+
+unsigned LibraryFunctionSummary::getMaxArg() const
+{
+    unsigned max = NONE;
+    auto upd = [&max](unsigned i) {
+        if (i != NONE && (max == NONE || i > max))
+            max = i;
+    };
+
+    for (unsigned i = 0; i < 64; ++i) {
+        if ((reads_mask | writes_mask) & (1ULL << i))
+            upd(i);
+    }
+
+    // the variadic arguments do not need to be there
+    upd(size_arg);
+    upd(ret_arg);
+    upd(copy_src);
+    upd(copy_dst);
+    upd(store_src);
+    upd(store_dst);
+    upd(call_fn);
+    for (const CallbackArg& a : call_args)
+        upd(a.arg);
+
+    return max;
+}
+
+static bool parseIndex(const std::string& str, unsigned& idx)
+{
+    if (str.empty())
+        return false;
+
+    char *end;
+    unsigned long val = strtoul(str.c_str(), &end, 10);
+    if (*end != '\0' || val >= 64)
+        return false;
+
+    idx = val;
+    return true;
+}
+
+// parse the comma-separated list of indices
+static bool parseArgs(const std::string& str, uint64_t& mask, unsigned& from)
+{
+    std::istringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        unsigned idx;
+        if (!item.empty() && item.back() == '-') {
+            if (!parseIndex(item.substr(0, item.size() - 1), idx))
+                return false;
+
+            if (from == LibraryFunctionSummary::NONE || idx < from)
+                from = idx;
+        } else {
+            if (!parseIndex(item, idx))
+                return false;
+
+            mask |= 1ULL << idx;
+        }
+    }
+
+    return true;
+}
+
+static bool parsePair(const std::string& str, unsigned& first, unsigned& second)
+{
+    size_t colon = str.find(':');
+    if (colon == std::string::npos)
+        return false;
+
+    return parseIndex(str.substr(0, colon), first)
+           && parseIndex(str.substr(colon + 1), second);
+}
+
+// F:ARGS where ARGS are N or N+
+static bool parseCall(const std::string& str, LibraryFunctionSummary& S)
+{
+    size_t colon = str.find(':');
+    if (colon == std::string::npos
+        || !parseIndex(str.substr(0, colon), S.call_fn))
+        return false;
+
+    S.call_args.clear();
+    std::istringstream ss(str.substr(colon + 1));
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        LibraryFunctionSummary::CallbackArg a;
+        a.inside = !item.empty() && item.back() == '+';
+        if (a.inside)
+            item.pop_back();
+
+        if (!parseIndex(item, a.arg))
+            return false;
+
+        S.call_args.push_back(a);
+    }
+
+    return true;
+}
+
+static bool parseRet(std::string str, LibraryFunctionSummary& S)
+{
+    if (!str.empty() && str.back() == '?') {
+        S.ret_null = true;
+        str.pop_back();
+    }
+
+    if (str.empty())
+        return true;
+
+    if (str == "alloc") {
+        S.ret_alloc = true;
+        return true;
+    }
+
+    if (str.back() == '+') {
+        S.ret_inside = true;
+        str.pop_back();
+    }
+
+    return parseIndex(str, S.ret_arg);
+}
+
+static bool parseAttribute(const std::string& attr, LibraryFunctionSummary& S)
+{
+    size_t eq = attr.find('=');
+    if (eq == std::string::npos)
+        return false;
+
+    std::string key = attr.substr(0, eq);
+    std::string val = attr.substr(eq + 1);
+
+    if (key == "read")
+        return parseArgs(val, S.reads_mask, S.reads_from);
+    else if (key == "write")
+        return parseArgs(val, S.writes_mask, S.writes_from);
+    else if (key == "size")
+        return parseIndex(val, S.size_arg);
+    else if (key == "ret")
+        return parseRet(val, S);
+    else if (key == "copy")
+        return parsePair(val, S.copy_src, S.copy_dst);
+    else if (key == "store")
+        return parsePair(val, S.store_src, S.store_dst);
+    else if (key == "call")
+        return parseCall(val, S);
+
+    return false;
+}
+
+bool LibrarySummaries::parse(const std::string& text, std::string *err)
+{
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+
+    std::istringstream in(text);
+    std::string line;
+    unsigned lineno = 0;
+    while (std::getline(in, line)) {
+        ++lineno;
+
+        std::istringstream ls(line);
+        std::string name;
+        if (!(ls >> name) || name[0] == '#')
+            continue;
+
+        LibraryFunctionSummary S;
+        std::string attr;
+        while (ls >> attr) {
+            if (!parseAttribute(attr, S)) {
+                if (err)
+                    *err = "line " + std::to_string(lineno)
+                           + ": invalid attribute '" + attr + "'";
+                return false;
+            }
+        }
+
+        summaries[name] = S;
+    }
+
+    return true;
+}
+
+bool LibrarySummaries::load(const std::string& path, std::string *err)
+{
+    std::ifstream in(path);
+    if (!in) {
+        if (err)
+            *err = "cannot open '" + path + "'";
+        return false;
+    }
+
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return parse(ss.str(), err);
+}
+
+} // namespace analysis
+} // namespace dg
@@ -0,0 +1,148 @@
+#ifndef _LLVM_DG_LIBRARY_SUMMARIES_H_
+#define _LLVM_DG_LIBRARY_SUMMARIES_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dg {
+namespace analysis {
+
+// What an undefined (library) function does with the memory
+// pointed by its arguments. The arguments are numbered from 0.
+struct LibraryFunctionSummary
+{
+    enum : unsigned { NONE = ~0u };
+
+    // the memory pointed by these arguments is read (written),
+    // the arguments in the mask and all the arguments
+    // from the index *_from on (for variadic functions)
+    uint64_t reads_mask;
+    unsigned reads_from;
+    uint64_t writes_mask;
+    unsigned writes_from;
+
+    // the number of bytes written through the pointers
+    // is at most the value of this argument
+    unsigned size_arg;
+
+    // the returned pointer points to the memory pointed by this
+    // argument (exactly or somewhere inside it)
+    unsigned ret_arg;
+    bool ret_inside;
+    // returns newly allocated memory
+    bool ret_alloc;
+    // may return null
+    bool ret_null;
+
+    // copies the memory (with the pointers in it)
+    // pointed by copy_src to the memory pointed by copy_dst
+    unsigned copy_src;
+    unsigned copy_dst;
+
+    // stores a pointer into the memory pointed by store_src
+    // to the memory pointed by store_dst (e.g. strtol)
+    unsigned store_src;
+    unsigned store_dst;
+
+    // calls the function pointed by this argument (e.g. qsort)
+    // with the pointers passed in call_args
+    unsigned call_fn;
+    struct CallbackArg {
+        unsigned arg;
+        // a pointer somewhere into the memory pointed by the argument
+        bool inside;
+    };
+    std::vector<CallbackArg> call_args;
+
+    LibraryFunctionSummary()
+    : reads_mask(0), reads_from(NONE), writes_mask(0), writes_from(NONE),
+      size_arg(NONE), ret_arg(NONE), ret_inside(false), ret_alloc(false),
+      ret_null(false), copy_src(NONE), copy_dst(NONE), store_src(NONE),
+      store_dst(NONE), call_fn(NONE) {}
+
+    bool reads(unsigned i) const
+    {
+        return i >= reads_from || (i < 64 && (reads_mask & (1ULL << i)));
+    }
+
+    bool writes(unsigned i) const
+    {
+        return i >= writes_from || (i < 64 && (writes_mask & (1ULL << i)));
+    }
+
+    // does the function create or copy pointers?
+    // (the called function can do anything)
+    bool hasPointerEffects() const
+    {
+        return ret_arg != NONE || ret_alloc
+               || copy_src != NONE || store_src != NONE
+               || call_fn != NONE;
+    }
+
+    // the largest argument index that the summary refers to
+    // (besides the variadic ones), NONE if there is no such
+    unsigned getMaxArg() const;
+};
+
+// The table of summaries of library functions, so that the calls
+// of these functions do not need to be treated as calls
+// of unknown functions. The table is built from text where every
+// line describes one function:
+//
+//   name attribute...
+//
+// where the attributes are:
+//
+//   read=ARGS     the function reads the memory pointed by ARGS
+//   write=ARGS    the function writes the memory pointed by ARGS
+//   size=N        at most (value of) argument N bytes are written
+//   ret=N         returns the pointer passed in argument N
+//   ret=N+        returns a pointer into the memory pointed by argument N
+//   ret=alloc     returns newly allocated memory
+//   copy=S:D      copies the memory pointed by S to the memory pointed by D
+//   store=S:D     stores a pointer into the memory pointed by S
+//                 to the memory pointed by D
+//   call=F:ARGS   calls the function pointed by F with the pointers
+//                 passed in ARGS (N+ is a pointer into the memory
+//                 pointed by N), e.g. the comparison function of qsort
+//
+// ARGS is a comma-separated list of argument indices, N- means
+// the argument N and all the following arguments (not in call). '?' after
+// the ret attribute means that the function may return null.
+// Empty lines and lines starting with '#' are ignored.
+class LibrarySummaries
+{
+    std::unordered_map<std::string, LibraryFunctionSummary> summaries;
+    // the hash of all the text that the summaries were parsed from
+    uint64_t hash = 14695981039346656037ULL;
+
+public:
+    // the summaries of common libc and POSIX functions
+    static const LibrarySummaries& getBuiltin();
+
+    // add the summaries from the text (see above), the summaries
+    // from the text override the summaries that we have.
+    // Returns false and sets @err on a malformed line
+    bool parse(const std::string& text, std::string *err = nullptr);
+    // the same as parse(), but read the text from the file
+    bool load(const std::string& path, std::string *err = nullptr);
+
+    const LibraryFunctionSummary *get(const std::string& name) const
+    {
+        auto it = summaries.find(name);
+        if (it == summaries.end())
+            return nullptr;
+
+        return &it->second;
+    }
+
+    size_t size() const { return summaries.size(); }
+    uint64_t getHash() const { return hash; }
+};
+
+} // namespace analysis
+} // namespace dg
+
+#endif // _LLVM_DG_LIBRARY_SUMMARIES_H_
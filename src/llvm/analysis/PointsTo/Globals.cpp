@@ -59,13 +59,13 @@ LLVMPointerSubgraphBuilder::handleGlobalVariableInitializer(const llvm::Constant
 
             if (Ty->isPointerTy()) {
                 PSNode *op = getOperand(val);
-                PSNode *target = new PSNode(CONSTANT, node, off);
+                PSNode *target = PS->createNode(CONSTANT, node, off);
                 // FIXME: we're leaking the target
                 // NOTE: mabe we could do something like
                 // CONSTANT_STORE that would take Pointer instead of node??
                 // PSNode(CONSTANT_STORE, op, Pointer(node, off)) or
                 // PSNode(COPY, op, Pointer(node, off))??
-                PSNode *store = new PSNode(STORE, op, target);
+                PSNode *store = PS->createNode(STORE, op, target);
                 store->insertAfter(last);
                 last = store;
             }
@@ -78,7 +78,7 @@ LLVMPointerSubgraphBuilder::handleGlobalVariableInitializer(const llvm::Constant
            PSNode *value = getOperand(C);
            assert(value->pointsTo.size() == 1 && "BUG: We should have constant");
            // FIXME: we're leaking the target
-           PSNode *store = new PSNode(STORE, value, node);
+           PSNode *store = PS->createNode(STORE, value, node);
            store->insertAfter(last);
            last = store;
        }
@@ -99,7 +99,7 @@ PSNodesSeq LLVMPointerSubgraphBuilder::buildGlobals()
         prev = cur;
 
         // every global node is like memory allocation
-        cur = new PSNode(pta::ALLOC);
+        cur = PS->createNode(pta::ALLOC);
         addNode(&*I, cur);
 
         if (prev)
@@ -123,7 +123,7 @@ PSNodesSeq LLVMPointerSubgraphBuilder::buildGlobals()
         } else {
             // without initializer we can not do anything else than
             // assume that it can point everywhere
-            cur = new PSNode(pta::STORE, UNKNOWN_MEMORY, node);
+            cur = PS->createNode(pta::STORE, UNKNOWN_MEMORY, node);
             cur->insertAfter(node);
         }
     }
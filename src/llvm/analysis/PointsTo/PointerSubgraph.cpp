@@ -14,8 +14,10 @@
 
 #if (LLVM_VERSION_MINOR < 5)
  #include <llvm/Support/CFG.h>
+ #include <llvm/Support/GetElementPtrTypeIterator.h>
 #else
  #include <llvm/IR/CFG.h>
+ #include <llvm/IR/GetElementPtrTypeIterator.h>
 #endif
 
 #include <llvm/IR/Instruction.h>
@@ -35,6 +37,7 @@
 #endif
 
 #include "analysis/PointsTo/PointerSubgraph.h"
+#include "llvm/llvm-utils.h"
 #include "PointerSubgraph.h"
 
 namespace dg {
@@ -174,30 +177,7 @@ bool LLVMPointerSubgraphBuilder::typeCanBePointer(llvm::Type *Ty) const
 
 LLVMPointerSubgraphBuilder::~LLVMPointerSubgraphBuilder()
 {
-    // delete the created nodes
-    for (auto& it : nodes_map) {
-        PSNode *node = it.second.first;
-        while (node) {
-            PSNode *cur = node;
-
-            if (cur == it.second.second)
-                node = nullptr;
-            else
-                node = node->getSingleSuccessor();
-
-            delete cur;
-        }
-    }
-
-    // delete allocated memory in subgraph structures
-    for (auto& it : subgraphs_map) {
-        delete it.second.root;
-        delete it.second.ret;
-    }
-
-    for (PSNode *dummy : dummy_nodes)
-        delete dummy;
-
+    // the nodes are owned by the PointerSubgraph
     delete DL;
 }
 
@@ -265,7 +245,7 @@ Pointer LLVMPointerSubgraphBuilder::handleConstantAdd(const llvm::Instruction *I
 
     Pointer ptr = *op->pointsTo.begin();
     if (off)
-        return Pointer(ptr.target, *ptr.offset + off);
+        return Pointer(ptr.target, ptr.offset + off);
     else
         return Pointer(ptr.target, UNKNOWN_OFFSET);
 }
@@ -337,7 +317,7 @@ Pointer LLVMPointerSubgraphBuilder::handleConstantGep(const llvm::GetElementPtrI
     // get offset of this GEP
     if (GEP->accumulateConstantOffset(*DL, offset)) {
         if (offset.isIntN(bitwidth) && !pointer.offset.isUnknown())
-            pointer.offset = offset.getZExtValue();
+            pointer.offset = Offset::getConcrete(offset.getZExtValue());
         else
             errs() << "WARN: Offset greater than "
                    << bitwidth << "-bit" << *GEP << "\n";
@@ -399,7 +379,7 @@ Pointer LLVMPointerSubgraphBuilder::getConstantExprPointer(const llvm::ConstantE
 PSNode *LLVMPointerSubgraphBuilder::createConstantExpr(const llvm::ConstantExpr *CE)
 {
     Pointer ptr = getConstantExprPointer(CE);
-    PSNode *node = new PSNode(pta::CONSTANT, ptr.target, ptr.offset);
+    PSNode *node = PS->createNode(pta::CONSTANT, ptr.target, ptr.offset);
 
     addNode(CE, node);
 
@@ -428,7 +408,7 @@ PSNode *LLVMPointerSubgraphBuilder::getConstant(const llvm::Value *val)
                     = llvm::dyn_cast<llvm::ConstantExpr>(val)) {
         return createConstantExpr(CE);
     } else if (llvm::isa<llvm::Function>(val)) {
-        PSNode *ret = new PSNode(FUNCTION);
+        PSNode *ret = PS->createNode(FUNCTION);
         addNode(val, ret);
         return ret;
     } else if (llvm::isa<llvm::Constant>(val)) {
@@ -558,13 +538,14 @@ PSNode *LLVMPointerSubgraphBuilder::getOperand(const llvm::Value *val)
         return op;
 }
 
-static PSNode *createDynamicAlloc(const llvm::CallInst *CInst, int type)
+static PSNode *createDynamicAlloc(PointerSubgraph *PS,
+                                  const llvm::CallInst *CInst, int type)
 {
     using namespace llvm;
 
     const Value *op;
     uint64_t size = 0, size2 = 0;
-    PSNode *node = new PSNode(pta::DYN_ALLOC);
+    PSNode *node = PS->createNode(pta::DYN_ALLOC);
 
     switch (type) {
         case MALLOC:
@@ -605,9 +586,9 @@ LLVMPointerSubgraphBuilder::createRealloc(const llvm::CallInst *CInst)
 
     // we create new allocation node and memcpy old pointers there
     PSNode *orig_mem = getOperand(CInst->getOperand(0)->stripInBoundsOffsets());
-    PSNode *reall = new PSNode(pta::DYN_ALLOC);
+    PSNode *reall = PS->createNode(pta::DYN_ALLOC);
     // copy everything that is in orig_mem to reall
-    PSNode *mcp = new PSNode(pta::MEMCPY, orig_mem, reall, 0, UNKNOWN_OFFSET);
+    PSNode *mcp = PS->createNode(pta::MEMCPY, orig_mem, reall, 0, UNKNOWN_OFFSET);
 
     reall->setIsHeap();
     reall->setSize(getConstantValue(CInst->getOperand(1)));
@@ -631,7 +612,7 @@ LLVMPointerSubgraphBuilder::createDynamicMemAlloc(const llvm::CallInst *CInst, i
     if (type == REALLOC) {
         return createRealloc(CInst);
     } else {
-        PSNode *node = createDynamicAlloc(CInst, type);
+        PSNode *node = createDynamicAlloc(PS, CInst, type);
         addNode(CInst, node);
 
         // we return (node, node), so that the parent function
@@ -647,12 +628,8 @@ LLVMPointerSubgraphBuilder::createCallToFunction(const llvm::Function *F)
 
     // the operands to the return node (which works as a phi node)
     // are going to be added when the subgraph is built
-    callNode = new PSNode(pta::CALL, nullptr);
-    returnNode = new PSNode(pta::CALL_RETURN, nullptr);
-
-    // save the returnNode to dummy_nodes, to delete the
-    // memory at destruction.  The call nodes will be stored to nodes_map.
-    dummy_nodes.push_back(returnNode);
+    callNode = PS->createNode(pta::CALL, nullptr);
+    returnNode = PS->createNode(pta::CALL_RETURN, nullptr);
 
     returnNode->setPairedNode(callNode);
     callNode->setPairedNode(returnNode);
@@ -697,8 +674,6 @@ LLVMPointerSubgraphBuilder::createFuncptrCall(const llvm::CallInst *CInst,
         add_structure = true;
 
     PSNodesSeq ret = createCallToFunction(F);
-    dummy_nodes.push_back(ret.first);
-    //dummy_nodes.push_back(ret.second);
 
     // we took a reference
     assert(subg.root);
@@ -707,10 +682,75 @@ LLVMPointerSubgraphBuilder::createFuncptrCall(const llvm::CallInst *CInst,
         addProgramStructure(F, subg);
 
     addInterproceduralOperands(F, subg, CInst);
+    funcptr_calls.emplace_back(CInst, F);
+    funcptr_calls_set.emplace(CInst, F);
+
+    return ret;
+}
+
+PSNodesSeq
+LLVMPointerSubgraphBuilder::createCallbackCall(PSNode *callsite,
+                                               const llvm::Function *F)
+{
+    const llvm::CallInst *CInst = callsite->getUserData<llvm::CallInst>();
+    bool add_structure = false;
+
+    Subgraph& subg = subgraphs_map[F];
+    if (!subg.root)
+        add_structure = true;
+
+    PSNodesSeq ret = createCallToFunction(F);
+
+    // we took a reference
+    assert(subg.root);
+
+    if (add_structure)
+        addProgramStructure(F, subg);
+
+    // the arguments are the pointers that the library function passes
+    // to @F, not the operands of the call. The value returned
+    // from @F does not get out of the library function
+    const std::vector<PSNode *>& args = callbacks[callsite];
+    size_t idx = 0;
+    for (auto A = F->arg_begin(), E = F->arg_end();
+         A != E && idx < args.size(); ++A, ++idx) {
+        PSNode *arg = getNode(&*A);
+        if (arg)
+            arg->addOperand(args[idx]);
+    }
+
+    for (; subg.vararg && idx < args.size(); ++idx)
+        subg.vararg->addOperand(args[idx]);
+
+    funcptr_calls.emplace_back(CInst, F);
+    funcptr_calls_set.emplace(CInst, F);
 
     return ret;
 }
 
+bool
+LLVMPointerSubgraphBuilder::isCompatibleCall(const PSNode *callsite,
+                                             const llvm::Function *F) const
+{
+    const llvm::CallInst *CInst = callsite->getUserData<llvm::CallInst>();
+
+    auto it = callbacks.find(callsite);
+    if (it == callbacks.end())
+        return llvmutils::callIsCompatible(F, CInst);
+
+    return llvmutils::callbackIsCompatible(F, it->second.size());
+}
+
+PSNode *
+LLVMPointerSubgraphBuilder::getFuncptrCallNode(const llvm::CallInst *CInst)
+{
+    auto it = callback_nodes.find(CInst);
+    if (it != callback_nodes.end())
+        return it->second;
+
+    return getNode(CInst);
+}
+
 PSNodesSeq
 LLVMPointerSubgraphBuilder::createOrGetSubgraph(const llvm::CallInst *CInst,
                                                 const llvm::Function *F)
@@ -732,7 +772,7 @@ LLVMPointerSubgraphBuilder::createUnknownCall(const llvm::CallInst *CInst)
     // inside bitcast - it defaults to int, but is bitcased
     // to pointer
     //assert(CInst->getType()->isPointerTy());
-    PSNode *call = new PSNode(pta::CALL, nullptr);
+    PSNode *call = PS->createNode(pta::CALL, nullptr);
 
     call->setPairedNode(call);
 
@@ -744,6 +784,98 @@ LLVMPointerSubgraphBuilder::createUnknownCall(const llvm::CallInst *CInst)
     return std::make_pair(call, call);
 }
 
+// create the nodes that do with pointers what the library function does
+PSNodesSeq
+LLVMPointerSubgraphBuilder::createLibraryCall(const llvm::CallInst *CInst,
+                                              const LibraryFunctionSummary& S)
+{
+    PSNode *first = nullptr, *last = nullptr;
+    auto append = [&first, &last](PSNode *n) {
+        if (last)
+            last->addSuccessor(n);
+        else
+            first = n;
+        last = n;
+    };
+
+    if (S.copy_src != LibraryFunctionSummary::NONE) {
+        PSNode *src = getOperand(CInst->getArgOperand(S.copy_src));
+        PSNode *dest = getOperand(CInst->getArgOperand(S.copy_dst));
+        append(PS->createNode(MEMCPY, src, dest,
+                              UNKNOWN_OFFSET, UNKNOWN_OFFSET));
+    }
+
+    if (S.store_src != LibraryFunctionSummary::NONE) {
+        // the stored pointer points somewhere into the memory
+        PSNode *ptr = PS->createNode(pta::GEP,
+                                     getOperand(CInst->getArgOperand(S.store_src)),
+                                     UNKNOWN_OFFSET);
+        append(ptr);
+        append(PS->createNode(pta::STORE, ptr,
+                              getOperand(CInst->getArgOperand(S.store_dst))));
+    }
+
+    if (S.call_fn != LibraryFunctionSummary::NONE) {
+        // the library function calls the function pointed by the operand,
+        // the call is resolved in the same way as calls via function pointers
+        std::vector<PSNode *> args;
+        for (const auto& a : S.call_args) {
+            PSNode *op = getOperand(CInst->getArgOperand(a.arg));
+            if (a.inside)
+                args.push_back(PS->createNode(pta::GEP, op, UNKNOWN_OFFSET));
+            else
+                args.push_back(PS->createNode(pta::CAST, op));
+            append(args.back());
+        }
+
+        PSNode *op = getOperand(CInst->getArgOperand(S.call_fn));
+        PSNode *call_funcptr = PS->createNode(pta::CALL_FUNCPTR, op);
+        PSNode *ret_call = PS->createNode(RETURN, nullptr);
+
+        ret_call->setPairedNode(call_funcptr);
+        call_funcptr->setPairedNode(ret_call);
+        call_funcptr->setUserData(const_cast<llvm::CallInst *>(CInst));
+
+        append(call_funcptr);
+        append(ret_call);
+
+        callbacks[call_funcptr] = std::move(args);
+        callback_nodes[CInst] = call_funcptr;
+    }
+
+    PSNode *ret = nullptr;
+    if (S.ret_alloc) {
+        ret = PS->createNode(pta::DYN_ALLOC);
+        ret->setIsHeap();
+    } else if (S.ret_arg != LibraryFunctionSummary::NONE) {
+        PSNode *op = getOperand(CInst->getArgOperand(S.ret_arg));
+        if (S.ret_inside)
+            ret = PS->createNode(pta::GEP, op, UNKNOWN_OFFSET);
+        else
+            ret = PS->createNode(pta::CAST, op);
+    }
+
+    if (ret && S.ret_null) {
+        append(ret);
+        ret = PS->createNode(pta::PHI, ret, NULLPTR, nullptr);
+    }
+
+    // the function returns a pointer that we know nothing about
+    // (or we just need some node for the call)
+    if (!ret && (CInst->getType()->isPointerTy() || !last)) {
+        ret = PS->createNode(pta::CALL, nullptr);
+        ret->setPairedNode(ret);
+        ret->addPointsTo(PointerUnknown);
+    }
+
+    if (ret)
+        append(ret);
+
+    // the last node is the 'real' node for the call
+    addNode(CInst, PSNodesSeq(first, last));
+    return PSNodesSeq(first, last);
+}
+
 PSNode *LLVMPointerSubgraphBuilder::createMemTransfer(const llvm::IntrinsicInst *I)
 {
     using namespace llvm;
@@ -764,7 +896,7 @@ PSNode *LLVMPointerSubgraphBuilder::createMemTransfer(const llvm::IntrinsicInst
     PSNode *destNode = getOperand(dest);
     PSNode *srcNode = getOperand(src);
     /* FIXME: compute correct value instead of UNKNOWN_OFFSET */
-    PSNode *node = new PSNode(MEMCPY, srcNode, destNode,
+    PSNode *node = PS->createNode(MEMCPY, srcNode, destNode,
                               UNKNOWN_OFFSET, UNKNOWN_OFFSET);
 
     addNode(I, node);
@@ -789,7 +921,7 @@ LLVMPointerSubgraphBuilder::createVarArg(const llvm::IntrinsicInst *Inst)
     // vastart will be node that will keep the memory
     // with pointers, its argument is the alloca, that
     // alloca will keep pointer to vastart
-    PSNode *vastart = new PSNode(pta::ALLOC);
+    PSNode *vastart = PS->createNode(pta::ALLOC);
 
     // vastart has only one operand which is the struct
     // it uses for storing the va arguments. Strip it so that we'll
@@ -800,10 +932,10 @@ LLVMPointerSubgraphBuilder::createVarArg(const llvm::IntrinsicInst *Inst)
     // get node with the same pointer, but with UNKNOWN_OFFSET
     // FIXME: we're leaking it
     // make the memory in alloca point to our memory in vastart
-    PSNode *ptr = new PSNode(pta::CONSTANT, op, UNKNOWN_OFFSET);
-    PSNode *S1 = new PSNode(pta::STORE, vastart, ptr);
+    PSNode *ptr = PS->createNode(pta::CONSTANT, op, UNKNOWN_OFFSET);
+    PSNode *S1 = PS->createNode(pta::STORE, vastart, ptr);
     // and also make vastart point to the vararg args
-    PSNode *S2 = new PSNode(pta::STORE, arg, vastart);
+    PSNode *S2 = PS->createNode(pta::STORE, arg, vastart);
 
     vastart->addSuccessor(S1);
     S1->addSuccessor(S2);
@@ -862,7 +994,7 @@ LLVMPointerSubgraphBuilder::createAsm(const llvm::Instruction *Inst)
         warned = true;
     }
 
-    PSNode *n = new PSNode(pta::CONSTANT, UNKNOWN_MEMORY, UNKNOWN_OFFSET);
+    PSNode *n = PS->createNode(pta::CONSTANT, UNKNOWN_MEMORY, UNKNOWN_OFFSET);
     // it is call that returns pointer, so we'd like to have
     // a 'return' node that contains that pointer
     n->setPairedNode(n);
@@ -901,6 +1033,9 @@ LLVMPointerSubgraphBuilder::createCall(const llvm::Instruction *Inst)
                 return createDynamicMemAlloc(CInst, type);
             } else if (func->isIntrinsic()) {
                 return createIntrinsic(Inst);
+            } else if (const LibraryFunctionSummary *S
+                        = llvmutils::getLibrarySummary(summaries, CInst, func)) {
+                return createLibraryCall(CInst, *S);
             } else
                 return createUnknownCall(CInst);
         } else {
@@ -909,10 +1044,8 @@ LLVMPointerSubgraphBuilder::createCall(const llvm::Instruction *Inst)
     } else {
         // function pointer call
         PSNode *op = getOperand(calledVal);
-        PSNode *call_funcptr = new PSNode(pta::CALL_FUNCPTR, op);
-        PSNode *ret_call = new PSNode(RETURN, nullptr);
-
-        dummy_nodes.push_back(ret_call);
+        PSNode *call_funcptr = PS->createNode(pta::CALL_FUNCPTR, op);
+        PSNode *ret_call = PS->createNode(RETURN, nullptr);
 
         ret_call->setPairedNode(call_funcptr);
         call_funcptr->setPairedNode(ret_call);
@@ -926,7 +1059,7 @@ LLVMPointerSubgraphBuilder::createCall(const llvm::Instruction *Inst)
 
 PSNode *LLVMPointerSubgraphBuilder::createAlloc(const llvm::Instruction *Inst)
 {
-    PSNode *node = new PSNode(pta::ALLOC);
+    PSNode *node = PS->createNode(pta::ALLOC);
     addNode(Inst, node);
 
     const llvm::AllocaInst *AI = llvm::dyn_cast<llvm::AllocaInst>(Inst);
@@ -943,7 +1076,7 @@ PSNode *LLVMPointerSubgraphBuilder::createStore(const llvm::Instruction *Inst)
     PSNode *op1 = getOperand(valOp);
     PSNode *op2 = getOperand(Inst->getOperand(1));
 
-    PSNode *node = new PSNode(pta::STORE, op1, op2);
+    PSNode *node = PS->createNode(pta::STORE, op1, op2);
     addNode(Inst, node);
 
     assert(node);
@@ -955,7 +1088,7 @@ PSNode *LLVMPointerSubgraphBuilder::createLoad(const llvm::Instruction *Inst)
     const llvm::Value *op = Inst->getOperand(0);
 
     PSNode *op1 = getOperand(op);
-    PSNode *node = new PSNode(pta::LOAD, op1);
+    PSNode *node = PS->createNode(pta::LOAD, op1);
 
     addNode(Inst, node);
 
@@ -963,6 +1096,49 @@ PSNode *LLVMPointerSubgraphBuilder::createLoad(const llvm::Instruction *Inst)
     return node;
 }
 
+// Get the offset of GEP with variable indices (e.g. &a[i].f) as
+// const + k*stride, where the stride is the gcd of the sizes
+// of the elements indexed by the variables.
+// Return UNKNOWN_OFFSET if the offset cannot be expressed like that
+static Offset getStridedOffset(const llvm::GetElementPtrInst *GEP,
+                               const llvm::DataLayout *DL)
+{
+    using namespace llvm;
+
+    int64_t base = 0;
+    uint64_t stride = 0;
+
+    // the type that is indexed by the current index,
+    // the first index goes over the pointer
+    Type *container = GEP->getPointerOperand()->getType();
+    for (auto GTI = gep_type_begin(GEP), GTE = gep_type_end(GEP);
+         GTI != GTE; ++GTI) {
+        const Value *idx = GTI.getOperand();
+        Type *elemTy = GTI.getIndexedType();
+
+        if (StructType *STy = dyn_cast<StructType>(container)) {
+            // the indices into structures are always constant
+            unsigned field = cast<ConstantInt>(idx)->getZExtValue();
+            base += DL->getStructLayout(STy)->getElementOffset(field);
+        } else {
+            uint64_t size = DL->getTypeAllocSize(elemTy);
+            if (const ConstantInt *C = dyn_cast<ConstantInt>(idx))
+                base += C->getSExtValue() * static_cast<int64_t>(size);
+            else
+                stride = Offset::gcd(stride, size);
+        }
+
+        container = elemTy;
+    }
+
+    // all the indices were constant, but accumulateConstantOffset
+    // failed (e.g. vector indices), so give up
+    if (stride == 0)
+        return UNKNOWN_OFFSET;
+
+    return Offset::getStrided(base, stride);
+}
+
 PSNode *LLVMPointerSubgraphBuilder::createGEP(const llvm::Instruction *Inst)
 {
     using namespace llvm;
@@ -982,17 +1158,24 @@ PSNode *LLVMPointerSubgraphBuilder::createGEP(const llvm::Instruction *Inst)
             // is 0 < offset < field_sensitivity ?
             uint64_t off = offset.getLimitedValue(field_sensitivity);
             if (off == 0 || off < field_sensitivity)
-                node = new PSNode(pta::GEP, op, offset.getZExtValue());
+                node = PS->createNode(pta::GEP, op,
+                                      *Offset::getConcrete(offset.getZExtValue()));
         } else
             errs() << "WARN: GEP offset greater than " << bitwidth << "-bit";
             // fall-through to UNKNOWN_OFFSET in this case
+    } else if (field_sensitivity > 0) {
+        // the offset is not constant, but in arrays of structures
+        // we still know which field is accessed
+        Offset off = getStridedOffset(GEP, DL);
+        if (off.isStrided() && off.getBase() < field_sensitivity)
+            node = PS->createNode(pta::GEP, op, *off);
     }
 
     // we didn't create the node with concrete offset,
     // in which case we are supposed to create a node
     // with UNKNOWN_OFFSET
     if (!node)
-        node = new PSNode(pta::GEP, op, UNKNOWN_OFFSET);
+        node = PS->createNode(pta::GEP, op, UNKNOWN_OFFSET);
 
     addNode(Inst, node);
 
@@ -1010,7 +1193,7 @@ PSNode *LLVMPointerSubgraphBuilder::createSelect(const llvm::Instruction *Inst)
     PSNode *op2 = getOperand(Inst->getOperand(2));
 
     // select works as a PHI in points-to analysis
-    PSNode *node = new PSNode(pta::PHI, op1, op2, nullptr);
+    PSNode *node = PS->createNode(pta::PHI, op1, op2, nullptr);
     addNode(Inst, node);
 
     assert(node);
@@ -1027,8 +1210,8 @@ LLVMPointerSubgraphBuilder::createExtract(const llvm::Instruction *Inst)
     // extract <agg> <idx> {<idx>, ...}
     PSNode *op1 = getOperand(EI->getAggregateOperand());
     // FIXME: get the correct offset
-    PSNode *G = new PSNode(pta::GEP, op1, UNKNOWN_OFFSET);
-    PSNode *L = new PSNode(pta::LOAD, G);
+    PSNode *G = PS->createNode(pta::GEP, op1, UNKNOWN_OFFSET);
+    PSNode *L = PS->createNode(pta::LOAD, G);
 
     G->addSuccessor(L);
 
@@ -1040,7 +1223,7 @@ LLVMPointerSubgraphBuilder::createExtract(const llvm::Instruction *Inst)
 
 PSNode *LLVMPointerSubgraphBuilder::createPHI(const llvm::Instruction *Inst)
 {
-    PSNode *node = new PSNode(pta::PHI, nullptr);
+    PSNode *node = PS->createNode(pta::PHI, nullptr);
     addNode(Inst, node);
 
     // NOTE: we didn't add operands to PHI node here, but after building
@@ -1080,7 +1263,7 @@ PSNode *LLVMPointerSubgraphBuilder::createCast(const llvm::Instruction *Inst)
     if (!op1)
         op1 = UNKNOWN_MEMORY;
 
-    PSNode *node = new PSNode(pta::CAST, op1);
+    PSNode *node = PS->createNode(pta::CAST, op1);
 
     addNode(Inst, node);
 
@@ -1097,7 +1280,7 @@ PSNode *LLVMPointerSubgraphBuilder::createUnknown(const llvm::Value *val)
     // completely change the value of pointer...
 
     // FIXME: or there's enough unknown offset? Check it out!
-    PSNode *node = new PSNode(pta::CONSTANT, UNKNOWN_MEMORY, UNKNOWN_OFFSET);
+    PSNode *node = PS->createNode(pta::CONSTANT, UNKNOWN_MEMORY, UNKNOWN_OFFSET);
 
     addNode(val, node);
 
@@ -1115,8 +1298,8 @@ PSNode *LLVMPointerSubgraphBuilder::createPtrToInt(const llvm::Instruction *Inst
     // just casting the value do gep with unknown offset -
     // this way we cover any shift of the pointer due to arithmetic
     // operations
-    // PSNode *node = new PSNode(pta::CAST, op1);
-    PSNode *node = new PSNode(pta::GEP, op1, 0);
+    // PSNode *node = PS->createNode(pta::CAST, op1);
+    PSNode *node = PS->createNode(pta::GEP, op1, 0);
     addNode(Inst, node);
 
     // here we lost the type information,
@@ -1143,7 +1326,7 @@ PSNode *LLVMPointerSubgraphBuilder::createIntToPtr(const llvm::Instruction *Inst
     } else
         op1 = getOperand(op);
 
-    PSNode *node = new PSNode(pta::CAST, op1);
+    PSNode *node = PS->createNode(pta::CAST, op1);
     addNode(Inst, node);
 
     // here we lost the type information,
@@ -1188,7 +1371,7 @@ PSNode *LLVMPointerSubgraphBuilder::createAdd(const llvm::Instruction *Inst)
     if (val)
         off = getConstantValue(val);
 
-    node = new PSNode(pta::GEP, op, off);
+    node = PS->createNode(pta::GEP, op, off);
     addNode(Inst, node);
 
     assert(node);
@@ -1223,7 +1406,7 @@ PSNode *LLVMPointerSubgraphBuilder::createArithmetic(const llvm::Instruction *In
 
     // we don't know what the operation does,
     // so set unknown offset
-    node = new PSNode(pta::GEP, op, UNKNOWN_OFFSET);
+    node = PS->createNode(pta::GEP, op, UNKNOWN_OFFSET);
     addNode(Inst, node);
 
     assert(node);
@@ -1255,7 +1438,7 @@ PSNode *LLVMPointerSubgraphBuilder::createReturn(const llvm::Instruction *Inst)
     assert((op1 || !retVal || !retVal->getType()->isPointerTy())
            && "Don't have operand for ReturnInst with pointer");
 
-    PSNode *node = new PSNode(pta::RETURN, op1, nullptr);
+    PSNode *node = PS->createNode(pta::RETURN, op1, nullptr);
     addNode(Inst, node);
 
     return node;
@@ -1321,7 +1504,8 @@ void LLVMPointerSubgraphBuilder::transitivelyBuildUses(const llvm::Value *val)
     }
 }
 
-static bool isRelevantCall(const llvm::Instruction *Inst)
+static bool isRelevantCall(const llvm::Instruction *Inst,
+                           const LibrarySummaries *summaries)
 {
     using namespace llvm;
 
@@ -1350,6 +1534,12 @@ static bool isRelevantCall(const llvm::Instruction *Inst)
         if (Inst->getType()->isPointerTy())
             return true;
 
+        // the library functions that create or copy pointers
+        const LibraryFunctionSummary *S
+            = llvmutils::getLibrarySummary(summaries, CInst, func);
+        if (S && S->hasPointerEffects())
+            return true;
+
         // XXX: what if undefined function takes as argument pointer
         // to memory with pointers? In that case to be really sound
         // we should make those pointers unknown. Another case is
@@ -1501,7 +1691,7 @@ bool LLVMPointerSubgraphBuilder::isRelevantInstruction(const llvm::Instruction&
             else
                 return false;
         case Instruction::Call:
-            if (isRelevantCall(&Inst))
+            if (isRelevantCall(&Inst, summaries))
                 return true;
             else
                 return false;
@@ -1531,7 +1721,7 @@ PSNode *LLVMPointerSubgraphBuilder::createArgument(const llvm::Argument *farg)
 {
     using namespace llvm;
 
-    PSNode *arg = new PSNode(pta::PHI, nullptr);
+    PSNode *arg = PS->createNode(pta::PHI, nullptr);
     addNode(farg, arg);
 
     return arg;
@@ -1571,8 +1761,8 @@ LLVMPointerSubgraphBuilder::createMemSet(const llvm::Instruction *Inst)
 
     PSNode *op = getOperand(Inst->getOperand(0)->stripInBoundsOffsets());
     // we need to make unknown offsets
-    PSNode *G = new PSNode(pta::GEP, op, UNKNOWN_OFFSET);
-    PSNode *S = new PSNode(pta::STORE, val, G);
+    PSNode *G = PS->createNode(pta::GEP, op, UNKNOWN_OFFSET);
+    PSNode *S = PS->createNode(pta::STORE, val, G);
     G->addSuccessor(S);
 
     PSNodesSeq ret = PSNodesSeq(G, S);
@@ -1645,14 +1835,14 @@ PSNode *LLVMPointerSubgraphBuilder::buildFunction(const llvm::Function& F)
     // just for our convenience when building the graph, they can be
     // optimized away later since they are noops
     // XXX: do we need entry type?
-    PSNode *root = new PSNode(pta::ENTRY);
-    PSNode *ret = new PSNode(pta::NOOP);
+    PSNode *root = PS->createNode(pta::ENTRY);
+    PSNode *ret = PS->createNode(pta::NOOP);
 
     // if the function has variable arguments,
     // then create the node for it
     PSNode *vararg = nullptr;
     if (F.isVarArg())
-        vararg = new PSNode(pta::PHI, nullptr);
+        vararg = PS->createNode(pta::PHI, nullptr);
 
     // add record to built graphs here, so that subsequent call of this function
     // from buildPointerSubgraphBlock won't get stuck in infinite recursive call when
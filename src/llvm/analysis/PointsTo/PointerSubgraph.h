@@ -1,7 +1,9 @@
 #ifndef _LLVM_DG_POINTER_SUBGRAPH_H_
 #define _LLVM_DG_POINTER_SUBGRAPH_H_
 
+#include <set>
 #include <unordered_map>
+#include <vector>
 
 #include <llvm/Support/raw_os_ostream.h>
 #include <llvm/IR/Instructions.h>
@@ -10,6 +12,7 @@
 
 #include "analysis/PointsTo/PointerSubgraph.h"
 #include "analysis/PointsTo/Pointer.h"
+#include "llvm/analysis/LibrarySummaries.h"
 
 namespace dg {
 namespace analysis {
@@ -20,8 +23,12 @@ typedef std::pair<PSNode *, PSNode *> PSNodesSeq;
 class LLVMPointerSubgraphBuilder
 {
     const llvm::Module *M;
+    // the subgraph that owns the built nodes
+    PointerSubgraph *PS;
     const llvm::DataLayout *DL;
     uint64_t field_sensitivity;
+    // what the undefined functions do (nullptr = nothing is known)
+    const LibrarySummaries *summaries;
 
     // build pointer state subgraph for given graph
     // \return   root node of the graph
@@ -63,22 +70,40 @@ class LLVMPointerSubgraphBuilder
     // here we'll keep first and last nodes of every built block and
     // connected together according to successors
     std::map<const llvm::BasicBlock *, PSNodesSeq> built_blocks;
-    // helper nodes, here we store them to delete the memory later
-    std::vector<PSNode *> dummy_nodes;
+
+    // the calls via function pointers that were built during
+    // the analysis, in the order in which they were built
+    std::vector<std::pair<const llvm::CallInst *,
+                          const llvm::Function *> > funcptr_calls;
+    std::set<std::pair<const llvm::CallInst *,
+                       const llvm::Function *> > funcptr_calls_set;
+
+    // the calls of functions that library functions (e.g. qsort)
+    // make via function pointer -- the CALL_FUNCPTR node
+    // and the nodes of the pointers that are passed to the function
+    std::unordered_map<const PSNode *, std::vector<PSNode *> > callbacks;
+    std::unordered_map<const llvm::CallInst *, PSNode *> callback_nodes;
 
 public:
     // \param field_sensitivity -- how much should be the PS field sensitive:
     //        UNKNOWN_OFFSET means full field sensitivity, 0 means field insensivity
     //        (every pointer with offset greater than 0 will have UNKNOWN_OFFSET)
-    LLVMPointerSubgraphBuilder(const llvm::Module *m,
+    // \param ps -- the subgraph that will own the nodes
+    LLVMPointerSubgraphBuilder(const llvm::Module *m, PointerSubgraph *ps,
                                uint64_t field_sensitivity = UNKNOWN_OFFSET)
-        : M(m), DL(new llvm::DataLayout(m)), field_sensitivity(field_sensitivity)
+        : M(m), PS(ps), DL(new llvm::DataLayout(m)),
+          field_sensitivity(field_sensitivity),
+          summaries(&LibrarySummaries::getBuiltin())
         {}
 
     ~LLVMPointerSubgraphBuilder();
 
     PSNode *buildLLVMPointerSubgraph();
 
+    // the summaries of library functions to use instead of
+    // treating them as unknown functions (nullptr = none)
+    void setLibrarySummaries(const LibrarySummaries *s) { summaries = s; }
+
     // create subgraph of function @F (the nodes)
     // and call+return nodes to/from it. This function
     // won't add the CFG edges if not @with_structure
@@ -89,12 +114,41 @@ public:
     createFuncptrCall(const llvm::CallInst *CInst,
                       const llvm::Function *F);
 
+    // call @F from the library function that is called by @callsite
+    PSNodesSeq
+    createCallbackCall(PSNode *callsite, const llvm::Function *F);
+
+    // is @callsite a call made by a library function (e.g. qsort)?
+    bool isCallback(const PSNode *callsite) const
+    {
+        return callbacks.count(callsite) > 0;
+    }
+
+    // can @F be called from the CALL_FUNCPTR node @callsite?
+    bool isCompatibleCall(const PSNode *callsite,
+                          const llvm::Function *F) const;
+
+    // the CALL_FUNCPTR node of the call via function pointer @CInst
+    // (or of the call that the library function @CInst makes)
+    PSNode *getFuncptrCallNode(const llvm::CallInst *CInst);
+
 
     // let the user get the nodes map, so that we can
     // map the points-to informatio back to LLVM nodes
     const std::unordered_map<const llvm::Value *, PSNodesSeq>&
                                 getNodesMap() const { return nodes_map; }
 
+    const std::vector<std::pair<const llvm::CallInst *,
+                                const llvm::Function *> >&
+                                getFuncptrCalls() const { return funcptr_calls; }
+
+    // was the call of @F via function pointer at @CInst built already?
+    bool hasFuncptrCall(const llvm::CallInst *CInst,
+                        const llvm::Function *F) const
+    {
+        return funcptr_calls_set.count(std::make_pair(CInst, F)) > 0;
+    }
+
     PSNode *getNode(const llvm::Value *val)
     {
         auto it = nodes_map.find(val);
@@ -212,6 +266,8 @@ private:
     PSNodesSeq createDynamicMemAlloc(const llvm::CallInst *CInst, int type);
     PSNodesSeq createRealloc(const llvm::CallInst *CInst);
     PSNodesSeq createUnknownCall(const llvm::CallInst *CInst);
+    PSNodesSeq createLibraryCall(const llvm::CallInst *CInst,
+                                 const LibraryFunctionSummary& S);
     PSNodesSeq createIntrinsic(const llvm::Instruction *Inst);
     PSNodesSeq createVarArg(const llvm::IntrinsicInst *Inst);
 };
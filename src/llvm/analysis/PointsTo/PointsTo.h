@@ -1,6 +1,12 @@
 #ifndef _LLVM_DG_POINTS_TO_ANALYSIS_H_
 #define _LLVM_DG_POINTS_TO_ANALYSIS_H_
 
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
 // ignore unused parameters in LLVM libraries
 #if (__clang__)
 #pragma clang diagnostic push
@@ -12,6 +18,7 @@
 
 #include <llvm/IR/Function.h>
 #include <llvm/IR/DataLayout.h>
+#include <llvm/IR/Module.h>
 #include <llvm/Support/raw_ostream.h>
 
 #if (__clang__)
@@ -22,8 +29,11 @@
 
 #include "analysis/PointsTo/PointerSubgraph.h"
 #include "analysis/PointsTo/PointerAnalysis.h"
+#include "analysis/PointsTo/PointsToFlowInsensitive.h"
+#include "analysis/PointsTo/PointsToDemandDriven.h"
 #include "llvm/llvm-utils.h"
 #include "llvm/analysis/PointsTo/PointerSubgraph.h"
+#include "llvm/analysis/PointsTo/PointsToCache.h"
 
 namespace dg {
 
@@ -31,6 +41,62 @@ using analysis::pta::PointerSubgraph;
 using analysis::pta::PSNode;
 using analysis::pta::LLVMPointerSubgraphBuilder;
 using analysis::pta::PSNodesSeq;
+using analysis::pta::LLVMPointsToCache;
+
+// build the subgraph for the call of @called via function pointer
+// at @callsite, returns true if the PointerSubgraph changed
+inline bool buildFunctionPointerCall(LLVMPointerSubgraphBuilder *builder,
+                                     PSNode *callsite, PSNode *called)
+{
+    // with vararg it may happen that we get pointer that
+    // is not to function, so just bail out here in that case
+    if (!llvm::isa<llvm::Function>(called->getUserData<llvm::Value>()))
+        return false;
+
+    const llvm::Function *F = called->getUserData<llvm::Function>();
+    const llvm::CallInst *CI = callsite->getUserData<llvm::CallInst>();
+
+    // incompatible prototypes, skip it...
+    if (!builder->isCompatibleCall(callsite, F))
+        return false;
+
+    if (F->size() == 0) {
+        // calling declaration that returns a pointer?
+        // That is unknown pointer
+        return callsite->getPairedNode()->addPointsTo(analysis::pta::PointerUnknown);
+    }
+
+    // the subgraph was built already (the call was resolved
+    // before the analysis, see LLVMPointerAnalysis::setFuncptrResolution)
+    if (builder->hasFuncptrCall(CI, F))
+        return false;
+
+    // create new instructions (the function can be called also
+    // by a library function, e.g. qsort, at the call @CI)
+    std::pair<PSNode *, PSNode *> cf
+        = builder->isCallback(callsite) ? builder->createCallbackCall(callsite, F)
+                                        : builder->createFuncptrCall(CI, F);
+    assert(cf.first && cf.second);
+
+    // we got the return site for the call stored as the paired node
+    PSNode *ret = callsite->getPairedNode();
+    // ret is a PHI node, so pass the values returned from the
+    // procedure call
+    ret->addOperand(cf.second);
+
+    // replace the edge from call->ret that we
+    // have due to connectivity of the graph until we
+    // insert the subgraph
+    if (callsite->successorsNum() == 1 &&
+        callsite->getSingleSuccessor() == ret) {
+        callsite->replaceSingleSuccessor(cf.first);
+    } else
+        callsite->addSuccessor(cf.first);
+
+    cf.second->addSuccessor(ret);
+
+    return true;
+}
 
 template <typename PTType>
 class LLVMPointerAnalysisImpl : public PTType
@@ -44,46 +110,7 @@ public:
     // build new subgraphs on calls via pointer
     virtual bool functionPointerCall(PSNode *callsite, PSNode *called)
     {
-        // with vararg it may happen that we get pointer that
-        // is not to function, so just bail out here in that case
-        if (!llvm::isa<llvm::Function>(called->getUserData<llvm::Value>()))
-            return false;
-
-        const llvm::Function *F = called->getUserData<llvm::Function>();
-        const llvm::CallInst *CI = callsite->getUserData<llvm::CallInst>();
-
-        // incompatible prototypes, skip it...
-        if (!llvmutils::callIsCompatible(F, CI))
-            return false;
-
-        if (F->size() == 0) {
-            // calling declaration that returns a pointer?
-            // That is unknown pointer
-            return callsite->getPairedNode()->addPointsTo(analysis::pta::PointerUnknown);
-        }
-
-        // create new instructions
-        std::pair<PSNode *, PSNode *> cf = builder->createFuncptrCall(CI, F);
-        assert(cf.first && cf.second);
-
-        // we got the return site for the call stored as the paired node
-        PSNode *ret = callsite->getPairedNode();
-        // ret is a PHI node, so pass the values returned from the
-        // procedure call
-        ret->addOperand(cf.second);
-
-        // replace the edge from call->ret that we
-        // have due to connectivity of the graph until we
-        // insert the subgraph
-        if (callsite->successorsNum() == 1 &&
-            callsite->getSingleSuccessor() == ret) {
-            callsite->replaceSingleSuccessor(cf.first);
-        } else
-            callsite->addSuccessor(cf.first);
-
-        cf.second->addSuccessor(ret);
-
-        return true;
+        return buildFunctionPointerCall(builder, callsite, called);
     }
 
     /*
@@ -120,31 +147,95 @@ public:
 
 class LLVMPointerAnalysis
 {
-    //const llvm::Module *M;
+public:
+    // when to build the subgraphs for calls via function pointers
+    enum FuncptrResolution {
+        // when the analysis finds the called function (default)
+        FUNCPTR_LAZY,
+        // before the analysis, every address-taken function with
+        // compatible signature may be called (sound, imprecise)
+        FUNCPTR_SIGNATURE,
+        // before the analysis, using the functions found
+        // by the flow-insensitive analysis
+        FUNCPTR_FLOW_INSENSITIVE
+    };
+
+private:
+    const llvm::Module *M;
+    uint64_t field_sensitivity;
+    const analysis::LibrarySummaries *summaries;
     PointerSubgraph *PS;
     LLVMPointerSubgraphBuilder *builder;
+    // the analysis that was run, we keep it so that the data
+    // that it stored in the nodes (memory objects) stay valid
+    analysis::pta::PointerAnalysis *PTA;
+
+    // options for the fixpoint computation (see PointerAnalysis)
+    bool diff_propagation;
+    bool scc_scheduling;
+    bool alias_classes;
+    bool cycle_detection;
+    bool merge_equivalent;
+    bool saturate_unknown;
+    unsigned threads_num;
+    bool freeze_subgraph;
+    FuncptrResolution funcptr_resolution;
+    // the budget of a query for the demand-driven analysis
+    size_t demand_budget;
+    // the file with the results of the previous run (empty = none)
+    std::string cache_file;
+    // the points-to sets were loaded from the cache file
+    bool results_loaded;
+
+    // the number of nodes processed by the last run (statistics)
+    size_t processed_nodes_num;
+    // the number of nodes collapsed by the last run (statistics)
+    size_t collapsed_nodes_num;
+    // the number of nodes substituted by equivalent nodes (statistics)
+    size_t substituted_nodes_num;
 
 public:
 
     LLVMPointerAnalysis(const llvm::Module *m,
                         uint64_t field_sensitivity = UNKNOWN_OFFSET)
-        : /*M(m),*/ PS(new PointerSubgraph()),
-          builder(new LLVMPointerSubgraphBuilder(m, field_sensitivity)) {}
+        : M(m), field_sensitivity(field_sensitivity),
+          summaries(&analysis::LibrarySummaries::getBuiltin()),
+          PS(new PointerSubgraph()),
+          builder(new LLVMPointerSubgraphBuilder(m, PS, field_sensitivity)),
+          PTA(nullptr),
+          diff_propagation(false), scc_scheduling(false),
+          alias_classes(false), cycle_detection(false), merge_equivalent(false),
+          saturate_unknown(false), threads_num(1),
+          freeze_subgraph(false), funcptr_resolution(FUNCPTR_LAZY),
+          demand_budget(0), results_loaded(false),
+          processed_nodes_num(0), collapsed_nodes_num(0),
+          substituted_nodes_num(0) {}
 
     ~LLVMPointerAnalysis()
     {
+        delete PTA;
         delete PS;
         delete builder;
     }
 
+    // the demand-driven analysis computes the points-to
+    // set of the node when we ask for the node
     PSNode *getNode(const llvm::Value *val)
     {
-        return builder->getNode(val);
+        PSNode *n = builder->getNode(val);
+        if (PTA && !results_loaded)
+            PTA->resolve(n);
+
+        return n;
     }
 
     PSNode *getPointsTo(const llvm::Value *val)
     {
-        return builder->getPointsTo(val);
+        PSNode *n = builder->getPointsTo(val);
+        if (PTA && !results_loaded)
+            PTA->resolve(n);
+
+        return n;
     }
 
     const std::unordered_map<const llvm::Value *, PSNodesSeq>&
@@ -158,17 +249,302 @@ public:
         PS->getNodes(cont);
     }
 
+    // process only the new pointers of operands
+    // instead of all of them in every iteration
+    void setDifferencePropagation(bool diff) { diff_propagation = diff; }
+    // process the SCCs of the PointerSubgraph in topological order
+    void setSCCScheduling(bool scc) { scc_scheduling = scc; }
+    // solve the nodes grouped by the alias classes one group
+    // after another (flow-insensitive analysis only)
+    void setAliasClassesScheduling(bool ac) { alias_classes = ac; }
+    // collapse the cycles of copy nodes into one node
+    void setCycleDetection(bool cd) { cycle_detection = cd; }
+    // remove nodes with provably the same points-to set
+    // as other nodes before running the analysis
+    void setMergeEquivalent(bool me) { merge_equivalent = me; }
+    // keep only the unknown pointer (and the pointers to functions)
+    // in the sets with the unknown pointer, see
+    // PointerAnalysis::setSaturateUnknown()
+    void setSaturateUnknown(bool sat) { saturate_unknown = sat; }
+    bool getSaturateUnknown() const { return saturate_unknown; }
+    // solve in more threads (flow-insensitive analysis only)
+    void setThreadsNum(unsigned num) { threads_num = num; }
+    // build the compact (dense-id) form of the PointerSubgraph
+    // before running the analysis, see PointerSubgraph::freeze()
+    void setFreezeSubgraph(bool fr) { freeze_subgraph = fr; }
+    // build the subgraphs of calls via function pointers before
+    // the analysis, so that it runs on (almost) unchanging subgraph
+    void setFuncptrResolution(FuncptrResolution fr) { funcptr_resolution = fr; }
+    // the maximal number of nodes that the demand-driven analysis
+    // processes for one query before it solves everything (0 = unlimited)
+    void setDemandBudget(size_t b) { demand_budget = b; }
+    // load the points-to sets from the file if it has the results
+    // for this module and configuration, otherwise run the analysis
+    // and store the results into the file (see LLVMPointsToCache)
+    void setCacheFile(const std::string& path) { cache_file = path; }
+    // the summaries of library functions (nullptr = treat all
+    // undefined functions as unknown), the builtin summaries by default
+    void setLibrarySummaries(const analysis::LibrarySummaries *s)
+    {
+        summaries = s;
+        builder->setLibrarySummaries(s);
+    }
+    const analysis::LibrarySummaries *getLibrarySummaries() const
+    {
+        return summaries;
+    }
+    // were the points-to sets loaded from the cache file?
+    bool resultsLoaded() const { return results_loaded; }
+
+    size_t getProcessedNodesNum() const { return processed_nodes_num; }
+    size_t getCollapsedNodesNum() const { return collapsed_nodes_num; }
+    size_t getSubstitutedNodesNum() const { return substituted_nodes_num; }
+
     template <typename PTType>
     void run()
     {
         // build the subgraph
         assert(PS && "Incorrectly constructer PTA, missing PS");
-        PS->setRoot(builder->buildLLVMPointerSubgraph());
+        assert(builder && "Incorrectly constructer PTA, missing builder");
+        buildSubgraph();
+
+        // the substitution of equivalent nodes changes the subgraph,
+        // so the results cannot be mapped to a freshly built one
+        bool use_cache = !cache_file.empty() && !merge_equivalent;
+        std::unique_ptr<LLVMPointsToCache> cache;
+        if (use_cache) {
+            cache.reset(new LLVMPointsToCache(M, getConfigHash<PTType>()));
+            if (cache->open(cache_file)) {
+                createPTA<PTType>();
+                if (loadResults(cache.get()))
+                    return;
+
+                // the calls via function pointers may have changed
+                // the subgraph already, start from scratch
+                reset();
+                buildSubgraph();
+            }
+        }
+
+        resolveFunctionPointers();
 
         // run the analysis itself
-        assert(builder && "Incorrectly constructer PTA, missing builder");
-        LLVMPointerAnalysisImpl<PTType> PTA(PS, builder);
-        PTA.run();
+        createPTA<PTType>();
+        PTA->run();
+
+        processed_nodes_num = PTA->getProcessedNodesNum();
+        collapsed_nodes_num = PTA->getCollapsedNodesNum();
+        substituted_nodes_num = PTA->getSubstitutedNodesNum();
+
+        if (use_cache
+            && isComplete(static_cast<LLVMPointerAnalysisImpl<PTType> *>(PTA)))
+            cache->save(cache_file, PS->getNodes(PS->getRoot()),
+                        builder->getFuncptrCalls());
+    }
+
+private:
+    void buildSubgraph()
+    {
+        PS->setRoot(builder->buildLLVMPointerSubgraph());
+        if (freeze_subgraph)
+            PS->freeze();
+    }
+
+    // the analysis that builds the subgraphs for the calls
+    // via function pointers that it finds
+    class FuncptrPreAnalysis : public analysis::pta::PointsToFlowInsensitive
+    {
+        LLVMPointerSubgraphBuilder *builder;
+
+    public:
+        FuncptrPreAnalysis(PointerSubgraph *ps, LLVMPointerSubgraphBuilder *b)
+        : PointsToFlowInsensitive(ps, false), builder(b) {}
+
+        virtual bool functionPointerCall(PSNode *callsite, PSNode *called)
+        {
+            return buildFunctionPointerCall(builder, callsite, called);
+        }
+    };
+
+    static bool hasInitialPointsTo(PSNode *n)
+    {
+        switch (n->getType()) {
+            case analysis::pta::ALLOC:
+            case analysis::pta::DYN_ALLOC:
+            case analysis::pta::FUNCTION:
+            case analysis::pta::CONSTANT:
+            case analysis::pta::NULL_ADDR:
+            case analysis::pta::UNKNOWN_MEM:
+            case analysis::pta::CALL:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void resolveFunctionPointers()
+    {
+        if (funcptr_resolution == FUNCPTR_SIGNATURE)
+            resolveFunctionPointersBySignature();
+        else if (funcptr_resolution == FUNCPTR_FLOW_INSENSITIVE)
+            resolveFunctionPointersFI();
+    }
+
+    void resolveFunctionPointersBySignature()
+    {
+        // the address-taken functions with the same type
+        // are compatible with the same calls
+        std::map<const llvm::FunctionType *,
+                 std::vector<const llvm::Function *> > buckets;
+        for (const llvm::Function& F : *M) {
+            // calls of declarations do not change the subgraph,
+            // leave them for the analysis
+            if (F.hasAddressTaken() && F.size() > 0)
+                buckets[F.getFunctionType()].push_back(&F);
+        }
+
+        if (buckets.empty())
+            return;
+
+        // the built subgraphs can contain new calls via pointers
+        std::set<PSNode *> resolved;
+        bool changed;
+        do {
+            changed = false;
+            for (PSNode *n : PS->getNodes(PS->getRoot())) {
+                if (n->getType() != analysis::pta::CALL_FUNCPTR
+                    || !resolved.insert(n).second)
+                    continue;
+
+                for (auto& it : buckets) {
+                    if (!builder->isCompatibleCall(n, it.second.front()))
+                        continue;
+
+                    for (const llvm::Function *F : it.second)
+                        changed |= buildFunctionPointerCall(builder, n,
+                                                            builder->getPointsTo(F));
+                }
+            }
+
+            if (changed)
+                PS->structureChanged();
+        } while (changed);
+    }
+
+    void resolveFunctionPointersFI()
+    {
+        {
+            FuncptrPreAnalysis FI(PS, builder);
+            FI.run();
+        }
+
+        // the analysis must start from scratch, only the
+        // subgraphs that the flow-insensitive analysis built stay
+        for (PSNode *n : PS->getNodes(PS->getRoot())) {
+            if (!hasInitialPointsTo(n))
+                n->pointsTo.clear();
+        }
+    }
+
+    template <typename PTType>
+    void createPTA()
+    {
+        delete PTA;
+        LLVMPointerAnalysisImpl<PTType> *impl
+            = new LLVMPointerAnalysisImpl<PTType>(PS, builder);
+        setBudget(impl, demand_budget);
+        PTA = impl;
+        PTA->setDifferencePropagation(diff_propagation);
+        PTA->setSCCScheduling(scc_scheduling);
+        PTA->setAliasClassesScheduling(alias_classes);
+        PTA->setCycleDetection(cycle_detection);
+        PTA->setMergeEquivalent(merge_equivalent);
+        PTA->setSaturateUnknown(saturate_unknown);
+        PTA->setThreadsNum(threads_num);
+    }
+
+    void reset()
+    {
+        delete PTA;
+        delete builder;
+        delete PS;
+
+        PTA = nullptr;
+        PS = new PointerSubgraph();
+        builder = new LLVMPointerSubgraphBuilder(M, PS, field_sensitivity);
+        builder->setLibrarySummaries(summaries);
+    }
+
+    // the results of different analyses must not be mixed
+    // (we do not have RTTI, so use the name of the function
+    // instantiated with the analysis type)
+    template <typename PTType>
+    static const char *getAnalysisName() { return __PRETTY_FUNCTION__; }
+
+    template <typename PTType>
+    uint64_t getConfigHash() const
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (const char *c = getAnalysisName<PTType>(); *c; ++c) {
+            hash ^= static_cast<unsigned char>(*c);
+            hash *= 1099511628211ULL;
+        }
+
+        // the summaries change the subgraph
+        if (summaries)
+            hash ^= summaries->getHash() * 31;
+
+        // the saturation changes the results
+        if (saturate_unknown)
+            hash ^= 0x9e3779b97f4a7c15ULL;
+
+        return hash ^ field_sensitivity;
+    }
+
+    // replay the calls via function pointers and set the points-to
+    // sets from the cache. Returns false if the cache does not fit
+    bool loadResults(LLVMPointsToCache *cache)
+    {
+        std::vector<std::pair<PSNode *, PSNode *> > calls;
+        for (const LLVMPointsToCache::FuncptrCallT& call
+                : cache->getFuncptrCalls()) {
+            PSNode *callsite = builder->getFuncptrCallNode(call.first);
+            PSNode *called = builder->getNode(call.second);
+            if (!callsite || !called
+                || callsite->getType() != analysis::pta::CALL_FUNCPTR)
+                return false;
+
+            calls.emplace_back(callsite, called);
+        }
+
+        if (!calls.empty()) {
+            for (auto& call : calls)
+                PTA->functionPointerCall(call.first, call.second);
+            PS->structureChanged();
+        }
+
+        if (!cache->apply(PS->getNodes(PS->getRoot())))
+            return false;
+
+        results_loaded = true;
+        processed_nodes_num = 0;
+        collapsed_nodes_num = 0;
+        substituted_nodes_num = 0;
+        return true;
+    }
+
+    // the demand-driven analysis has only the results of the queries
+    static bool isComplete(analysis::pta::PointerAnalysis *) { return true; }
+    static bool isComplete(analysis::pta::PointsToDemandDriven *)
+    {
+        return false;
+    }
+
+    // only the demand-driven analysis has the budget
+    static void setBudget(analysis::pta::PointerAnalysis *, size_t) {}
+    static void setBudget(analysis::pta::PointsToDemandDriven *pta, size_t b)
+    {
+        pta->setBudget(b);
     }
 };
 
@@ -0,0 +1,417 @@
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ignore unused parameters in LLVM libraries
+#if (__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/raw_ostream.h>
+
+#if (__clang__)
+#pragma clang diagnostic pop // ignore -Wunused-parameter
+#else
+#pragma GCC diagnostic pop
+#endif
+
+#include "analysis/PointsTo/PointerAnalysis.h"
+#include "PointsToCache.h"
+
+namespace dg {
+namespace analysis {
+namespace pta {
+
+static const char MAGIC[4] = {'D', 'G', 'P', 'T'};
+static const uint32_t VERSION = 2;
+
+// the ids of special targets
+static const uint32_t NULLPTR_ID = ~0u;
+static const uint32_t UNKNOWN_MEMORY_ID = ~0u - 1;
+// the node or value has no id
+static const uint32_t NO_ID = ~0u;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t module_hash;
+    uint64_t config;
+    // the hash of everything after the header
+    uint64_t checksum;
+    uint32_t nodes_num;
+    uint32_t pointers_num;
+    uint32_t calls_num;
+    // the number of values in the module (see computeValueIds())
+    uint32_t values_num;
+};
+
+struct CachedPointer {
+    uint32_t target;
+    uint32_t reserved;
+    uint64_t offset;
+};
+
+// FNV-1a
+static inline uint64_t hashBytes(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static inline uint64_t hashValue(uint64_t hash, uint64_t val)
+{
+    return hashBytes(hash, &val, sizeof val);
+}
+
+static const uint64_t HASH_INIT = 14695981039346656037ULL;
+
+// the stream that computes the hash of what is printed into it,
+// so that we do not need to keep the printed module in memory
+class HashStream : public llvm::raw_ostream
+{
+    uint64_t hash;
+    uint64_t pos;
+
+    void write_impl(const char *ptr, size_t size) override
+    {
+        hash = hashBytes(hash, ptr, size);
+        pos += size;
+    }
+
+    uint64_t current_pos() const override { return pos; }
+
+public:
+    HashStream() : hash(HASH_INIT), pos(0) {}
+    ~HashStream() { flush(); }
+
+    uint64_t getHash() { flush(); return hash; }
+};
+
+// the hash of the contents of the file, false if it cannot be read
+static bool hashFile(const std::string& path, uint64_t& hash)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    hash = hashValue(HASH_INIT, st.st_size);
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+        return false;
+
+    hash = hashBytes(hash, mem, st.st_size);
+    munmap(mem, st.st_size);
+    return true;
+}
+
+static size_t getFileSize(uint32_t nodes_num, uint32_t pointers_num,
+                          uint32_t calls_num)
+{
+    size_t size = sizeof(Header)
+                  + 2 * sizeof(uint32_t) * static_cast<size_t>(calls_num)
+                  + sizeof(uint32_t) * (static_cast<size_t>(nodes_num) + 1);
+    // align the pointers
+    size = (size + 7) & ~static_cast<size_t>(7);
+    return size + sizeof(CachedPointer) * static_cast<size_t>(pointers_num);
+}
+
+LLVMPointsToCache::LLVMPointsToCache(const llvm::Module *m, uint64_t cfg)
+    : M(m), config(cfg), module_hash(0), data(nullptr), size(0)
+{
+    // the module is parsed from the file, hashing the file is much
+    // cheaper than hashing the printed module. The modules that do not
+    // come from a file (or the file is gone) are printed
+    if (!hashFile(M->getModuleIdentifier(), module_hash)) {
+        HashStream hs;
+        M->print(hs, nullptr);
+        module_hash = hs.getHash();
+    }
+
+    computeValueIds();
+}
+
+LLVMPointsToCache::~LLVMPointsToCache()
+{
+    close();
+}
+
+void LLVMPointsToCache::close()
+{
+    if (data)
+        munmap(const_cast<char *>(data), size);
+
+    data = nullptr;
+    size = 0;
+}
+
+void LLVMPointsToCache::computeValueIds()
+{
+    auto add = [this](const llvm::Value *val) {
+        value_ids.emplace(val, values.size());
+        values.push_back(val);
+    };
+
+    for (auto I = M->global_begin(), E = M->global_end(); I != E; ++I)
+        add(&*I);
+
+    for (const llvm::Function& F : *M)
+        add(&F);
+
+    for (const llvm::Function& F : *M) {
+        for (auto A = F.arg_begin(), E = F.arg_end(); A != E; ++A)
+            add(&*A);
+
+        for (const llvm::BasicBlock& B : F)
+            for (const llvm::Instruction& I : B)
+                add(&I);
+    }
+}
+
+uint32_t LLVMPointsToCache::getValueId(const llvm::Value *val) const
+{
+    auto it = value_ids.find(val);
+    if (it == value_ids.end())
+        return NO_ID;
+
+    return it->second;
+}
+
+bool LLVMPointsToCache::open(const std::string& path)
+{
+    close();
+    calls.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+
+    void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+        return false;
+
+    data = static_cast<const char *>(mem);
+    size = st.st_size;
+
+    const Header *hdr = reinterpret_cast<const Header *>(data);
+    if (memcmp(hdr->magic, MAGIC, sizeof MAGIC) != 0
+        || hdr->version != VERSION
+        || hdr->module_hash != module_hash
+        || hdr->config != config
+        || hdr->values_num != values.size()
+        || size != getFileSize(hdr->nodes_num, hdr->pointers_num,
+                               hdr->calls_num)
+        || hdr->checksum != hashBytes(HASH_INIT, data + sizeof(Header),
+                                      size - sizeof(Header))) {
+        close();
+        return false;
+    }
+
+    const uint32_t *call_ids
+        = reinterpret_cast<const uint32_t *>(data + sizeof(Header));
+    for (uint32_t i = 0; i < hdr->calls_num; ++i) {
+        uint32_t ci = call_ids[2*i];
+        uint32_t f = call_ids[2*i + 1];
+        if (ci >= values.size() || f >= values.size()
+            || !llvm::isa<llvm::CallInst>(values[ci])
+            || !llvm::isa<llvm::Function>(values[f])) {
+            close();
+            return false;
+        }
+
+        calls.emplace_back(llvm::cast<llvm::CallInst>(values[ci]),
+                           llvm::cast<llvm::Function>(values[f]));
+    }
+
+    return true;
+}
+
+bool LLVMPointsToCache::apply(const std::vector<PSNode *>& nodes)
+{
+    if (!data)
+        return false;
+
+    // the subgraph is built from the module and the configuration,
+    // both were checked in open(), so the nodes are the same
+    // as when the file was saved
+    const Header *hdr = reinterpret_cast<const Header *>(data);
+    if (hdr->nodes_num != nodes.size())
+        return false;
+
+    const uint32_t *starts
+        = reinterpret_cast<const uint32_t *>(data + sizeof(Header))
+          + 2 * hdr->calls_num;
+    const CachedPointer *pointers
+        = reinterpret_cast<const CachedPointer *>(
+            data + getFileSize(hdr->nodes_num, 0, hdr->calls_num));
+
+    // check the ranges first, so that we do not set
+    // only a part of the points-to sets
+    if (starts[0] != 0 || starts[hdr->nodes_num] != hdr->pointers_num)
+        return false;
+
+    for (uint32_t i = 0; i < hdr->nodes_num; ++i) {
+        if (starts[i] > starts[i + 1])
+            return false;
+    }
+
+    for (uint32_t i = 0; i < hdr->pointers_num; ++i) {
+        uint32_t t = pointers[i].target;
+        if (t >= nodes.size() && t != NULLPTR_ID && t != UNKNOWN_MEMORY_ID)
+            return false;
+    }
+
+    for (uint32_t i = 0; i < hdr->nodes_num; ++i) {
+        PSNode *n = nodes[i];
+        n->pointsTo.clear();
+
+        for (uint32_t j = starts[i]; j < starts[i + 1]; ++j) {
+            uint32_t t = pointers[j].target;
+            PSNode *target;
+            if (t == NULLPTR_ID)
+                target = NULLPTR;
+            else if (t == UNKNOWN_MEMORY_ID)
+                target = UNKNOWN_MEMORY;
+            else
+                target = nodes[t];
+
+            n->pointsTo.insert(Pointer(target, pointers[j].offset));
+        }
+    }
+
+    return true;
+}
+
+bool LLVMPointsToCache::save(const std::string& path,
+                             const std::vector<PSNode *>& nodes,
+                             const std::vector<FuncptrCallT>& funcptr_calls)
+{
+    std::unordered_map<PSNode *, uint32_t> ids;
+    ids.reserve(nodes.size());
+    for (uint32_t i = 0; i < nodes.size(); ++i)
+        ids.emplace(nodes[i], i);
+
+    std::vector<uint32_t> call_ids;
+    for (const FuncptrCallT& call : funcptr_calls) {
+        call_ids.push_back(getValueId(call.first));
+        call_ids.push_back(getValueId(call.second));
+        if (call_ids[call_ids.size() - 2] == NO_ID || call_ids.back() == NO_ID)
+            return false;
+    }
+
+    std::vector<uint32_t> starts;
+    std::vector<CachedPointer> pointers;
+    starts.reserve(nodes.size() + 1);
+    starts.push_back(0);
+    for (PSNode *n : nodes) {
+        for (const Pointer& ptr : n->pointsTo) {
+            CachedPointer cp;
+            cp.reserved = 0;
+            cp.offset = *ptr.offset;
+
+            if (ptr.target == NULLPTR) {
+                cp.target = NULLPTR_ID;
+            } else if (ptr.target == UNKNOWN_MEMORY) {
+                cp.target = UNKNOWN_MEMORY_ID;
+            } else {
+                auto it = ids.find(ptr.target);
+                // the target is not in the subgraph, we cannot store it
+                if (it == ids.end())
+                    return false;
+                cp.target = it->second;
+            }
+
+            pointers.push_back(cp);
+        }
+
+        starts.push_back(pointers.size());
+    }
+
+    Header hdr;
+    memcpy(hdr.magic, MAGIC, sizeof MAGIC);
+    hdr.version = VERSION;
+    hdr.module_hash = module_hash;
+    hdr.config = config;
+    hdr.nodes_num = nodes.size();
+    hdr.pointers_num = pointers.size();
+    hdr.calls_num = funcptr_calls.size();
+    hdr.values_num = values.size();
+
+    // the padding before the pointers
+    static const char zeros[8] = {0};
+    size_t written = sizeof hdr + (call_ids.size() + starts.size())
+                                  * sizeof(uint32_t);
+    size_t padding = ((written + 7) & ~static_cast<size_t>(7)) - written;
+
+    uint64_t checksum = HASH_INIT;
+    checksum = hashBytes(checksum, call_ids.data(),
+                         call_ids.size() * sizeof(uint32_t));
+    checksum = hashBytes(checksum, starts.data(),
+                         starts.size() * sizeof(uint32_t));
+    checksum = hashBytes(checksum, zeros, padding);
+    checksum = hashBytes(checksum, pointers.data(),
+                         pointers.size() * sizeof(CachedPointer));
+    hdr.checksum = checksum;
+
+    // write to a temporary file and rename it, so that a concurrent
+    // run never maps a half-written file
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        out.write(reinterpret_cast<const char *>(&hdr), sizeof hdr);
+        out.write(reinterpret_cast<const char *>(call_ids.data()),
+                  call_ids.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char *>(starts.data()),
+                  starts.size() * sizeof(uint32_t));
+        out.write(zeros, padding);
+
+        out.write(reinterpret_cast<const char *>(pointers.data()),
+                  pointers.size() * sizeof(CachedPointer));
+        if (!out)
+            return false;
+    }
+
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace pta
+} // namespace analysis
+} // namespace dg
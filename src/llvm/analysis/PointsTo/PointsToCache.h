@@ -0,0 +1,103 @@
+#ifndef _LLVM_DG_POINTS_TO_CACHE_H_
+#define _LLVM_DG_POINTS_TO_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Function.h>
+
+#include "analysis/PointsTo/PointerSubgraph.h"
+
+namespace dg {
+namespace analysis {
+namespace pta {
+
+// The points-to sets computed for a module stored in a binary file,
+// so that the next run on the same module does not need to run
+// the pointer analysis again. The file is mapped into memory
+// when loading.
+//
+// The nodes of the PointerSubgraph are identified by their order
+// in getNodes() (BFS from the root) - the subgraph built for the same
+// module is the same. The calls via function pointers that built new
+// parts of the subgraph during the analysis are stored too and must be
+// replayed before the points-to sets are set. The file contains the hash
+// of the module (of the bitcode file it was parsed from) and the hash
+// of the configuration of the analysis, so stale files are rejected,
+// and the checksum of the data, so corrupted files are rejected.
+// The subgraph is built from the module and the configuration,
+// so it is not hashed.
+//
+// The layout of the file:
+//
+//   Header
+//   uint32_t calls[calls_num][2]    (call instruction, function) value ids
+//   uint32_t starts[nodes_num + 1]  the pointers of node i are
+//                                   pointers[starts[i] .. starts[i + 1])
+//   CachedPointer pointers[pointers_num]
+class LLVMPointsToCache
+{
+public:
+    typedef std::pair<const llvm::CallInst *,
+                      const llvm::Function *> FuncptrCallT;
+
+    // @config -- the hash of the configuration of the analysis
+    LLVMPointsToCache(const llvm::Module *M, uint64_t config);
+    ~LLVMPointsToCache();
+
+    LLVMPointsToCache(const LLVMPointsToCache&) = delete;
+    LLVMPointsToCache& operator=(const LLVMPointsToCache&) = delete;
+
+    // map the file into memory and check that it is for this module
+    // and configuration. Returns false if the file does not exist,
+    // is corrupted or stale
+    bool open(const std::string& path);
+
+    // the calls via function pointers that must be replayed
+    // before apply() (valid after a successful open())
+    const std::vector<FuncptrCallT>& getFuncptrCalls() const
+    {
+        return calls;
+    }
+
+    // set the points-to sets of the nodes (the nodes are in the order
+    // of PointerSubgraph::getNodes()). Returns false (and does not
+    // change anything) if the subgraph is not the one from the file
+    bool apply(const std::vector<PSNode *>& nodes);
+
+    // store the points-to sets of the nodes into the file
+    bool save(const std::string& path, const std::vector<PSNode *>& nodes,
+              const std::vector<FuncptrCallT>& funcptr_calls);
+
+    uint64_t getModuleHash() const { return module_hash; }
+
+private:
+    const llvm::Module *M;
+    uint64_t config;
+    uint64_t module_hash;
+
+    // stable ids of values derived from their positions in the module
+    std::unordered_map<const llvm::Value *, uint32_t> value_ids;
+    std::vector<const llvm::Value *> values;
+
+    // the mapped file
+    const char *data;
+    size_t size;
+
+    std::vector<FuncptrCallT> calls;
+
+    void computeValueIds();
+    uint32_t getValueId(const llvm::Value *val) const;
+    void close();
+};
+
+} // namespace pta
+} // namespace analysis
+} // namespace dg
+
+#endif // _LLVM_DG_POINTS_TO_CACHE_H_
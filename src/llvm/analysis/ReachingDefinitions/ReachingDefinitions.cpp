@@ -397,8 +397,12 @@ RDNode *LLVMRDBuilder::createStore(const llvm::Instruction *Inst)
             continue;
         }
 
+        // reaching definitions do not handle strided offsets,
+        // these are treated as unknown
+        Offset off = ptr.offset.isConcrete() ? ptr.offset : UNKNOWN_OFFSET;
+
         uint64_t size;
-        if (ptr.offset.isUnknown()) {
+        if (off.isUnknown()) {
             size = UNKNOWN_OFFSET;
         } else {
             size = getAllocatedSize(Inst->getOperand(0)->getType(), DL);
@@ -426,7 +430,7 @@ RDNode *LLVMRDBuilder::createStore(const llvm::Instruction *Inst)
         //  there we have must alias for the malloc), we would loose the
         //  definitions for line 1 and we would get incorrect results
         bool strong_update = pts->pointsTo.size() == 1 && !pts->isHeap();
-        node->addDef(ptrNode, ptr.offset, size, strong_update);
+        node->addDef(ptrNode, off, size, strong_update);
     }
 
     assert(node);
@@ -719,6 +723,106 @@ RDNode *LLVMRDBuilder::createUndefinedCall(const llvm::CallInst *CInst)
     return node;
 }
 
+std::pair<RDNode *, RDNode *>
+LLVMRDBuilder::createLibraryCall(const llvm::CallInst *CInst,
+                                 const LibraryFunctionSummary& S)
+{
+    using namespace llvm;
+
+    // the function returns new memory, so this node
+    // works as an allocation in points-to
+    RDNode *node = new RDNode(S.ret_alloc ? DYN_ALLOC : CALL);
+    addNode(CInst, node);
+
+    // the function writes the new memory
+    if (S.ret_alloc)
+        node->addDef(node, 0, UNKNOWN_OFFSET);
+
+    uint64_t len = UNKNOWN_OFFSET;
+    if (S.size_arg != LibraryFunctionSummary::NONE) {
+        if (const ConstantInt *C
+                = dyn_cast<ConstantInt>(CInst->getArgOperand(S.size_arg)))
+            len = C->getLimitedValue();
+    }
+
+    // only the memory that the function writes is defined
+    for (unsigned int i = 0; i < CInst->getNumArgOperands(); ++i) {
+        if (!S.writes(i))
+            continue;
+
+        const Value *llvmOp = CInst->getArgOperand(i);
+
+        // constants cannot be redefined except for global variables
+        // (that are constant, but may point to non constant memory
+        const Value *strippedValue = llvmOp->stripPointerCasts();
+        if (isa<Constant>(strippedValue)) {
+            const GlobalVariable *GV = dyn_cast<GlobalVariable>(strippedValue);
+            if (!GV || GV->isConstant())
+                continue;
+        }
+
+        pta::PSNode *pts = PTA->getPointsTo(llvmOp);
+        if (!pts)
+            continue;
+
+        for (const pta::Pointer& ptr : pts->pointsTo) {
+            if (!ptr.isValid())
+                continue;
+
+            const llvm::Value *ptrVal = ptr.target->getUserData<llvm::Value>();
+            if (llvm::isa<llvm::Function>(ptrVal))
+                continue;
+
+            RDNode *target = getOperand(ptrVal);
+            assert(target && "Don't have pointer target for call argument");
+
+            // the function may write only a part of the memory
+            if (!ptr.offset.isConcrete())
+                node->addDef(target, UNKNOWN_OFFSET, UNKNOWN_OFFSET);
+            else
+                node->addDef(target, *ptr.offset, len);
+        }
+    }
+
+    if (S.call_fn == LibraryFunctionSummary::NONE)
+        return std::make_pair(node, node);
+
+    // the library function calls the functions pointed by the argument
+    // (e.g. qsort), maybe never, so the definitions from them reach
+    // the end of the call together with the definitions before the call
+    pta::PSNode *op = PTA->getPointsTo(CInst->getArgOperand(S.call_fn));
+    if (!op)
+        return std::make_pair(node, node);
+
+    RDNode *ret_call = nullptr;
+    for (const pta::Pointer& ptr : op->pointsTo) {
+        if (!ptr.isValid() || !isa<Function>(ptr.target->getUserData<Value>()))
+            continue;
+
+        const Function *F = ptr.target->getUserData<Function>();
+        if (F->size() == 0
+            || !llvmutils::callbackIsCompatible(F, S.call_args.size()))
+            continue;
+
+        std::pair<RDNode *, RDNode *> cf = createCallToFunction(F);
+        dummy_nodes.push_back(cf.first);
+
+        if (!ret_call) {
+            ret_call = new RDNode(CALL_RETURN);
+            dummy_nodes.push_back(ret_call);
+            node->addSuccessor(ret_call);
+        }
+
+        node->addSuccessor(cf.first);
+        cf.second->addSuccessor(ret_call);
+    }
+
+    if (!ret_call)
+        return std::make_pair(node, node);
+
+    return std::make_pair(node, ret_call);
+}
+
 RDNode *LLVMRDBuilder::createIntrinsicCall(const llvm::CallInst *CInst)
 {
     using namespace llvm;
@@ -765,8 +869,8 @@ RDNode *LLVMRDBuilder::createIntrinsicCall(const llvm::CallInst *CInst)
             continue;
 
         uint64_t from, to;
-        if (ptr.offset.isUnknown()) {
-            // if the offset is UNKNOWN, use whole memory
+        if (!ptr.offset.isConcrete()) {
+            // if the offset is UNKNOWN (or strided), use whole memory
             from = UNKNOWN_OFFSET;
             len = UNKNOWN_OFFSET;
         } else {
@@ -818,6 +922,10 @@ LLVMRDBuilder::createCall(const llvm::Instruction *Inst)
                     n = createRealloc(CInst);
                 else
                     n = createDynAlloc(CInst, type);
+            } else if (const LibraryFunctionSummary *S
+                        = llvmutils::getLibrarySummary(PTA->getLibrarySummaries(),
+                                            CInst, func)) {
+                return createLibraryCall(CInst, *S);
             } else {
                 n = createUndefinedCall(CInst);
             }
@@ -10,6 +10,7 @@
 
 #include "analysis/ReachingDefinitions/ReachingDefinitions.h"
 #include "llvm/analysis/PointsTo/PointsTo.h"
+#include "llvm/analysis/LibrarySummaries.h"
 
 namespace dg {
 namespace analysis {
@@ -107,6 +108,9 @@ private:
 
     RDNode *createIntrinsicCall(const llvm::CallInst *CInst);
     RDNode *createUndefinedCall(const llvm::CallInst *CInst);
+    std::pair<RDNode *, RDNode *>
+    createLibraryCall(const llvm::CallInst *CInst,
+                      const LibraryFunctionSummary& S);
 };
 
 class LLVMReachingDefinitions
@@ -116,6 +120,8 @@ class LLVMReachingDefinitions
     RDNode *root;
     bool strong_update_unknown;
     uint32_t max_set_size;
+    bool compact_graph;
+    bool rounds_scheduling;
 
 public:
     LLVMReachingDefinitions(const llvm::Module *m,
@@ -123,7 +129,16 @@ public:
                             bool strong_updt_unknown = false,
                             uint32_t max_set_sz = ~((uint32_t) 0))
         : builder(std::unique_ptr<LLVMRDBuilder>(new LLVMRDBuilder(m, pta))),
-          strong_update_unknown(strong_updt_unknown), max_set_size(max_set_sz) {}
+          strong_update_unknown(strong_updt_unknown), max_set_size(max_set_sz),
+          compact_graph(false), rounds_scheduling(false) {}
+
+    // remove the nodes that just pass the definitions
+    // to their successor before running the analysis,
+    // the mapping still gives the reaching definitions for them
+    void setCompactGraph(bool cg) { compact_graph = cg; }
+    // process all the nodes reachable from the changed nodes in rounds
+    // instead of processing the nodes from the worklist
+    void setRoundsScheduling(bool rs) { rounds_scheduling = rs; }
 
     void run()
     {
@@ -131,9 +146,23 @@ public:
         RDA = std::unique_ptr<ReachingDefinitionsAnalysis>(
             new ReachingDefinitionsAnalysis(root, strong_update_unknown, max_set_size)
             );
+        RDA->setCompactGraph(compact_graph);
+        RDA->setRoundsScheduling(rounds_scheduling);
         RDA->run();
     }
 
+    // the number of nodes before the compaction
+    // and the number of removed nodes (statistics)
+    size_t getNodesNum() const { return RDA ? RDA->getNodesNum() : 0; }
+    size_t getRemovedNodesNum() const
+    {
+        return RDA ? RDA->getRemovedNodesNum() : 0;
+    }
+
+    // the number of processed nodes and merged maps (statistics)
+    size_t getVisitsNum() const { return RDA ? RDA->getVisitsNum() : 0; }
+    size_t getMergesNum() const { return RDA ? RDA->getMergesNum() : 0; }
+
     RDNode *getNode(const llvm::Value *val)
     {
         return builder->getNode(val);
@@ -162,7 +191,7 @@ public:
         RDA->getNodes(cont);
     }
 
-    const RDMap& getReachingDefinitions(RDNode *n) const { return n->getReachingDefinitions(); }
+    const RDMap& getReachingDefinitions(const RDNode *n) const { return n->getReachingDefinitions(); }
     RDMap& getReachingDefinitions(RDNode *n) { return n->getReachingDefinitions(); }
     size_t getReachingDefinitions(RDNode *n, const Offset& off,
                                   const Offset& len, std::set<RDNode *>& ret)
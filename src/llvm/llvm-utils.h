@@ -5,6 +5,8 @@
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Instructions.h>
 
+#include "llvm/analysis/LibrarySummaries.h"
+
 namespace dg {
 namespace llvmutils {
 
@@ -75,6 +77,61 @@ inline bool callIsCompatible(const Function *F, const CallInst *CI)
     return true;
 }
 
+// can the given function be called by a library function
+// (e.g. qsort) that passes it @args_num pointers?
+inline bool callbackIsCompatible(const Function *F, size_t args_num)
+{
+    if (F->isVarArg()) {
+        if (F->arg_size() > args_num)
+            return false;
+    } else {
+        if (F->arg_size() != args_num)
+            return false;
+    }
+
+    for (auto A = F->arg_begin(), E = F->arg_end(); A != E; ++A)
+        if (!isPointerOrIntegerTy(A->getType()))
+            return false;
+
+    return true;
+}
+
+// get the summary of the library function @F called by the given
+// call inst, nullptr if there is none or it does not fit the call
+inline const analysis::LibraryFunctionSummary *
+getLibrarySummary(const analysis::LibrarySummaries *summaries,
+                  const CallInst *CI, const Function *F)
+{
+    using analysis::LibraryFunctionSummary;
+
+    if (!summaries || !F->hasName())
+        return nullptr;
+
+    const LibraryFunctionSummary *S = summaries->get(F->getName().str());
+    if (!S)
+        return nullptr;
+
+    unsigned max = S->getMaxArg();
+    if (max != LibraryFunctionSummary::NONE
+        && max >= CI->getNumArgOperands())
+        return nullptr;
+
+    // the arguments that are used as pointers must be pointers
+    for (unsigned idx : {S->ret_arg, S->copy_src, S->copy_dst,
+                         S->store_src, S->store_dst, S->call_fn}) {
+        if (idx != LibraryFunctionSummary::NONE
+            && !CI->getArgOperand(idx)->getType()->isPointerTy())
+            return nullptr;
+    }
+
+    for (const LibraryFunctionSummary::CallbackArg& a : S->call_args) {
+        if (!CI->getArgOperand(a.arg)->getType()->isPointerTy())
+            return nullptr;
+    }
+
+    return S;
+}
+
 } // namespace llvmutils
 } // namespace dg
 
@@ -4,7 +4,12 @@
 
 #include "test-runner.h"
 
+#include "ADT/Arena.h"
+#include "ADT/PersistentHashMap.h"
 #include "ADT/Queue.h"
+#include "ADT/SparseBitvector.h"
+#include "ADT/ThreadPool.h"
+#include "ADT/UnionFind.h"
 
 using namespace dg::ADT;
 
@@ -99,6 +104,231 @@ public:
     }
 };
 
+class TestSparseBitvector : public Test
+{
+public:
+    TestSparseBitvector() : Test("test sparse bitvector")
+    {}
+
+    void test()
+    {
+        SparseBitvector A, B;
+        check(A.empty(), "empty bitvector not empty");
+
+        check(A.set(1), "Set did not change the bitvector");
+        check(A.set(63), "Set did not change the bitvector");
+        check(A.set(64), "Set did not change the bitvector");
+        check(A.set(100000), "Set did not change the bitvector");
+        check(!A.set(64), "Set twice changed the bitvector");
+        check(A.size() == 4, "BUG in size");
+        check(A.wordsNum() == 3, "BUG in number of words");
+        check(A.get(63) && A.get(100000) && !A.get(2), "BUG in get");
+
+        // iterate in the increasing order
+        size_t expected[] = {1, 63, 64, 100000};
+        int i = 0;
+        for (size_t bit : A) {
+            check(bit == expected[i], "Wrong iteration order");
+            ++i;
+        }
+        check(i == 4, "Wrong number of iterations");
+        check(*A.find(2) == 63, "BUG in find");
+        check(A.find(100001) == A.end(), "BUG in find");
+
+        B.set(63);
+        B.set(5);
+        check(!B.isSubsetOf(A), "BUG in isSubsetOf");
+        check(B.intersects(A), "BUG in intersects");
+        check(A.set(B), "Union did not change the bitvector");
+        check(!A.set(B), "Second union changed the bitvector");
+        check(B.isSubsetOf(A), "BUG in isSubsetOf");
+        check(A.size() == 5, "BUG in union");
+
+        check(A.unset(B), "Difference did not change the bitvector");
+        check(!A.intersects(B), "BUG in difference");
+        check(A.size() == 3, "BUG in difference");
+
+        check(A.unset(64), "Unset did not change the bitvector");
+        check(!A.unset(64), "Unset twice changed the bitvector");
+        check(A.wordsNum() == 2, "Empty word was not removed");
+
+        B.set(100000);
+        check(A.intersect(B), "Intersection did not change the bitvector");
+        check(A.size() == 1 && A.get(100000), "BUG in intersection");
+    }
+};
+
+class TestUnionFind : public Test
+{
+public:
+    TestUnionFind() : Test("test union-find")
+    {}
+
+    void test()
+    {
+        UnionFind<int> UF;
+        check(UF.find(1) == 1, "Not stored element is not its representative");
+        check(UF.empty(), "find() stored an element");
+
+        int r = UF.unite(1, 2);
+        check(r == 1 || r == 2, "Wrong representative");
+        check(UF.find(1) == UF.find(2), "United elements have different sets");
+        check(UF.find(3) == 3, "BUG in find");
+
+        UF.unite(3, 4);
+        UF.unite(5, 4);
+        check(UF.find(5) == UF.find(3), "BUG in unite");
+        check(UF.find(5) != UF.find(1), "BUG in unite");
+
+        r = UF.unite(2, 5);
+        for (int i = 1; i <= 5; ++i)
+            check(UF.find(i) == r, "Element has wrong representative");
+
+        check(UF.unite(1, 3) == r, "Uniting the same set changed it");
+        check(UF.isRepresentative(r), "BUG in isRepresentative");
+        check(UF.size() == 5, "BUG in size");
+
+        // merge keeps the representative of the second set
+        check(UF.merge(6, 7) == 7, "BUG in merge");
+        check(UF.merge(r, 7) == 7, "BUG in merge");
+        check(UF.find(1) == 7 && UF.find(6) == 7, "BUG in merge");
+    }
+};
+
+class TestPersistentHashMap : public Test
+{
+public:
+    TestPersistentHashMap() : Test("test persistent hash map")
+    {}
+
+    static int add(int a, int b) { return a + b; }
+
+    void test()
+    {
+        PersistentHashMap<int, int> A;
+        check(A.empty(), "empty map not empty");
+        check(A.find(1) == nullptr, "found something in empty map");
+
+        for (int i = 0; i < 1000; ++i)
+            A.set(i, i);
+        for (int i = 0; i < 1000; ++i)
+            check(A.find(i) && *A.find(i) == i, "BUG in set/find");
+        check(A.find(1000) == nullptr, "BUG in find");
+
+        int num = 0;
+        for (const auto& it : A) {
+            check(it.first == it.second, "Wrong entry");
+            ++num;
+        }
+        check(num == 1000, "Wrong number of iterations");
+
+        // the copy is not changed by changing the original
+        PersistentHashMap<int, int> B = A;
+        check(B.shares(A), "Copy does not share the trie");
+        A.set(5, 50);
+        check(*A.find(5) == 50 && *B.find(5) == 5, "Copy changed");
+        check(A.erase(6), "Erase did not remove the key");
+        check(!A.erase(6), "Erased the key twice");
+        check(A.find(6) == nullptr && *B.find(6) == 6, "BUG in erase");
+
+        // erasing everything gives the empty map again
+        PersistentHashMap<int, int> C = B;
+        for (int i = 0; i < 1000; ++i)
+            C.erase(i);
+        check(C.empty(), "Map not empty after erasing everything");
+
+        // merging maps that share the trie does not change anything
+        check(!B.merge(B, add), "Merging the same map changed it");
+
+        PersistentHashMap<int, int> D;
+        D.set(5, 1);
+        D.set(2000, 1);
+        check(B.merge(D, add), "Merge did not change the map");
+        check(*B.find(5) == 6, "Values not merged");
+        check(*B.find(2000) == 1, "Value not added");
+        check(*B.find(7) == 7, "Wrong value after merge");
+
+        C.merge(D, add);
+        check(C.shares(D), "Merge to empty map does not share the trie");
+    }
+};
+
+class TestArena : public Test
+{
+public:
+    TestArena() : Test("test arena")
+    {}
+
+    struct Counted {
+        int& alive;
+        uint64_t value;
+
+        Counted(int& a, uint64_t v) : alive(a), value(v) { ++alive; }
+        ~Counted() { --alive; }
+    };
+
+    void test()
+    {
+        int alive = 0;
+        {
+            Arena A;
+            std::vector<Counted *> objs;
+            for (int i = 0; i < 10000; ++i)
+                objs.push_back(A.create<Counted>(alive, i));
+
+            check(alive == 10000, "Objects not constructed");
+            check(A.getSlabsNum() > 1, "Objects do not take more slabs");
+
+            bool ok = true;
+            for (int i = 0; i < 10000; ++i) {
+                ok &= objs[i]->value == static_cast<uint64_t>(i);
+                ok &= reinterpret_cast<uintptr_t>(objs[i]) % alignof(Counted) == 0;
+            }
+            check(ok, "Objects overwritten or not aligned");
+
+            // an object bigger than the slab
+            struct Big { char data[100000]; };
+            Big *big = A.create<Big>();
+            big->data[99999] = 1;
+
+            A.clear();
+            check(alive == 0, "Objects not destroyed by clear()");
+
+            A.create<Counted>(alive, 1);
+        }
+
+        check(alive == 0, "Objects not destroyed with the arena");
+    }
+};
+
+class TestThreadPool : public Test
+{
+public:
+    TestThreadPool() : Test("test thread pool")
+    {}
+
+    void test()
+    {
+        ThreadPool P(4);
+        check(P.size() == 4, "Wrong number of threads");
+
+        // the same threads run many jobs
+        std::vector<unsigned> sums(P.size(), 0);
+        for (unsigned job = 1; job <= 1000; ++job)
+            P.run([&](unsigned id) { sums[id] += job; });
+
+        bool ok = true;
+        for (unsigned sum : sums)
+            ok &= sum == 1000 * 1001 / 2;
+        check(ok, "A thread missed a job");
+
+        ThreadPool one;
+        unsigned calls = 0;
+        one.run([&](unsigned id) { calls += id + 1; });
+        check(calls == 1, "One thread pool does not run in the caller");
+    }
+};
+
 }; // namespace tests
 }; // namespace dg
 
@@ -110,6 +340,11 @@ int main()
     Runner.add(new TestLIFO());
     Runner.add(new TestFIFO());
     Runner.add(new TestPrioritySet());
+    Runner.add(new TestSparseBitvector());
+    Runner.add(new TestUnionFind());
+    Runner.add(new TestPersistentHashMap());
+    Runner.add(new TestArena());
+    Runner.add(new TestThreadPool());
 
     return Runner();
 }
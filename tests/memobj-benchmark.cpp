@@ -0,0 +1,104 @@
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdlib>
+
+#include "analysis/PointsTo/Pointer.h"
+#include "analysis/PointsTo/PointerSubgraph.h"
+#include "../tools/TimeMeasure.h"
+
+using namespace dg::analysis;
+using namespace dg::analysis::pta;
+
+typedef std::map<Offset, PointsToSetT> StdMapT;
+typedef OffsetMap<PointsToSetT> FlatMapT;
+
+// find the sets that a load from the offset reads like the points-to
+// analysis does it: the set at the offset and the set at UNKNOWN_OFFSET.
+// Return the number of pointers in these sets
+static size_t load(const StdMapT& M, const Offset& off)
+{
+    size_t num = 0;
+    auto it = M.find(off);
+    if (it != M.end())
+        num += it->second.size();
+
+    it = M.find(UNKNOWN_OFFSET);
+    if (it != M.end())
+        num += it->second.size();
+
+    return num;
+}
+
+static size_t load(const FlatMapT& M, const Offset& off)
+{
+    size_t num = 0;
+    auto sets = M.getWithUnknown(off);
+    if (sets.first)
+        num += sets.first->size();
+    if (sets.second)
+        num += sets.second->size();
+
+    return num;
+}
+
+// create objects with 'fields' pointer fields, store few pointers
+// into every field (in random order) and then load
+// from random fields of the objects
+template <typename MapT>
+size_t run(std::vector<PSNode *>& targets, int fields, int loads)
+{
+    std::vector<MapT> objects(10);
+
+    srand(fields);
+    for (MapT& M : objects) {
+        for (int i = 0; i < fields * 3; ++i)
+            M[(rand() % fields) * 8].insert(
+                Pointer(targets[rand() % targets.size()], 0));
+
+        M[UNKNOWN_OFFSET].insert(Pointer(targets[0], 0));
+    }
+
+    size_t total = 0;
+    // just so that the compiler won't optimize it away
+    for (int i = 0; i < loads; ++i)
+        total += load(objects[i % objects.size()], (rand() % fields) * 8);
+
+    return total;
+}
+
+template <typename MapT>
+void test(const char *name, std::vector<PSNode *>& targets,
+          int fields, int loads)
+{
+    dg::debug::TimeMeasure tm;
+    std::string msg = "[";
+    msg += name;
+    msg += "] ";
+    msg += std::to_string(loads);
+    msg += " loads from objects with ";
+    msg += std::to_string(fields);
+    msg += " fields -- ";
+
+    tm.start();
+    size_t total = run<MapT>(targets, fields, loads);
+    tm.stop();
+    tm.report(msg.c_str());
+    printf("    (%lu pointers in the loaded sets total)\n", total);
+}
+
+int main()
+{
+    std::vector<PSNode *> targets;
+    for (int i = 0; i < 200; ++i)
+        targets.push_back(new PSNode(ALLOC));
+
+    int fields[] = {1, 10, 100, 1000};
+    for (int f : fields) {
+        test<StdMapT>("std::map", targets, f, 10000000);
+        test<FlatMapT>("sorted vector", targets, f, 10000000);
+    }
+
+    for (PSNode *n : targets)
+        delete n;
+}
@@ -0,0 +1,99 @@
+#include <vector>
+#include <string>
+#include <thread>
+#include <cstdlib>
+
+#include "analysis/PointsTo/PointerSubgraph.h"
+#include "analysis/PointsTo/PointsToFlowInsensitive.h"
+#include "../tools/TimeMeasure.h"
+
+using namespace dg::analysis;
+using namespace dg::analysis::pta;
+
+// create 'num' objects, pointers to the objects are stored to random
+// objects and loaded and copied from them, so that the points-to sets
+// grow in many rounds
+static std::vector<PSNode *> build(PointerSubgraph& PS, unsigned num)
+{
+    std::vector<PSNode *> nodes;
+    for (unsigned i = 0; i < num; ++i)
+        nodes.push_back(PS.createNode(ALLOC));
+
+    srand(num);
+    for (unsigned i = 0; i < num; ++i) {
+        PSNode *O = nodes[i];
+        PSNode *G = PS.createNode(GEP, O, (uint64_t) 8);
+        PSNode *S1 = PS.createNode(STORE, nodes[rand() % num], O);
+        PSNode *S2 = PS.createNode(STORE, nodes[(i + 1) % num], G);
+        PSNode *L1 = PS.createNode(LOAD, O);
+        PSNode *L2 = PS.createNode(LOAD, L1);
+        PSNode *S3 = PS.createNode(STORE, L1, L2);
+        PSNode *M = PS.createNode(MEMCPY, O, nodes[rand() % num],
+                                  (uint64_t) 0, (uint64_t) 16);
+        nodes.insert(nodes.end(), {G, S1, S2, L1, L2, S3, M});
+    }
+
+    // the nodes are in a loop, as if in a loop of the program,
+    // so that the loads see the stores that go after them
+    for (unsigned i = 0; i + 1 < nodes.size(); ++i)
+        nodes[i]->addSuccessor(nodes[i + 1]);
+    nodes.back()->addSuccessor(nodes[num]);
+
+    PS.setRoot(nodes[0]);
+    return nodes;
+}
+
+static size_t run(unsigned objects, unsigned threads)
+{
+    PointerSubgraph PS;
+    std::vector<PSNode *> nodes = build(PS, objects);
+
+    PointsToFlowInsensitive PTA(&PS);
+    PTA.setThreadsNum(threads);
+
+    dg::debug::TimeMeasure tm;
+    std::string msg = std::to_string(objects) + " objects, "
+                      + std::to_string(threads) + " threads -- ";
+
+    tm.start();
+    PTA.run();
+    tm.stop();
+    tm.report(msg.c_str());
+
+    size_t total = 0;
+    for (PSNode *n : nodes)
+        total += n->pointsTo.size();
+
+    printf("    (%lu pointers, %lu nodes processed)\n",
+           total, PTA.getProcessedNodesNum());
+#ifdef ENABLE_SHARED_PTSETS
+    printf("    (%lu interned sets)\n", PointsToSetT::getInternedSetsNum());
+#endif
+    return total;
+}
+
+// parallel-benchmark [max_threads [objects]]
+int main(int argc, char *argv[])
+{
+    unsigned max_threads = std::thread::hardware_concurrency();
+    if (argc > 1)
+        max_threads = atoi(argv[1]);
+    if (max_threads == 0)
+        max_threads = 1;
+
+    std::vector<unsigned> objects = {50, 100};
+    if (argc > 2)
+        objects = {static_cast<unsigned>(atoi(argv[2]))};
+
+    for (unsigned o : objects) {
+        size_t seq = run(o, 1);
+        for (unsigned t = 2; t <= max_threads; t *= 2) {
+            if (run(o, t) != seq) {
+                printf("Different results with %u threads\n", t);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 
 #include "test-runner.h"
 #include "test-dg.h"
@@ -9,6 +10,9 @@
 #include "analysis/PointsTo/PointerSubgraph.h"
 #include "analysis/PointsTo/PointsToFlowInsensitive.h"
 #include "analysis/PointsTo/PointsToFlowSensitive.h"
+#include "analysis/PointsTo/PointsToFlowSensitiveSparse.h"
+#include "analysis/PointsTo/PointsToDemandDriven.h"
+#include "analysis/PointsTo/PointsToSteensgaard.h"
 
 namespace dg {
 namespace tests {
@@ -66,6 +70,28 @@ public:
         check(L.doesPointsTo(&A), "L do not points to A");
     }
 
+    // the same as store_load, but the nodes are owned by the subgraph
+    void store_load_subgraph_nodes()
+    {
+        using namespace analysis;
+
+        PointerSubgraph PS;
+        PSNode *A = PS.createNode(pta::ALLOC);
+        PSNode *B = PS.createNode(pta::ALLOC);
+        PSNode *S = PS.createNode(pta::STORE, A, B);
+        PSNode *L = PS.createNode(pta::LOAD, B);
+
+        A->addSuccessor(B);
+        B->addSuccessor(S);
+        S->addSuccessor(L);
+
+        PS.setRoot(A);
+        PTStoT PA(&PS);
+        PA.run();
+
+        check(L->doesPointsTo(A), "L do not points to A");
+    }
+
     void store_load2()
     {
         using namespace analysis;
@@ -806,6 +832,210 @@ public:
         check(L2.doesPointsTo(pta::NULLPTR), "L2 does not point to NULL");
     }
 
+    void phi_loop()
+    {
+        using namespace analysis;
+
+        PSNode A(pta::ALLOC);
+        PSNode B(pta::ALLOC);
+        PSNode C(pta::ALLOC);
+        PSNode S1(pta::STORE, &A, &B);
+        PSNode S2(pta::STORE, &C, &A);
+        // the points-to set of P grows in every iteration
+        PSNode P(pta::PHI, &B, nullptr);
+        PSNode L1(pta::LOAD, &P);
+        PSNode CST(pta::CAST, &L1);
+        P.addOperand(&CST);
+        PSNode L2(pta::LOAD, &CST);
+        PSNode S3(pta::STORE, &L1, &B);
+
+        A.addSuccessor(&B);
+        B.addSuccessor(&C);
+        C.addSuccessor(&S1);
+        S1.addSuccessor(&S2);
+        S2.addSuccessor(&P);
+        P.addSuccessor(&L1);
+        L1.addSuccessor(&CST);
+        CST.addSuccessor(&L2);
+        L2.addSuccessor(&S3);
+        S3.addSuccessor(&P);
+
+        PointerSubgraph PS(&A);
+        PTStoT PA(&PS);
+        PA.run();
+
+        check(P.doesPointsTo(&A), "P does not point to A");
+        check(P.doesPointsTo(&B), "P does not point to B");
+        check(P.doesPointsTo(&C), "P does not point to C");
+        check(CST.doesPointsTo(&A), "CST does not point to A");
+        check(CST.doesPointsTo(&C), "CST does not point to C");
+        check(L2.doesPointsTo(&C), "L2 does not point to C");
+    }
+
+    void copy_cycle()
+    {
+        using namespace analysis;
+
+        PSNode A(pta::ALLOC);
+        PSNode B(pta::ALLOC);
+        PSNode S(pta::STORE, &A, &B);
+        // P -> C1 -> C2 -> P is a cycle of copy nodes
+        PSNode P(pta::PHI, &B, nullptr);
+        PSNode C1(pta::CAST, &P);
+        PSNode C2(pta::CAST, &C1);
+        P.addOperand(&C2);
+        // this adds new pointer to the cycle
+        PSNode L(pta::LOAD, &C2);
+        P.addOperand(&L);
+
+        A.addSuccessor(&B);
+        B.addSuccessor(&S);
+        S.addSuccessor(&P);
+        P.addSuccessor(&C1);
+        C1.addSuccessor(&C2);
+        C2.addSuccessor(&L);
+        L.addSuccessor(&P);
+
+        PointerSubgraph PS(&A);
+        PTStoT PA(&PS);
+        PA.run();
+
+        check(L.doesPointsTo(&A), "L does not point to A");
+        check(P.doesPointsTo(&A), "P does not point to A");
+        check(P.doesPointsTo(&B), "P does not point to B");
+        check(C1.doesPointsTo(&A), "C1 does not point to A");
+        check(C1.doesPointsTo(&B), "C1 does not point to B");
+        check(C2.doesPointsTo(&A), "C2 does not point to A");
+        check(C2.doesPointsTo(&B), "C2 does not point to B");
+        check(C2.pointsTo.size() == 2, "C2 points to wrong memory");
+    }
+
+    void equivalent_nodes()
+    {
+        using namespace analysis;
+
+        PSNode A(pta::ALLOC);
+        PSNode B(pta::ALLOC);
+        B.setSize(16);
+        PSNode C1(pta::CAST, &A);
+        PSNode C2(pta::CAST, &C1);
+        PSNode P(pta::PHI, &C2, &C1, nullptr);
+        PSNode G1(pta::GEP, &B, 8);
+        PSNode G2(pta::GEP, &B, 8);
+        PSNode S(pta::STORE, &P, &G1);
+        PSNode L(pta::LOAD, &G2);
+
+        A.addSuccessor(&B);
+        B.addSuccessor(&C1);
+        C1.addSuccessor(&C2);
+        C2.addSuccessor(&P);
+        P.addSuccessor(&G1);
+        G1.addSuccessor(&G2);
+        G2.addSuccessor(&S);
+        S.addSuccessor(&L);
+
+        PointerSubgraph PS(&A);
+        PTStoT PA(&PS);
+        PA.run();
+
+        check(C1.doesPointsTo(&A), "C1 does not point to A");
+        check(C2.doesPointsTo(&A), "C2 does not point to A");
+        check(P.doesPointsTo(&A), "P does not point to A");
+        check(P.pointsTo.size() == 1, "P points to wrong memory");
+        check(G1.doesPointsTo(&B, 8), "G1 does not point to B + 8");
+        check(G2.doesPointsTo(&B, 8), "G2 does not point to B + 8");
+        check(L.doesPointsTo(&A), "L does not point to A");
+    }
+
+    void store_load_unknown()
+    {
+        using namespace analysis;
+
+        for (int saturate = 0; saturate < 2; ++saturate) {
+            PSNode A(pta::ALLOC);
+            PSNode B(pta::ALLOC);
+            PSNode C(pta::ALLOC);
+            PSNode U(pta::CONSTANT, pta::UNKNOWN_MEMORY, UNKNOWN_OFFSET);
+            PSNode S1(pta::STORE, &A, &B);
+            // store via the pointer that may point anywhere
+            PSNode S2(pta::STORE, &C, &U);
+            PSNode L1(pta::LOAD, &B);
+            PSNode L2(pta::LOAD, &U);
+
+            A.addSuccessor(&B);
+            B.addSuccessor(&C);
+            C.addSuccessor(&S1);
+            S1.addSuccessor(&S2);
+            S2.addSuccessor(&L1);
+            L1.addSuccessor(&L2);
+
+            PointerSubgraph PS(&A);
+            PTStoT PA(&PS);
+            PA.setSaturateUnknown(saturate);
+            PA.run();
+
+            check(L1.doesPointsTo(&A), "L1 does not point to A");
+            if (saturate) {
+                check(L1.doesPointsTo(&C), "L1 does not point to C");
+                check(L2.isTop(), "L2 does not point anywhere");
+            } else {
+                // without the saturation, the store via unknown
+                // pointer writes only to the unknown memory
+                check(!L1.doesPointsTo(&C), "L1 points to C");
+                check(L2.doesPointsTo(&C), "L2 does not point to C");
+            }
+        }
+    }
+
+    void strided_gep()
+    {
+        using namespace analysis;
+
+        // B is an array of four structures { ptr a; ptr b; },
+        // store A to B[i].a and C to B[i].b
+        PSNode A(pta::ALLOC);
+        PSNode B(pta::ALLOC);
+        B.setSize(64);
+        PSNode C(pta::ALLOC);
+        PSNode GEP1(pta::GEP, &B, *Offset::getStrided(0, 16));
+        PSNode S1(pta::STORE, &A, &GEP1);
+        PSNode GEP2(pta::GEP, &B, *Offset::getStrided(8, 16));
+        PSNode S2(pta::STORE, &C, &GEP2);
+        // B[2].a, B[2].b and B[i + 1].a
+        PSNode GEP3(pta::GEP, &B, 32);
+        PSNode L1(pta::LOAD, &GEP3);
+        PSNode GEP4(pta::GEP, &B, 40);
+        PSNode L2(pta::LOAD, &GEP4);
+        PSNode GEP5(pta::GEP, &GEP1, 16);
+        PSNode L3(pta::LOAD, &GEP5);
+
+        A.addSuccessor(&B);
+        B.addSuccessor(&C);
+        C.addSuccessor(&GEP1);
+        GEP1.addSuccessor(&S1);
+        S1.addSuccessor(&GEP2);
+        GEP2.addSuccessor(&S2);
+        S2.addSuccessor(&GEP3);
+        GEP3.addSuccessor(&L1);
+        L1.addSuccessor(&GEP4);
+        GEP4.addSuccessor(&L2);
+        L2.addSuccessor(&GEP5);
+        GEP5.addSuccessor(&L3);
+
+        PointerSubgraph PS(&A);
+        PTStoT PA(&PS);
+        PA.run();
+
+        check(GEP5.doesPointsTo(&B, Offset::getStrided(0, 16)),
+              "GEP5 does not point to B + k*16");
+        check(L1.doesPointsTo(&A), "L1 does not point to A");
+        check(!L1.doesPointsTo(&C), "L1 points to C");
+        check(L2.doesPointsTo(&C), "L2 does not point to C");
+        check(!L2.doesPointsTo(&A), "L2 points to A");
+        check(L3.doesPointsTo(&A), "L3 does not point to A");
+        check(!L3.doesPointsTo(&C), "L3 points to C");
+    }
+
     void test()
     {
         store_load();
@@ -828,6 +1058,12 @@ public:
         memcpy_test2();
         memcpy_test3();
         memcpy_test4();
+        phi_loop();
+        copy_cycle();
+        equivalent_nodes();
+        store_load_subgraph_nodes();
+        store_load_unknown();
+        strided_gep();
     }
 };
 
@@ -849,6 +1085,236 @@ public:
           ("flow-sensitive points-to test") {}
 };
 
+class FlowSensitiveSparsePointsToTest
+    : public PointsToTest<analysis::pta::PointsToFlowSensitiveSparse>
+{
+public:
+    FlowSensitiveSparsePointsToTest()
+        : PointsToTest<analysis::pta::PointsToFlowSensitiveSparse>
+          ("sparse flow-sensitive points-to test") {}
+};
+
+// run the analysis with difference propagation
+template <typename PTStoT>
+class DiffPropagation : public PTStoT
+{
+public:
+    DiffPropagation(analysis::pta::PointerSubgraph *ps) : PTStoT(ps)
+    {
+        this->setDifferencePropagation(true);
+    }
+};
+
+class FlowInsensitiveDiffPointsToTest
+    : public PointsToTest<DiffPropagation<analysis::pta::PointsToFlowInsensitive> >
+{
+public:
+    FlowInsensitiveDiffPointsToTest()
+        : PointsToTest<DiffPropagation<analysis::pta::PointsToFlowInsensitive> >
+          ("flow-insensitive points-to test (difference propagation)") {}
+};
+
+class FlowSensitiveDiffPointsToTest
+    : public PointsToTest<DiffPropagation<analysis::pta::PointsToFlowSensitive> >
+{
+public:
+    FlowSensitiveDiffPointsToTest()
+        : PointsToTest<DiffPropagation<analysis::pta::PointsToFlowSensitive> >
+          ("flow-sensitive points-to test (difference propagation)") {}
+};
+
+// run the analysis with the SCC-topological scheduling
+template <typename PTStoT>
+class SCCScheduling : public PTStoT
+{
+public:
+    SCCScheduling(analysis::pta::PointerSubgraph *ps) : PTStoT(ps)
+    {
+        this->setSCCScheduling(true);
+    }
+};
+
+class FlowInsensitiveSCCPointsToTest
+    : public PointsToTest<SCCScheduling<analysis::pta::PointsToFlowInsensitive> >
+{
+public:
+    FlowInsensitiveSCCPointsToTest()
+        : PointsToTest<SCCScheduling<analysis::pta::PointsToFlowInsensitive> >
+          ("flow-insensitive points-to test (SCC scheduling)") {}
+};
+
+// run the analysis on the groups of nodes with different alias classes
+template <typename PTStoT>
+class AliasClasses : public PTStoT
+{
+public:
+    AliasClasses(analysis::pta::PointerSubgraph *ps) : PTStoT(ps)
+    {
+        this->setAliasClassesScheduling(true);
+    }
+};
+
+class FlowInsensitiveAliasClassesPointsToTest
+    : public PointsToTest<AliasClasses<analysis::pta::PointsToFlowInsensitive> >
+{
+public:
+    FlowInsensitiveAliasClassesPointsToTest()
+        : PointsToTest<AliasClasses<analysis::pta::PointsToFlowInsensitive> >
+          ("flow-insensitive points-to test (alias classes)") {}
+};
+
+class FlowSensitiveSCCPointsToTest
+    : public PointsToTest<SCCScheduling<analysis::pta::PointsToFlowSensitive> >
+{
+public:
+    FlowSensitiveSCCPointsToTest()
+        : PointsToTest<SCCScheduling<analysis::pta::PointsToFlowSensitive> >
+          ("flow-sensitive points-to test (SCC scheduling)") {}
+};
+
+// run the analysis with collapsing the cycles of copy nodes
+template <typename PTStoT>
+class CycleDetection : public PTStoT
+{
+public:
+    CycleDetection(analysis::pta::PointerSubgraph *ps) : PTStoT(ps)
+    {
+        this->setCycleDetection(true);
+    }
+};
+
+class FlowInsensitiveCyclesPointsToTest
+    : public PointsToTest<CycleDetection<analysis::pta::PointsToFlowInsensitive> >
+{
+public:
+    FlowInsensitiveCyclesPointsToTest()
+        : PointsToTest<CycleDetection<analysis::pta::PointsToFlowInsensitive> >
+          ("flow-insensitive points-to test (cycle detection)") {}
+};
+
+class FlowSensitiveCyclesPointsToTest
+    : public PointsToTest<CycleDetection<analysis::pta::PointsToFlowSensitive> >
+{
+public:
+    FlowSensitiveCyclesPointsToTest()
+        : PointsToTest<CycleDetection<analysis::pta::PointsToFlowSensitive> >
+          ("flow-sensitive points-to test (cycle detection)") {}
+};
+
+// run the analysis with merging equivalent nodes beforehand
+template <typename PTStoT>
+class MergeEquivalent : public PTStoT
+{
+public:
+    MergeEquivalent(analysis::pta::PointerSubgraph *ps) : PTStoT(ps)
+    {
+        this->setMergeEquivalent(true);
+    }
+};
+
+class FlowInsensitiveEquivPointsToTest
+    : public PointsToTest<MergeEquivalent<analysis::pta::PointsToFlowInsensitive> >
+{
+public:
+    FlowInsensitiveEquivPointsToTest()
+        : PointsToTest<MergeEquivalent<analysis::pta::PointsToFlowInsensitive> >
+          ("flow-insensitive points-to test (merging equivalent nodes)") {}
+};
+
+class FlowSensitiveEquivPointsToTest
+    : public PointsToTest<MergeEquivalent<analysis::pta::PointsToFlowSensitive> >
+{
+public:
+    FlowSensitiveEquivPointsToTest()
+        : PointsToTest<MergeEquivalent<analysis::pta::PointsToFlowSensitive> >
+          ("flow-sensitive points-to test (merging equivalent nodes)") {}
+};
+
+// run the analysis in more threads
+template <typename PTStoT>
+class ParallelSolving : public PTStoT
+{
+public:
+    ParallelSolving(analysis::pta::PointerSubgraph *ps) : PTStoT(ps)
+    {
+        this->setThreadsNum(4);
+    }
+};
+
+class FlowInsensitiveParallelPointsToTest
+    : public PointsToTest<ParallelSolving<analysis::pta::PointsToFlowInsensitive> >
+{
+public:
+    FlowInsensitiveParallelPointsToTest()
+        : PointsToTest<ParallelSolving<analysis::pta::PointsToFlowInsensitive> >
+          ("flow-insensitive points-to test (parallel solving)") {}
+};
+
+class FlowInsensitiveParallelEquivPointsToTest
+    : public PointsToTest<ParallelSolving<MergeEquivalent<analysis::pta::PointsToFlowInsensitive> > >
+{
+public:
+    FlowInsensitiveParallelEquivPointsToTest()
+        : PointsToTest<ParallelSolving<MergeEquivalent<analysis::pta::PointsToFlowInsensitive> > >
+          ("flow-insensitive points-to test (parallel solving, merging equivalent nodes)") {}
+};
+
+// run the analysis on the frozen (dense-id) subgraph
+template <typename PTStoT>
+class FrozenSubgraph : public PTStoT
+{
+public:
+    FrozenSubgraph(analysis::pta::PointerSubgraph *ps) : PTStoT(ps)
+    {
+        ps->freeze();
+    }
+};
+
+class FlowInsensitiveFrozenPointsToTest
+    : public PointsToTest<FrozenSubgraph<analysis::pta::PointsToFlowInsensitive> >
+{
+public:
+    FlowInsensitiveFrozenPointsToTest()
+        : PointsToTest<FrozenSubgraph<analysis::pta::PointsToFlowInsensitive> >
+          ("flow-insensitive points-to test (frozen subgraph)") {}
+};
+
+class FlowSensitiveFrozenPointsToTest
+    : public PointsToTest<FrozenSubgraph<analysis::pta::PointsToFlowSensitive> >
+{
+public:
+    FlowSensitiveFrozenPointsToTest()
+        : PointsToTest<FrozenSubgraph<analysis::pta::PointsToFlowSensitive> >
+          ("flow-sensitive points-to test (frozen subgraph)") {}
+};
+
+// ask the demand-driven analysis about every node,
+// the last nodes first so that the queries use
+// the results of the previous queries
+class DemandAll : public analysis::pta::PointsToDemandDriven
+{
+public:
+    DemandAll(analysis::pta::PointerSubgraph *ps)
+    : analysis::pta::PointsToDemandDriven(ps) {}
+
+    virtual void run()
+    {
+        analysis::pta::PointsToDemandDriven::run();
+
+        analysis::pta::PointerSubgraph *PS = getPS();
+        std::vector<PSNode *> nodes = PS->getNodes(PS->getRoot());
+        for (auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+            resolve(*it);
+    }
+};
+
+class DemandDrivenPointsToTest : public PointsToTest<DemandAll>
+{
+public:
+    DemandDrivenPointsToTest()
+        : PointsToTest<DemandAll>("demand-driven points-to test") {}
+};
+
 class PSNodeTest : public Test
 {
 
@@ -869,11 +1335,806 @@ public:
         N2.addPointsTo(&N1, UNKNOWN_OFFSET);
         check(N2.pointsTo.size() == 1);
         check(N2.addPointsTo(&N1, 3) == false);
+
+        // the same when adding whole sets
+        PSNode N3(ALLOC);
+        PSNode N4(LOAD, &N1);
+        N4.addPointsTo(&N1, 1);
+        N4.addPointsTo(&N3, 2);
+
+        PointsToSetT S;
+        S.insert(Pointer(&N1, UNKNOWN_OFFSET));
+        S.insert(Pointer(&N3, 4));
+        check(N4.addPointsTo(S));
+        check(N4.pointsTo.size() == 3);
+        check(!N4.doesPointsTo(&N1, 1));
+
+        S.clear();
+        S.insert(Pointer(&N1, 8));
+        check(!N4.addPointsTo(S));
+        check(N4.pointsTo.size() == 3);
+    }
+
+    void strided_offset1()
+    {
+        using namespace dg::analysis;
+
+        Offset off = Offset::getStrided(24, 16);
+        check(off.isStrided() && !off.isConcrete());
+        check(off.getBase() == 8 && off.getStride() == 16);
+        check(Offset::getStrided(-8, 16) == off);
+        check(off + 32 == off);
+        check(off.mayAlias(40) && !off.mayAlias(32));
+        check(off.mayAlias(Offset::getStrided(0, 24)));
+        check(!off.mayAlias(Offset::getStrided(4, 24)));
+        check(off + Offset::getStrided(4, 24) == Offset::getStrided(4, 8));
+        check(off.mayAlias(UNKNOWN_OFFSET));
+
+        // stride 1 is any offset, stride 0 is the concrete offset
+        check(Offset::getStrided(3, 1).isUnknown());
+        check(Offset::getStrided(5, 0) == 5);
+        // negative concrete offsets are not strided
+        check(Offset(static_cast<uint64_t>(-8)).isConcrete());
+        check(!Offset(UNKNOWN_OFFSET).isStrided());
+
+        // the concrete offsets that collide with the encoding
+        // of strided offsets are unknown
+        uint64_t low = static_cast<uint64_t>(-(1LL << 32));
+        check(Offset::getConcrete(low).isConcrete());
+        check(Offset::getConcrete(low * 2).isUnknown());
+        check((Offset(low) + Offset(low)).isUnknown());
+        check(Offset::getConcrete(1ULL << 63).isUnknown());
+        check(Offset::getStrided(static_cast<int64_t>(low * 2), 0).isUnknown());
+
+        // the strided offsets are not in any range
+        check(!off.inRange(0, 1ULL << 63));
+        check(!off.inRange(0, UNKNOWN_OFFSET));
+        check(Offset(8).inRange(0, 16));
+    }
+
+    void offset_map1()
+    {
+        using namespace dg::analysis;
+        using namespace dg::analysis::pta;
+
+        PSNode A(ALLOC);
+        PointsToMapT M;
+        M[UNKNOWN_OFFSET].insert(Pointer(&A, 1));
+        M[16].insert(Pointer(&A, 2));
+        M[0].insert(Pointer(&A, 3));
+        M[16].insert(Pointer(&A, 4));
+
+        check(M.size() == 3);
+        check(M.begin()->first == 0);
+        check(M.getUnknown() && M.getUnknown()->size() == 1);
+
+        auto sets = M.getWithUnknown(16);
+        check(sets.first && sets.first->size() == 2);
+        check(sets.second == M.getUnknown());
+        check(M.getWithUnknown(8).first == nullptr);
+
+        check(!M.hasStrided());
+        M[Offset::getStrided(4, 8)].insert(Pointer(&A, 5));
+        check(M.hasStrided());
+        check(M.getUnknown() && M.getUnknown()->size() == 1);
+    }
+
+    void unknown_memory1()
+    {
+        using namespace dg::analysis::pta;
+        PSNode N1(ALLOC);
+        PSNode N2(ALLOC);
+        PSNode F(FUNCTION);
+        PSNode N3(LOAD, &N1);
+
+        N3.addPointsTo(&N1, 0);
+        N3.addPointsTo(&N2, 8);
+        N3.addPointsTo(&F, 0);
+        check(!N3.isTop());
+        check(N3.makeTop());
+        check(N3.isTop());
+        // the pointers to functions stay in the top set
+        check(N3.pointsTo.size() == 2);
+        check(N3.doesPointsTo(&F, 0));
+        check(!N3.makeTop());
+
+        MemoryObject mo(&N1);
+        check(mo.addPointsTo(0, Pointer(&N1, 0)));
+        check(mo.addPointsTo(8, Pointer(&F, 0)));
+        check(!mo.isTop());
+        check(mo.makeTop());
+        check(mo.isTop());
+        check(mo.pointsTo.size() == 1);
+        check(mo.pointsTo.getUnknown()->size() == 2);
+        check(!mo.makeTop());
+    }
+
+    // records the calls via function pointers
+    class FuncptrCallsPTA : public analysis::pta::PointsToFlowInsensitive
+    {
+    public:
+        std::set<std::pair<analysis::pta::PSNode *,
+                           analysis::pta::PSNode *> > calls;
+
+        FuncptrCallsPTA(analysis::pta::PointerSubgraph *ps)
+        : analysis::pta::PointsToFlowInsensitive(ps) {}
+
+        bool functionPointerCall(analysis::pta::PSNode *where,
+                                 analysis::pta::PSNode *what) override
+        {
+            calls.emplace(where, what);
+            return false;
+        }
+    };
+
+    // the pointer to a function joined with the unknown pointer
+    // still calls the function, in whatever order the pointers come
+    void saturation1()
+    {
+        using namespace dg::analysis::pta;
+        for (int order = 0; order < 2; ++order) {
+            PSNode A(ALLOC);
+            PSNode F(FUNCTION);
+            PSNode U(CONSTANT, UNKNOWN_MEMORY, UNKNOWN_OFFSET);
+            PSNode C(CAST, &F);
+            PSNode P(PHI, order ? &C : &U, order ? &U : &C, nullptr);
+            PSNode CF(CALL_FUNCPTR, &P);
+            // store the function to A and load it via the top pointer
+            PSNode S(STORE, &C, &A);
+            PSNode L(LOAD, &P);
+            PSNode CL(CALL_FUNCPTR, &L);
+
+            A.addSuccessor(&F);
+            F.addSuccessor(&C);
+            C.addSuccessor(&P);
+            P.addSuccessor(&CF);
+            CF.addSuccessor(&S);
+            S.addSuccessor(&L);
+            L.addSuccessor(&CL);
+
+            PointerSubgraph PS(&A);
+            FuncptrCallsPTA PA(&PS);
+            PA.setSaturateUnknown(true);
+            PA.run();
+
+            check(PA.isTop(&P));
+            check(P.doesPointsTo(&F, 0));
+            check(CF.doesPointsTo(&F, 0));
+            check(PA.calls.count(std::make_pair(&CF, &F)) == 1);
+            check(PA.isTop(&L));
+            check(L.doesPointsTo(&F, 0));
+            check(PA.calls.count(std::make_pair(&CL, &F)) == 1);
+        }
+    }
+
+    void sparse_set1()
+    {
+        using namespace dg::analysis::pta;
+        PSNode N1(ALLOC);
+        PSNode N2(ALLOC);
+        SparseBitvectorPointsToSet<Pointer> S1, S2;
+
+        check(S1.insert(Pointer(&N1, 0)).second);
+        check(S1.insert(Pointer(&N2, 8)).second);
+        check(!S1.insert(Pointer(&N1, 0)).second);
+        check(S1.size() == 2);
+        check(S1.count(Pointer(&N2, 8)) == 1);
+        check(S1.count(Pointer(&N2, 16)) == 0);
+        check(S1.find(Pointer(&N1, 0))->target == &N1);
+
+        S2.insert(Pointer(&N2, UNKNOWN_OFFSET));
+        check(S2.add(S1));
+        check(!S2.add(S1));
+        check(S1.isSubsetOf(S2));
+        check(S2.size() == 3);
+
+        check(S2.erase(Pointer(&N1, 0)) == 1);
+        check(!S1.isSubsetOf(S2));
+
+        size_t num = 0;
+        for (const Pointer& ptr : S2) {
+            check(ptr.target == &N2);
+            ++num;
+        }
+        check(num == 2);
+    }
+
+    void shared_set1()
+    {
+        using namespace dg::analysis::pta;
+        PSNode N1(ALLOC);
+        PSNode N2(ALLOC);
+        SharedPointsToSet<Pointer> S1, S2, S3;
+
+        check(S1.insert(Pointer(&N1, 0)).second);
+        check(S1.insert(Pointer(&N2, 8)).second);
+        check(!S1.insert(Pointer(&N1, 0)).second);
+        check(S1.size() == 2);
+
+        // equal sets are the same set
+        check(S2.insert(Pointer(&N2, 8)).second);
+        check(S2.insert(Pointer(&N1, 0)).second);
+        check(S1 == S2);
+        check(&*S1.begin() == &*S2.begin());
+
+        // copy is shared and modifying it does not change the original
+        S3 = S1;
+        check(S3 == S1);
+        check(S3.insert(Pointer(&N2, UNKNOWN_OFFSET)).second);
+        check(S3 != S1);
+        check(S1.size() == 2);
+        check(S3.size() == 3);
+
+        // union
+        check(!S3.add(S1));
+        check(S1.add(S3));
+        check(S1 == S3);
+        check(S2.add(S3));
+        check(S2 == S3);
+
+        check(S1.erase(Pointer(&N1, 0)) == 1);
+        check(S1.erase(Pointer(&N1, 0)) == 0);
+        check(S1.count(Pointer(&N1, 0)) == 0);
+        check(S3.count(Pointer(&N1, 0)) == 1);
+
+        S1.clear();
+        check(S1.empty());
+        check(S1.begin() == S1.end());
+
+        // the result of a union may be a set that is referenced
+        // only by the memo table and the memo table is flushed when
+        // it has MAX_MEMOIZED_UNIONS (1 << 16) unions. Every iteration
+        // adds two unions, so some flush comes just before X.add(Y)
+        for (uint64_t i = 0; i < (1 << 17); ++i) {
+            // {N1 + 2i, N2 + 2i} is referenced only by the key
+            // of the memoized union with U
+            SharedPointsToSet<Pointer> T, U, X, Y;
+            T.insert(Pointer(&N1, 2 * i));
+            T.insert(Pointer(&N2, 2 * i));
+            U.insert(Pointer(&N2, 2 * i + 1));
+            T.add(U);
+            T.clear();
+
+            X.insert(Pointer(&N1, 2 * i));
+            Y.insert(Pointer(&N2, 2 * i));
+            check(X.add(Y));
+            check(X.size() == 2);
+        }
+    }
+
+    void frozen_subgraph1()
+    {
+        using namespace dg::analysis::pta;
+        PSNode A(ALLOC);
+        PSNode B(ALLOC);
+        PSNode S(STORE, &A, &B);
+        PSNode L(LOAD, &B);
+        PSNode G(GEP, &L, 8);
+        PSNode C(ALLOC);
+
+        A.addSuccessor(&B);
+        B.addSuccessor(&S);
+        B.addSuccessor(&L);
+        S.addSuccessor(&G);
+        L.addSuccessor(&G);
+        G.addSuccessor(&B);
+
+        PointerSubgraph PS(&A);
+        std::vector<PSNode *> nodes = PS.getNodes(&A);
+
+        PS.freeze();
+        check(PS.isFrozen());
+        check(PS.getNodes(&A) == nodes);
+
+        std::vector<PSNode *> start = {&L, &S, &L};
+        std::vector<PSNode *> from_frozen = PS.getNodes(nullptr, &start);
+        PS.unfreeze();
+        check(PS.getNodes(nullptr, &start) == from_frozen);
+        PS.freeze();
+
+        FrozenPointerSubgraph *F = PS.getFrozen();
+        check(F->getNodesNum() == 5);
+        check(F->getNode(0) == &A);
+
+        uint32_t id = 0, succ_id = 0;
+        check(F->getId(&G, id));
+        check(F->getSuccessors(id).size() == 1);
+        check(F->getId(&B, succ_id));
+        check(*F->getSuccessors(id).begin() == succ_id);
+        check(!F->getId(&C, id));
+
+        // changing the subgraph makes the frozen form stale
+        G.addSuccessor(&C);
+        PS.structureChanged();
+        check(PS.getNodes(&A).size() == 6);
+        check(PS.getFrozen()->getId(&C, id));
+
+        // the node that is not in the frozen subgraph
+        PSNode D(ALLOC);
+        check(PS.getNodes(&D).size() == 1);
+    }
+
+    void demand_driven1()
+    {
+        using namespace dg::analysis::pta;
+        PSNode A(ALLOC);
+        PSNode B(ALLOC);
+        PSNode C(ALLOC);
+        PSNode D(ALLOC);
+        PSNode S1(STORE, &A, &B);
+        PSNode S2(STORE, &C, &D);
+        PSNode L1(LOAD, &B);
+        PSNode L2(LOAD, &D);
+        PSNode G(GEP, &L1, 0);
+
+        A.addSuccessor(&B);
+        B.addSuccessor(&C);
+        C.addSuccessor(&D);
+        D.addSuccessor(&S1);
+        S1.addSuccessor(&S2);
+        S2.addSuccessor(&L1);
+        L1.addSuccessor(&L2);
+        L2.addSuccessor(&G);
+
+        PointerSubgraph PS(&A);
+        PointsToDemandDriven PA(&PS);
+        PA.run();
+        check(L1.pointsTo.empty());
+
+        PA.resolve(&G);
+        check(G.doesPointsTo(&A));
+        check(L1.doesPointsTo(&A));
+        // the other load and store are not relevant, not even
+        // the pointer operand of the store (G, L1, B, S1, A)
+        check(L2.pointsTo.empty());
+        check(PA.getRelevantNodesNum() == 5);
+
+        // the second query uses the results of the first one
+        size_t processed = PA.getDemandProcessedNodesNum();
+        PA.resolve(&L1);
+        check(PA.getDemandProcessedNodesNum() == processed);
+
+        PA.resolve(&L2);
+        check(L2.doesPointsTo(&C));
+        check(!PA.isExhaustive());
+
+        // too small budget falls back to the exhaustive analysis
+        PSNode E(ALLOC);
+        PSNode F(ALLOC);
+        PSNode S3(STORE, &E, &F);
+        PSNode L3(LOAD, &F);
+        PSNode L4(LOAD, &F);
+        E.addSuccessor(&F);
+        F.addSuccessor(&S3);
+        S3.addSuccessor(&L3);
+        L3.addSuccessor(&L4);
+
+        PointerSubgraph PS2(&E);
+        PointsToDemandDriven PA2(&PS2);
+        PA2.setBudget(1);
+        PA2.run();
+        PA2.resolve(&L3);
+        check(PA2.isExhaustive());
+        check(PA2.getFallbacksNum() == 1);
+        check(L3.doesPointsTo(&E));
+        check(L4.doesPointsTo(&E));
+    }
+
+    void steensgaard1()
+    {
+        using namespace dg::analysis::pta;
+        PSNode A(ALLOC);
+        PSNode B(ALLOC);
+        PSNode C(ALLOC);
+        PSNode D(ALLOC);
+        PSNode E(ALLOC);
+        PSNode S1(STORE, &A, &C);
+        PSNode S2(STORE, &B, &C);
+        PSNode L(LOAD, &C);
+        PSNode P(PHI, &D, &L, nullptr);
+        PSNode G(GEP, &E, 8);
+
+        A.addSuccessor(&B);
+        B.addSuccessor(&C);
+        C.addSuccessor(&D);
+        D.addSuccessor(&E);
+        E.addSuccessor(&S1);
+        S1.addSuccessor(&S2);
+        S2.addSuccessor(&L);
+        L.addSuccessor(&P);
+        P.addSuccessor(&G);
+
+        PointerSubgraph PS(&A);
+        PointsToSteensgaard PA(&PS);
+        PA.run();
+
+        // field-insensitive
+        check(L.doesPointsTo(&A, UNKNOWN_OFFSET));
+        check(L.doesPointsTo(&B, UNKNOWN_OFFSET));
+        check(G.doesPointsTo(&E, UNKNOWN_OFFSET));
+        check(G.pointsTo.size() == 1);
+        // PHI unifies D with the memory stored in C
+        check(P.doesPointsTo(&D, UNKNOWN_OFFSET));
+        check(P.doesPointsTo(&A, UNKNOWN_OFFSET));
+        check(P.pointsTo.size() == 3);
+
+        // A, B, D are in one class, C and E have a class each
+        check(PA.getAliasClass(&A) == PA.getAliasClass(&D));
+        check(PA.getAliasClass(&A) != PA.getAliasClass(&C));
+        check(PA.getAliasClass(&C) != PA.getAliasClass(&E));
+        check(PA.getAliasClassesNum() == 3);
+
+        std::vector<std::vector<PSNode *> > classes;
+        PA.getAliasClasses(classes);
+        check(classes.size() == 3);
+
+        // the memory of C
+        std::vector<MemoryObject *> mos;
+        PA.getMemoryObjects(&L, Pointer(&C, 0), mos);
+        check(mos.size() == 1);
+        check(mos[0]->pointsTo[UNKNOWN_OFFSET].size() == 3);
+
+        // with the saturation, the pointer stored via unknown pointer
+        // may be loaded from any memory (as in the flow-insensitive analysis)
+        PSNode X(ALLOC);
+        PSNode Y(ALLOC);
+        PSNode U(CONSTANT, UNKNOWN_MEMORY, UNKNOWN_OFFSET);
+        PSNode S3(STORE, &X, &U);
+        PSNode L2(LOAD, &Y);
+        X.addSuccessor(&Y);
+        Y.addSuccessor(&S3);
+        S3.addSuccessor(&L2);
+
+        PointerSubgraph PS2(&X);
+        PointsToSteensgaard PA2(&PS2);
+        PA2.setSaturateUnknown(true);
+        PA2.run();
+        check(L2.doesPointsTo(&X, UNKNOWN_OFFSET));
+        check(PA2.getAliasClass(&X) == PA2.getAliasClass(&L2));
+    }
+
+    // do the nodes at the same positions in the two copies
+    // of a graph have the same points-to sets?
+    static bool samePointsTo(const std::vector<analysis::pta::PSNode *>& N1,
+                             const std::vector<analysis::pta::PSNode *>& N2)
+    {
+        using namespace dg::analysis::pta;
+        if (N1.size() != N2.size())
+            return false;
+
+        for (unsigned i = 0; i < N1.size(); ++i) {
+            if (N1[i]->pointsTo.size() != N2[i]->pointsTo.size())
+                return false;
+
+            for (const Pointer& ptr : N1[i]->pointsTo) {
+                unsigned t = std::find(N1.begin(), N1.end(), ptr.target)
+                             - N1.begin();
+                PSNode *target = t < N2.size() ? N2[t] : ptr.target;
+                if (!N2[i]->doesPointsTo(target, ptr.offset))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // A -> Q1 -> Q2 -> Q3 -> T1 -> ... -> T20
+    //       ^-----------/
+    // Q1 = CAST(Q2), Q2 = CAST(Q3), Q3 = CAST(A), so the pointer
+    // goes around the loop against the control flow.
+    // Returns the nodes in this order
+    static std::vector<analysis::pta::PSNode *>
+    buildCastLoop(analysis::pta::PointerSubgraph& PS)
+    {
+        using namespace dg::analysis::pta;
+        PSNode *A = PS.createNode(ALLOC);
+        PSNode *Q3 = PS.createNode(CAST, A);
+        PSNode *Q2 = PS.createNode(CAST, Q3);
+        PSNode *Q1 = PS.createNode(CAST, Q2);
+        std::vector<PSNode *> nodes = {A, Q1, Q2, Q3};
+
+        A->addSuccessor(Q1);
+        Q1->addSuccessor(Q2);
+        Q2->addSuccessor(Q3);
+        Q3->addSuccessor(Q1);
+
+        PSNode *last = Q3;
+        for (int i = 0; i < 20; ++i) {
+            PSNode *T = PS.createNode(NOOP);
+            last->addSuccessor(T);
+            last = T;
+            nodes.push_back(T);
+        }
+
+        PS.setRoot(A);
+        return nodes;
+    }
+
+    void scc_scheduling1()
+    {
+        using namespace dg::analysis::pta;
+        PointerSubgraph PS1, PS2;
+        std::vector<PSNode *> N1 = buildCastLoop(PS1);
+        std::vector<PSNode *> N2 = buildCastLoop(PS2);
+
+        PointsToFlowInsensitive rounds(&PS1);
+        rounds.run();
+
+        PointsToFlowInsensitive scc(&PS2);
+        scc.setSCCScheduling(true);
+        scc.run();
+
+        // the loop is iterated alone, the tail is processed once
+        check(scc.getProcessedNodesNum() < rounds.getProcessedNodesNum());
+
+        check(samePointsTo(N1, N2));
+        check(N1[1]->doesPointsTo(N1[0], 0));
+        check(N2[1]->doesPointsTo(N2[0], 0));
+    }
+
+    // the pointers to A, B and C are stored to P, strongly updated
+    // and read along a branch and a loop, the pointer to P is stored
+    // to Q and the memory of P is read through it:
+    //
+    // A, B, C, P, Q -> S5 -> S1 -> L1 -> S2 -> L2 -> S3 -> J -> L3 -> L4 -> L5
+    //                        ^                 \-> N ---/                  |
+    //                        \-------------------------------------------/
+    static std::vector<analysis::pta::PSNode *>
+    buildStrongUpdates(analysis::pta::PointerSubgraph& PS)
+    {
+        using namespace dg::analysis::pta;
+        PSNode *A = PS.createNode(ALLOC);
+        PSNode *B = PS.createNode(ALLOC);
+        PSNode *C = PS.createNode(ALLOC);
+        PSNode *P = PS.createNode(ALLOC);
+        PSNode *Q = PS.createNode(ALLOC);
+        PSNode *S5 = PS.createNode(STORE, P, Q);
+        PSNode *S1 = PS.createNode(STORE, A, P);
+        PSNode *L1 = PS.createNode(LOAD, P);
+        PSNode *S2 = PS.createNode(STORE, B, P);
+        PSNode *L2 = PS.createNode(LOAD, P);
+        PSNode *S3 = PS.createNode(STORE, C, P);
+        PSNode *N = PS.createNode(NOOP);
+        PSNode *J = PS.createNode(NOOP);
+        PSNode *L3 = PS.createNode(LOAD, P);
+        PSNode *L4 = PS.createNode(LOAD, Q);
+        PSNode *L5 = PS.createNode(LOAD, L4);
+
+        std::vector<PSNode *> nodes = {A, B, C, P, Q, S5, S1, L1, S2,
+                                       L2, S3, N, J, L3, L4, L5};
+        for (unsigned i = 0; i < 10; ++i)
+            nodes[i]->addSuccessor(nodes[i + 1]);
+
+        L2->addSuccessor(N);
+        S3->addSuccessor(J);
+        N->addSuccessor(J);
+        J->addSuccessor(L3);
+        L3->addSuccessor(L4);
+        L4->addSuccessor(L5);
+        L5->addSuccessor(S1);
+
+        PS.setRoot(A);
+        return nodes;
+    }
+
+    void sparse_strong_update1()
+    {
+        using namespace dg::analysis::pta;
+        PointerSubgraph PS1, PS2;
+        std::vector<PSNode *> N1 = buildStrongUpdates(PS1);
+        std::vector<PSNode *> N2 = buildStrongUpdates(PS2);
+
+        PointsToFlowSensitive FS(&PS1);
+        FS.run();
+
+        PointsToFlowSensitiveSparse SFS(&PS2);
+        SFS.run();
+
+        check(samePointsTo(N1, N2));
+
+        // L1, L2, L3 and L5 in this order
+        const unsigned loads[] = {7, 9, 13, 15};
+        for (std::vector<PSNode *> *N : {&N1, &N2}) {
+            PSNode *A = (*N)[0], *B = (*N)[1], *C = (*N)[2];
+            check((*N)[loads[0]]->pointsTo.size() == 1);
+            check((*N)[loads[0]]->doesPointsTo(A, 0));
+            check((*N)[loads[1]]->pointsTo.size() == 1);
+            check((*N)[loads[1]]->doesPointsTo(B, 0));
+            for (unsigned i = 2; i < 4; ++i) {
+                check((*N)[loads[i]]->pointsTo.size() == 2);
+                check((*N)[loads[i]]->doesPointsTo(B, 0));
+                check((*N)[loads[i]]->doesPointsTo(C, 0));
+            }
+        }
+    }
+
+    // objects that point to each other at offsets 0 and 8, loads
+    // through loaded pointers and copying within one object, in a loop
+    static std::vector<analysis::pta::PSNode *>
+    buildObjectsRing(analysis::pta::PointerSubgraph& PS, unsigned num)
+    {
+        using namespace dg::analysis::pta;
+        std::vector<PSNode *> nodes;
+        for (unsigned i = 0; i < num; ++i)
+            nodes.push_back(PS.createNode(ALLOC));
+
+        for (unsigned i = 0; i < num; ++i) {
+            PSNode *O = nodes[i];
+            PSNode *G = PS.createNode(GEP, O, (uint64_t) 8);
+            PSNode *S1 = PS.createNode(STORE, O, nodes[(i + 1) % num]);
+            PSNode *S2 = PS.createNode(STORE, nodes[(i + 2) % num], G);
+            PSNode *L1 = PS.createNode(LOAD, O);
+            PSNode *L2 = PS.createNode(LOAD, L1);
+            PSNode *M = PS.createNode(MEMCPY, O, O, (uint64_t) 0, (uint64_t) 16);
+            nodes.insert(nodes.end(), {G, S1, S2, L1, L2, M});
+        }
+
+        for (unsigned i = 0; i + 1 < nodes.size(); ++i)
+            nodes[i]->addSuccessor(nodes[i + 1]);
+        nodes.back()->addSuccessor(nodes[num]);
+
+        PS.setRoot(nodes[0]);
+        return nodes;
+    }
+
+    // the sparse analysis follows only the def-use chains,
+    // so it must process less nodes than the rounds over the graph
+    void sparse_def_chains1()
+    {
+        using namespace dg::analysis::pta;
+        PointerSubgraph PS1, PS2;
+        std::vector<PSNode *> N1 = buildObjectsRing(PS1, 20);
+        std::vector<PSNode *> N2 = buildObjectsRing(PS2, 20);
+
+        PointsToFlowSensitive FS(&PS1);
+        FS.run();
+
+        PointsToFlowSensitiveSparse SFS(&PS2);
+        SFS.run();
+
+        check(samePointsTo(N1, N2));
+        check(SFS.getProcessedNodesNum() < FS.getProcessedNodesNum());
+    }
+
+    void parallel_solving1()
+    {
+        using namespace dg::analysis::pta;
+        PointerSubgraph PS1, PS2, PS3;
+        std::vector<PSNode *> N1 = buildObjectsRing(PS1, 50);
+        std::vector<PSNode *> N2 = buildObjectsRing(PS2, 50);
+        std::vector<PSNode *> N3 = buildObjectsRing(PS3, 50);
+
+        PointsToFlowInsensitive seq(&PS1);
+        seq.run();
+
+        PointsToFlowInsensitive par(&PS2);
+        par.setThreadsNum(4);
+        par.run();
+
+        // the difference propagation does not work with threads,
+        // the analysis keeps it and solves in one thread
+        PointsToFlowInsensitive diff(&PS3);
+        diff.setThreadsNum(4);
+        diff.setDifferencePropagation(true);
+        diff.run();
+
+        check(samePointsTo(N1, N2));
+        check(samePointsTo(N1, N3));
+        check(diff.getDifferencePropagation());
+        // the first object has a pointer to the last one at offset 0
+        // (the last one to the one before it), L1 and L2 of the first
+        // object load them
+        check(N1[50 + 3]->doesPointsTo(N1[49], 0));
+        check(N1[50 + 4]->doesPointsTo(N1[48], 0));
+    }
+
+    // objects X_0, ..., X_num where X_i points to X_i+1 and the loads
+    // L_1 = *X_0, L_i+1 = *L_i that go in the reverse order in a loop,
+    // so that every round over the subgraph gets only one level further.
+    // The classes of X_i can be solved one after another
+    static std::vector<analysis::pta::PSNode *>
+    buildClassesChain(analysis::pta::PointerSubgraph& PS, unsigned num)
+    {
+        using namespace dg::analysis::pta;
+        std::vector<PSNode *> nodes;
+        for (unsigned i = 0; i <= num; ++i)
+            nodes.push_back(PS.createNode(ALLOC));
+
+        for (unsigned i = 0; i < num; ++i)
+            nodes.push_back(PS.createNode(STORE, nodes[i + 1], nodes[i]));
+
+        std::vector<PSNode *> loads = {PS.createNode(LOAD, nodes[0])};
+        for (unsigned i = 1; i < num; ++i)
+            loads.push_back(PS.createNode(LOAD, loads.back()));
+        nodes.insert(nodes.end(), loads.rbegin(), loads.rend());
+
+        for (unsigned i = 0; i + 1 < nodes.size(); ++i)
+            nodes[i]->addSuccessor(nodes[i + 1]);
+        nodes.back()->addSuccessor(nodes[num + 1]);
+
+        PS.setRoot(nodes[0]);
+        return nodes;
+    }
+
+    void alias_classes1()
+    {
+        using namespace dg::analysis::pta;
+        PointerSubgraph PS1, PS2;
+        std::vector<PSNode *> N1 = buildClassesChain(PS1, 10);
+        std::vector<PSNode *> N2 = buildClassesChain(PS2, 10);
+
+        PointsToFlowInsensitive FI(&PS1);
+        FI.run();
+
+        PointsToFlowInsensitive AC(&PS2);
+        AC.setAliasClassesScheduling(true);
+        AC.run();
+
+        check(samePointsTo(N1, N2));
+        // the last load (the first in the subgraph) yields X_10
+        check(N2[21]->pointsTo.size() == 1);
+        check(N2[21]->doesPointsTo(N2[10], 0));
+        // the rounds go over all the nodes for every level,
+        // the classes are solved once
+        check(AC.getProcessedNodesNum() < FI.getProcessedNodesNum());
+    }
+
+    void diff_propagation1()
+    {
+        using namespace dg::analysis::pta;
+        PointerSubgraph PS1, PS2;
+        std::vector<PSNode *> N1 = buildObjectsRing(PS1, 50);
+        std::vector<PSNode *> N2 = buildObjectsRing(PS2, 50);
+
+        // a cycle of PHIs that merges the loads of all the objects,
+        // so that the cycle detection collapses it during the analysis
+        for (std::vector<PSNode *> *N : {&N1, &N2}) {
+            PointerSubgraph& PS = (N == &N1) ? PS1 : PS2;
+            PSNode *P1 = PS.createNode(PHI, nullptr);
+            PSNode *P2 = PS.createNode(PHI, P1, nullptr);
+            P1->addOperand(P2);
+            for (unsigned i = 0; i < 50; ++i)
+                (i % 2 ? P1 : P2)->addOperand((*N)[50 + 6 * i + 3]);
+
+            // in the loop, so that they see the new pointers of the loads
+            P1->insertAfter(N->back());
+            P2->insertAfter(P1);
+            N->insert(N->end(), {P1, P2});
+        }
+
+        PointsToFlowInsensitive full(&PS1);
+        full.run();
+
+        // the users read only the new pointers of the operands,
+        // also after the operands were collapsed into one node
+        PointsToFlowInsensitive diff(&PS2);
+        diff.setDifferencePropagation(true);
+        diff.setCycleDetection(true);
+        diff.run();
+
+        check(diff.getCollapsedNodesNum() > 0);
+        check(samePointsTo(N1, N2));
+        check(N2.back()->pointsTo.size() >= 50);
     }
 
     void test()
     {
         unknown_offset1();
+        strided_offset1();
+        offset_map1();
+        unknown_memory1();
+        saturation1();
+        sparse_set1();
+        shared_set1();
+        frozen_subgraph1();
+        demand_driven1();
+        steensgaard1();
+        scc_scheduling1();
+        sparse_strong_update1();
+        sparse_def_chains1();
+        parallel_solving1();
+        alias_classes1();
+        diff_propagation1();
     }
 };
 
@@ -887,6 +2148,21 @@ int main(void)
 
     Runner.add(new FlowInsensitivePointsToTest());
     Runner.add(new FlowSensitivePointsToTest());
+    Runner.add(new FlowSensitiveSparsePointsToTest());
+    Runner.add(new FlowInsensitiveDiffPointsToTest());
+    Runner.add(new FlowSensitiveDiffPointsToTest());
+    Runner.add(new FlowInsensitiveSCCPointsToTest());
+    Runner.add(new FlowSensitiveSCCPointsToTest());
+    Runner.add(new FlowInsensitiveAliasClassesPointsToTest());
+    Runner.add(new FlowInsensitiveCyclesPointsToTest());
+    Runner.add(new FlowSensitiveCyclesPointsToTest());
+    Runner.add(new FlowInsensitiveEquivPointsToTest());
+    Runner.add(new FlowSensitiveEquivPointsToTest());
+    Runner.add(new FlowInsensitiveParallelPointsToTest());
+    Runner.add(new FlowInsensitiveParallelEquivPointsToTest());
+    Runner.add(new FlowInsensitiveFrozenPointsToTest());
+    Runner.add(new FlowSensitiveFrozenPointsToTest());
+    Runner.add(new DemandDrivenPointsToTest());
     Runner.add(new PSNodeTest());
 
     return Runner();
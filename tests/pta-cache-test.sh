@@ -0,0 +1,63 @@
+#!/bin/bash
+
+TESTS_DIR=`dirname $0`
+source "$TESTS_DIR/test-runner.sh"
+
+set_environment
+
+BCFILE="$TESTS_DIR/sources/pta-cache.bc"
+CACHE="$TESTS_DIR/sources/pta-cache.ptc"
+LOG="$CACHE.log"
+
+rm -f "$BCFILE" "$CACHE" "$CACHE.orig" "$LOG"
+
+# the points-to sets without the addresses of the nodes
+dump()
+{
+	llvm-ps-dump $@ "$BCFILE" 2>"$LOG" | sed 's/0x[0-9a-f]*//g' | sort
+}
+
+loaded()
+{
+	grep -q 'loaded from the cache' "$LOG"
+}
+
+compile "$TESTS_DIR/sources/funcptr1.c" "$BCFILE"
+EXPECTED="`dump`"
+
+# the first run stores the results, the second one loads them
+OUT="`dump -pta-cache "$CACHE"`"
+loaded && errmsg "Loaded a cache that does not exist"
+test -f "$CACHE" || errmsg "The cache was not stored"
+test "$OUT" = "$EXPECTED" || errmsg "Different results when storing the cache"
+
+OUT="`dump -pta-cache "$CACHE"`"
+loaded || errmsg "The cache was not loaded"
+test "$OUT" = "$EXPECTED" || errmsg "Different results from the cache"
+
+cp "$CACHE" "$CACHE.orig"
+SIZE=`stat -c %s "$CACHE"`
+
+# corrupted points-to sets
+printf '\377\377\377\377' | dd of="$CACHE" bs=1 seek=$((SIZE - 8)) \
+	conv=notrunc 2>/dev/null
+OUT="`dump -pta-cache "$CACHE"`"
+loaded && errmsg "Loaded a corrupted cache"
+test "$OUT" = "$EXPECTED" || errmsg "Wrong results with a corrupted cache"
+
+# truncated file
+head -c $((SIZE / 2)) "$CACHE.orig" > "$CACHE"
+OUT="`dump -pta-cache "$CACHE"`"
+loaded && errmsg "Loaded a truncated cache"
+test "$OUT" = "$EXPECTED" || errmsg "Wrong results with a truncated cache"
+
+# the cache for another module
+cp "$CACHE.orig" "$CACHE"
+compile "$TESTS_DIR/sources/funcptr2.c" "$BCFILE"
+EXPECTED="`dump`"
+OUT="`dump -pta-cache "$CACHE"`"
+loaded && errmsg "Loaded a stale cache"
+test "$OUT" = "$EXPECTED" || errmsg "Wrong results with a stale cache"
+
+rm -f "$BCFILE" "$CACHE" "$CACHE.orig" "$LOG"
+exit 0
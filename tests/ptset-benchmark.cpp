@@ -0,0 +1,108 @@
+#include <vector>
+#include <set>
+#include <string>
+#include <cstdlib>
+
+#include "analysis/PointsTo/Pointer.h"
+#include "analysis/PointsTo/PointsToSet.h"
+#include "analysis/PointsTo/PointerSubgraph.h"
+#include "../tools/TimeMeasure.h"
+
+using namespace dg::analysis::pta;
+
+typedef std::set<Pointer> StdSetT;
+typedef SparseBitvectorPointsToSet<Pointer> SparseSetT;
+typedef SharedPointsToSet<Pointer> SharedSetT;
+
+static bool addAll(StdSetT& to, const StdSetT& from)
+{
+    bool changed = false;
+    for (const Pointer& ptr : from)
+        changed |= to.insert(ptr).second;
+
+    return changed;
+}
+
+static bool addAll(SparseSetT& to, const SparseSetT& from)
+{
+    return to.add(from);
+}
+
+static bool addAll(SharedSetT& to, const SharedSetT& from)
+{
+    return to.add(from);
+}
+
+// create 'nodes' sets with at most 'size' random pointers
+// and then propagate them along a random graph until
+// fixpoint (like the points-to analysis does)
+template <typename SetT>
+size_t run(std::vector<PSNode *>& targets, int nodes, int size)
+{
+    std::vector<SetT> sets(nodes);
+    std::vector<int> edges(nodes * 2);
+
+    srand(nodes * size);
+    for (int i = 0; i < nodes; ++i) {
+        int num = rand() % (size + 1);
+        for (int j = 0; j < num; ++j)
+            sets[i].insert(Pointer(targets[rand() % targets.size()],
+                                   rand() % 4 * 8));
+
+        edges[2*i] = rand() % nodes;
+        edges[2*i + 1] = rand() % nodes;
+    }
+
+    bool changed;
+    do {
+        changed = false;
+        for (int i = 0; i < nodes; ++i) {
+            changed |= addAll(sets[i], sets[edges[2*i]]);
+            changed |= addAll(sets[i], sets[edges[2*i + 1]]);
+        }
+    } while (changed);
+
+    // just so that the compiler won't optimize it away
+    size_t total = 0;
+    for (const SetT& S : sets)
+        total += S.size();
+
+    return total;
+}
+
+template <typename SetT>
+void test(const char *name, std::vector<PSNode *>& targets,
+          int nodes, int size)
+{
+    dg::debug::TimeMeasure tm;
+    std::string msg = "[";
+    msg += name;
+    msg += "] ";
+    msg += std::to_string(nodes);
+    msg += " sets of initial size max ";
+    msg += std::to_string(size);
+    msg += " -- ";
+
+    tm.start();
+    size_t total = run<SetT>(targets, nodes, size);
+    tm.stop();
+    tm.report(msg.c_str());
+    printf("    (%lu pointers in sets total)\n", total);
+}
+
+int main()
+{
+    std::vector<PSNode *> targets;
+    for (int i = 0; i < 200; ++i)
+        targets.push_back(new PSNode(ALLOC));
+
+    int sizes[] = {1, 5, 10, 50, 100};
+    for (int size : sizes) {
+        test<StdSetT>("std::set", targets, 2000, size);
+        test<SparseSetT>("sparse bitvector", targets, 2000, size);
+        test<SharedSetT>("shared sparse bitvector", targets, 2000, size);
+    }
+
+    for (PSNode *n : targets)
+        delete n;
+}
@@ -1,20 +1,27 @@
 #include <vector>
+#include <set>
 #include <string>
+#include <cstdio>
 
 #include "analysis/ReachingDefinitions/RDMap.h"
 #include "analysis/ReachingDefinitions/ReachingDefinitions.h"
 #include "../tools/TimeMeasure.h"
 
+using dg::analysis::rd::StdRDMap;
+using dg::analysis::rd::FlatRDMap;
+
 // create two random rd maps of the
 // size 'size' and merge them
+template <typename MapT>
 void run(int size, int times = 100000)
 {
     using namespace dg::analysis::rd;
 
     std::vector<RDNode> rdnodes(size, RDNode());
 
+    srand(size);
     while (--times > 0) {
-        RDMap A, B;
+        MapT A, B;
 
         // fill in the maps randomly
         for (int i = 0; i < size; ++i) {
@@ -39,30 +46,78 @@ void run(int size, int times = 100000)
 
 }
 
-void test(int size)
+template <typename MapT>
+void test(const char *name, int size)
 {
     dg::debug::TimeMeasure tm;
-    std::string msg = "[200000 iter] Sets of size max ";
+    std::string msg = "[";
+    msg += name;
+    msg += "] [200000 iter] Sets of size max ";
     msg += std::to_string(size);
     msg += " -- ";
 
     tm.start();
-    run(size, 200000);
+    run<MapT>(size, 200000);
     tm.stop();
     tm.report(msg.c_str());
 }
 
+// create a map with 'size' definitions of 'size' / 4 objects
+// and query the reaching definitions of random objects.
+// The time of one query should grow only logarithmically
+template <typename MapT>
+size_t runLookup(int size, int queries)
+{
+    using namespace dg::analysis::rd;
+
+    int objects = size / 4 + 1;
+    std::vector<RDNode> rdnodes(objects, RDNode());
+
+    MapT M;
+    srand(size);
+    for (int i = 0; i < size; ++i) {
+        M.add(DefSite(&rdnodes[rand() % objects], (rand() % 16) * 4, 4),
+              &rdnodes[rand() % objects]);
+    }
+
+    // just so that the compiler won't optimize it away
+    size_t total = 0;
+    for (int i = 0; i < queries; ++i) {
+        std::set<RDNode *> defs;
+        total += M.get(&rdnodes[rand() % objects], (rand() % 16) * 4, 4, defs);
+    }
+
+    return total;
+}
+
+template <typename MapT>
+void testLookup(const char *name, int size)
+{
+    dg::debug::TimeMeasure tm;
+    std::string msg = "[";
+    msg += name;
+    msg += "] [100000 queries] Map with ";
+    msg += std::to_string(size);
+    msg += " definitions -- ";
+
+    tm.start();
+    size_t total = runLookup<MapT>(size, 100000);
+    tm.stop();
+    tm.report(msg.c_str());
+    printf("    (%lu definitions found total)\n", total);
+}
+
 int main()
 {
-    test(1);
-    test(3);
-    test(5);
-    test(10);
-    test(15);
-    test(20);
-    test(30);
-    test(50);
-    test(100);
-    test(200);
-    test(500);
+    int sizes[] = {1, 3, 5, 10, 15, 20, 30, 50, 100, 200, 500};
+    for (int size : sizes) {
+        test<StdRDMap>("std::map", size);
+        test<FlatRDMap>("sorted vector", size);
+    }
+
+    int lookup_sizes[] = {10, 100, 1000, 10000, 100000};
+    for (int size : lookup_sizes) {
+        testLookup<StdRDMap>("std::map", size);
+        testLookup<FlatRDMap>("sorted vector", size);
+    }
 }
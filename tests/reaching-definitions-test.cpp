@@ -237,12 +237,282 @@ public:
         //dumpMap(&S2);
     }
 
+    void unknown_set1()
+    {
+        RDNode S1;
+        RDNode S2;
+
+        RDNodesSet A, B;
+        check(A.insert(&S1));
+        check(B.insert(&S2));
+        check(A.add(B));
+        check(!A.add(B));
+        check(A.size() == 2);
+
+        // the unknown set absorbs everything
+        B.makeUnknown();
+        check(A.add(B));
+        check(A.isUnknown() && A.size() == 1);
+        check(!A.add(B));
+        check(!A.insert(&S1));
+        check(A.count(UNKNOWN_MEMORY) == 1);
+    }
+
+    // merge the same maps with both the backends
+    // and check that the results are the same
+    void flat_map1()
+    {
+        std::vector<RDNode> T(4), D(8);
+        T[0].setSize(8);
+
+        StdRDMap SA, SB;
+        FlatRDMap FA, FB;
+        for (int i = 0; i < 8; ++i) {
+            DefSite ds(&T[i % 4], (i % 3) * 4, 4);
+            SA.add(ds, &D[i]);
+            FA.add(ds, &D[i]);
+            SB.add(DefSite(&T[(i + 1) % 4], (i % 2) * 2, 4), &D[7 - i]);
+            FB.add(DefSite(&T[(i + 1) % 4], (i % 2) * 2, 4), &D[7 - i]);
+        }
+
+        SB.add(DefSite(&T[0]), &D[0]);
+        FB.add(DefSite(&T[0]), &D[0]);
+        SB.add(DefSite(&T[3]), &D[1]);
+        FB.add(DefSite(&T[3]), &D[1]);
+
+        // T[0] is overwritten whole and T[1] at 0 - 3
+        DefSiteSetT overwrites;
+        overwrites.insert(DefSite(&T[0], 0, 8));
+        overwrites.insert(DefSite(&T[1], 0, 4));
+
+        check(SA.merge(&SB, &overwrites) == FA.merge(&FB, &overwrites));
+        check(!FA.merge(&FB, &overwrites));
+        // merge the definitions of T[3] to unknown offset
+        check(SA.merge(&SB, nullptr, true, ~((uint32_t) 0), true)
+              == FA.merge(&FB, nullptr, true, ~((uint32_t) 0), true));
+
+        check(SA.getDefs().size() == FA.getDefs().size());
+        auto fit = FA.begin();
+        for (const auto& it : SA) {
+            check(!(it.first < fit->first) && !(fit->first < it.first));
+            std::set<RDNode *> sdefs(it.second.begin(), it.second.end());
+            std::set<RDNode *> fdefs(fit->second.begin(), fit->second.end());
+            check(sdefs == fdefs);
+            ++fit;
+        }
+
+        for (RDNode& t : T) {
+            std::set<RDNode *> sdefs, fdefs;
+            SA.get(&t, 2, 4, sdefs);
+            FA.get(&t, 2, 4, fdefs);
+            check(sdefs == fdefs);
+        }
+    }
+
+    void shared_map1()
+    {
+        RDNode AL1, AL2;
+        RDNode S1, S2, S3;
+        RDNode N1(NOOP), N2(NOOP), J(NOOP);
+
+        S1.addDef(&AL1, 0, 4, true /* strong update */);
+        S2.addDef(&AL2, 0, 4, true /* strong update */);
+        S3.addDef(&AL1, 0, 4, true /* strong update */);
+
+        // S1 -> N1 -> N2 -> S2 -> J
+        //   \-> S3 -------------/
+        AL1.addSuccessor(&AL2);
+        AL2.addSuccessor(&S1);
+        S1.addSuccessor(&N1);
+        N1.addSuccessor(&N2);
+        N2.addSuccessor(&S2);
+        S2.addSuccessor(&J);
+        S1.addSuccessor(&S3);
+        S3.addSuccessor(&J);
+
+        ReachingDefinitionsAnalysis RD(&AL1);
+        RD.run();
+
+        // the nodes that do not define anything share
+        // the map with their predecessor
+        const RDNode& cS1 = S1, &cN1 = N1, &cN2 = N2, &cS2 = S2, &cJ = J;
+        check(&cN1.getReachingDefinitions() == &cS1.getReachingDefinitions());
+        check(&cN2.getReachingDefinitions() == &cS1.getReachingDefinitions());
+        check(&cS2.getReachingDefinitions() != &cS1.getReachingDefinitions());
+        check(&cJ.getReachingDefinitions() != &cS2.getReachingDefinitions());
+
+        std::set<RDNode *> rd;
+        N2.getReachingDefinitions(&AL1, 0, 4, rd);
+        check(rd.size() == 1 && *rd.begin() == &S1);
+        rd.clear();
+        N2.getReachingDefinitions(&AL2, 0, 4, rd);
+        check(rd.empty());
+
+        rd.clear();
+        J.getReachingDefinitions(&AL1, 0, 4, rd);
+        check(rd.size() == 2 && rd.count(&S1) && rd.count(&S3));
+        rd.clear();
+        J.getReachingDefinitions(&AL2, 0, 4, rd);
+        check(rd.size() == 1 && *rd.begin() == &S2);
+
+        // changing the map through the non-const getter
+        // must not change the map of the other nodes
+        N1.getReachingDefinitions().update(DefSite(&AL2, 0, 4), &N1);
+        check(&cN1.getReachingDefinitions() != &cS1.getReachingDefinitions());
+        rd.clear();
+        N2.getReachingDefinitions(&AL2, 0, 4, rd);
+        check(rd.empty());
+    }
+
+    // AL -> S1 -> N1 -> N2 -> H -> N3 -> S2 -> N4 -> H (loop)
+    //                          \-> N5
+    static void buildLoop(std::vector<RDNode>& G)
+    {
+        enum { AL, S1, N1, N2, H, N3, S2, N4, N5 };
+        G[S1].addDef(&G[AL], 0, 4, true /* strong update */);
+        G[S2].addDef(&G[AL], 4, 4, true /* strong update */);
+
+        G[AL].addSuccessor(&G[S1]);
+        G[S1].addSuccessor(&G[N1]);
+        G[N1].addSuccessor(&G[N2]);
+        G[N2].addSuccessor(&G[H]);
+        G[H].addSuccessor(&G[N3]);
+        G[N3].addSuccessor(&G[S2]);
+        G[S2].addSuccessor(&G[N4]);
+        G[N4].addSuccessor(&G[H]);
+        G[H].addSuccessor(&G[N5]);
+    }
+
+    void compact1()
+    {
+        std::vector<RDNode> G(9), C(9);
+        buildLoop(G);
+        buildLoop(C);
+
+        ReachingDefinitionsAnalysis RD(&G[0]);
+        RD.run();
+
+        ReachingDefinitionsAnalysis RDC(&C[0]);
+        RDC.setCompactGraph(true);
+        RDC.run();
+
+        // N1, N2, N3 and N4 are removed, H joins two paths
+        // and N5 is the last node
+        check(RDC.getNodesNum() == 9);
+        check(RDC.getRemovedNodesNum() == 4);
+        check(RDC.getRepresentative(&C[2]) == &C[1]);
+        check(RDC.getRepresentative(&C[3]) == &C[1]);
+        check(RDC.getRepresentative(&C[7]) == &C[6]);
+        check(RDC.getRepresentative(&C[4]) == &C[4]);
+
+        // the removed nodes are still among the nodes of the graph
+        std::set<RDNode *> nodes;
+        RDC.getNodes(nodes);
+        check(nodes.size() == 9);
+
+        // all the nodes (also the removed ones) have
+        // the same reaching definitions as without compaction
+        for (unsigned i = 0; i < G.size(); ++i) {
+            for (uint64_t off = 0; off < 8; off += 4) {
+                std::set<RDNode *> rd, rdc, expected;
+                G[i].getReachingDefinitions(&G[0], off, 4, rd);
+                C[i].getReachingDefinitions(&C[0], off, 4, rdc);
+                for (RDNode *n : rd)
+                    expected.insert(&C[n - &G[0]]);
+
+                check(rdc == expected);
+            }
+        }
+    }
+
+    void worklist1()
+    {
+        std::vector<RDNode> G(9), W(9);
+        buildLoop(G);
+        buildLoop(W);
+
+        ReachingDefinitionsAnalysis RD(&G[0]);
+        RD.setRoundsScheduling(true);
+        RD.run();
+
+        ReachingDefinitionsAnalysis RDW(&W[0]);
+        RDW.run();
+
+        // every node is processed at least once
+        check(RDW.getVisitsNum() >= W.size());
+        check(RDW.getVisitsNum() < RD.getVisitsNum());
+        check(RDW.getMergesNum() <= RD.getMergesNum());
+
+        for (unsigned i = 0; i < G.size(); ++i) {
+            for (uint64_t off = 0; off < 8; off += 4) {
+                std::set<RDNode *> rd, rdw, expected;
+                G[i].getReachingDefinitions(&G[0], off, 4, rd);
+                W[i].getReachingDefinitions(&W[0], off, 4, rdw);
+                for (RDNode *n : rd)
+                    expected.insert(&W[n - &G[0]]);
+
+                check(rdw == expected);
+            }
+        }
+    }
+
+    void versions1()
+    {
+        // AL -> S[0..3] -> J -> N -> AL2 (switch-like join)
+        //             \-------------/
+        RDNode AL, AL2, J, N;
+        std::vector<RDNode> S(4);
+
+        for (unsigned i = 0; i < S.size(); ++i) {
+            S[i].addDef(&AL, i * 4, 4, true /* strong update */);
+            AL.addSuccessor(&S[i]);
+            S[i].addSuccessor(&J);
+        }
+
+        J.addSuccessor(&N);
+        N.addSuccessor(&AL2);
+        S[0].addSuccessor(&AL2);
+
+        ReachingDefinitionsAnalysis RD(&AL);
+        RD.run();
+
+        std::set<RDNode *> rd;
+        J.getReachingDefinitions(&AL, 0, 16, rd);
+        check(rd.size() == 4);
+        rd.clear();
+        AL2.getReachingDefinitions(&AL, 4, 4, rd);
+        check(rd.size() == 1 && *rd.begin() == &S[1]);
+
+        // nothing changed, so processing the nodes again
+        // does not merge any map
+        size_t merges = RD.getMergesNum();
+        check(!RD.processNode(&J));
+        check(!RD.processNode(&AL2));
+        check(!RD.processNode(&N));
+        check(RD.getMergesNum() == merges);
+
+        // a new definition in one predecessor is merged,
+        // the other predecessors are skipped
+        S[2].addDef(&AL2, 0, 4, true /* strong update */);
+        check(RD.processNode(&J));
+        check(RD.getMergesNum() == merges + 1);
+        rd.clear();
+        J.getReachingDefinitions(&AL2, 0, 4, rd);
+        check(rd.size() == 1 && *rd.begin() == &S[2]);
+    }
+
     void test()
     {
         basic1();
         basic2();
         basic3();
         basic4();
+        unknown_set1();
+        flat_map1();
+        shared_map1();
+        compact1();
+        worklist1();
+        versions1();
     }
 };
 
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Compare the reaching definitions with and without the summaries
+# of library functions on the testee programs (or on the given files).
+# Run from the build directory: library-summaries-benchmark.sh [file.c ...]
+
+DIR=`dirname $0`
+RDDUMP=${RDDUMP:-./tools/llvm-rd-dump}
+CLANG=${CLANG:-clang}
+
+if [ $# -eq 0 ]; then
+	set -- $DIR/testee/*.c
+fi
+
+TMP=`mktemp -d`
+trap "rm -rf $TMP" EXIT
+
+run()
+{
+	# the time goes to stderr, the stats to stdout
+	$RDDUMP "$1" -stats -library-summaries "$2" 2>$TMP/time \
+		| sed 's/^/    /'
+	grep "took" $TMP/time | sed 's/^INFO: /    /'
+}
+
+for F in "$@"; do
+	BC=$TMP/`basename "${F%.c}"`.bc
+	$CLANG -emit-llvm -c -g "$F" -o "$BC" || exit 1
+
+	echo "== $F"
+	echo "  builtin summaries:"
+	run "$BC" /dev/null
+	echo "  no summaries:"
+	run "$BC" none
+done
@@ -37,6 +37,7 @@
 #include "llvm/analysis/PointsTo/PointsTo.h"
 #include "analysis/PointsTo/PointsToFlowInsensitive.h"
 #include "analysis/PointsTo/PointsToFlowSensitive.h"
+#include "analysis/PointsTo/PointsToSteensgaard.h"
 #include "analysis/PointsTo/Pointer.h"
 
 #include "TimeMeasure.h"
@@ -50,6 +51,7 @@ static bool verbose;
 enum PTType {
     FLOW_SENSITIVE = 1,
     FLOW_INSENSITIVE,
+    STEENSGAARD,
 };
 
 static std::string
@@ -152,6 +154,9 @@ dumpMemoryObject(MemoryObject *mo, int ind, bool dot)
             printf("%*s", ind, "");
             if (it.first.isUnknown())
                 printf("[UNKNOWN] -> ");
+            else if (it.first.isStrided())
+                printf("[%lu + k*%lu] -> ", it.first.getBase(),
+                       it.first.getStride());
             else
                 printf("[%lu] -> ", *it.first);
 
@@ -159,6 +164,9 @@ dumpMemoryObject(MemoryObject *mo, int ind, bool dot)
 
             if (ptr.offset.isUnknown())
                 puts(" + UNKNOWN");
+            else if (ptr.offset.isStrided())
+                printf(" + %lu + k*%lu\n", ptr.offset.getBase(),
+                       ptr.offset.getStride());
             else
                 printf(" + %lu\n", *ptr.offset);
         }
@@ -168,28 +176,35 @@ dumpMemoryObject(MemoryObject *mo, int ind, bool dot)
 static void
 dumpMemoryMap(PointsToFlowSensitive::MemoryMapT *mm, int ind, bool dot)
 {
-    for (auto it : *mm) {
-        // print the key
-        const Pointer& key = it.first;
-        printf("%*s", ind, "");
+    for (const auto& objs : *mm) {
+        for (const auto& it : *objs.second) {
+            // print the key
+            const Pointer& key = it.first;
+            printf("%*s", ind, "");
 
-        putchar('[');
-        printName(key.target, dot);
+            putchar('[');
+            printName(key.target, dot);
 
-        if (key.offset.isUnknown())
-            puts(" + UNKNOWN]:");
-        else
-            printf(" + %lu]:\n", *key.offset);
+            if (key.offset.isUnknown())
+                puts(" + UNKNOWN]:");
+            else if (key.offset.isStrided())
+                printf(" + %lu + k*%lu]:\n", key.offset.getBase(),
+                       key.offset.getStride());
+            else
+                printf(" + %lu]:\n", *key.offset);
 
-        for (MemoryObject *mo : it.second)
-            dumpMemoryObject(mo, ind + 4, dot);
+            for (MemoryObject *mo : it.second)
+                dumpMemoryObject(mo, ind + 4, dot);
+        }
     }
 }
 
 static void
 dumpPointerSubgraphData(PSNode *n, PTType type, bool dot = false)
 {
-    if (type == FLOW_INSENSITIVE) {
+    // Steensgaard's analysis keeps the memory objects
+    // the same way as the flow-insensitive analysis
+    if (type == FLOW_INSENSITIVE || type == STEENSGAARD) {
         MemoryObject *mo = n->getData<MemoryObject>();
         if (!mo)
             return;
@@ -242,6 +257,9 @@ dumpPSNode(PSNode *n, PTType type)
         printName(ptr.target, false);
         if (ptr.offset.isUnknown())
             puts(" + UNKNOWN_OFFSET");
+        else if (ptr.offset.isStrided())
+            printf(" + %lu + k*%lu\n", ptr.offset.getBase(),
+                   ptr.offset.getStride());
         else
             printf(" + %lu\n", *ptr.offset);
     }
@@ -273,6 +291,9 @@ dumpPointerSubgraphdot(LLVMPointerAnalysis *pta, PTType type)
             printf(" + ");
             if (ptr.offset.isUnknown())
                 printf("UNKNOWN_OFFSET");
+            else if (ptr.offset.isStrided())
+                printf("%lu + k*%lu", ptr.offset.getBase(),
+                       ptr.offset.getStride());
             else
                 printf("%lu", *ptr.offset);
         }
@@ -327,6 +348,9 @@ int main(int argc, char *argv[])
     const char *module = nullptr;
     PTType type = FLOW_INSENSITIVE;
     uint64_t field_senitivity = UNKNOWN_OFFSET;
+    bool merge_equivalent = false;
+    const char *pta_cache = nullptr;
+    const char *library_summaries = nullptr;
 
     // parse options
     for (int i = 1; i < argc; ++i) {
@@ -334,8 +358,16 @@ int main(int argc, char *argv[])
         if (strcmp(argv[i], "-pta") == 0) {
             if (strcmp(argv[i+1], "fs") == 0)
                 type = FLOW_SENSITIVE;
+            else if (strcmp(argv[i+1], "steens") == 0)
+                type = STEENSGAARD;
         } else if (strcmp(argv[i], "-pta-field-sensitive") == 0) {
             field_senitivity = (uint64_t) atoll(argv[i + 1]);
+        } else if (strcmp(argv[i], "-merge-equivalent") == 0) {
+            merge_equivalent = true;
+        } else if (strcmp(argv[i], "-pta-cache") == 0) {
+            pta_cache = argv[++i];
+        } else if (strcmp(argv[i], "-library-summaries") == 0) {
+            library_summaries = argv[++i];
         } else if (strcmp(argv[i], "-dot") == 0) {
             todot = true;
         } else if (strcmp(argv[i], "-v") == 0) {
@@ -367,16 +399,48 @@ int main(int argc, char *argv[])
     debug::TimeMeasure tm;
 
     LLVMPointerAnalysis PTA(M, field_senitivity);
+    PTA.setMergeEquivalent(merge_equivalent);
+    if (pta_cache)
+        PTA.setCacheFile(pta_cache);
+
+    // the builtin summaries extended with the ones from the file
+    analysis::LibrarySummaries summaries(analysis::LibrarySummaries::getBuiltin());
+    if (library_summaries) {
+        std::string err;
+        if (strcmp(library_summaries, "none") == 0) {
+            PTA.setLibrarySummaries(nullptr);
+        } else if (summaries.load(library_summaries, &err)) {
+            PTA.setLibrarySummaries(&summaries);
+        } else {
+            llvm::errs() << "Failed loading library summaries: " << err << "\n";
+            return 1;
+        }
+    }
 
     tm.start();
 
     if (type == FLOW_INSENSITIVE)
         PTA.run<analysis::pta::PointsToFlowInsensitive>();
+    else if (type == STEENSGAARD)
+        PTA.run<analysis::pta::PointsToSteensgaard>();
     else
         PTA.run<analysis::pta::PointsToFlowSensitive>();
 
     tm.stop();
     tm.report("INFO: Points-to analysis [new] took");
+
+    if (PTA.resultsLoaded())
+        errs() << "INFO: Points-to sets loaded from the cache\n";
+
+    if (verbose) {
+        std::set<PSNode *> nodes;
+        PTA.getNodes(nodes);
+        errs() << "INFO: Pointer subgraph nodes: "
+               << nodes.size() + PTA.getSubstitutedNodesNum()
+               << " before merging equivalent nodes, "
+               << nodes.size() << " after\n";
+    }
+
     dumpPointerSubgraph(&PTA, type, todot);
 
     return 0;
@@ -35,6 +35,9 @@
 
 #include "analysis/PointsTo/PointsToFlowInsensitive.h"
 #include "analysis/PointsTo/PointsToFlowSensitive.h"
+#include "analysis/PointsTo/PointsToFlowSensitiveSparse.h"
+#include "analysis/PointsTo/PointsToDemandDriven.h"
+#include "analysis/PointsTo/PointsToSteensgaard.h"
 #include "analysis/PointsTo/Pointer.h"
 
 #include "TimeMeasure.h"
@@ -46,6 +49,8 @@ using llvm::errs;
 enum PTType {
     FLOW_SENSITIVE = 1,
     FLOW_INSENSITIVE,
+    SPARSE_FLOW_SENSITIVE = 4,
+    STEENSGAARD = 8,
 };
 
 static std::string
@@ -118,6 +123,9 @@ dumpPSNode(PSNode *n)
         printName(ptr.target);
         if (ptr.offset.isUnknown())
             puts(" + UNKNOWN_OFFSET");
+        else if (ptr.offset.isStrided())
+            printf(" + %lu + k*%lu\n", ptr.offset.getBase(),
+                   ptr.offset.getStride());
         else
             printf(" + %lu\n", *ptr.offset);
     }
@@ -165,7 +173,9 @@ static bool verify_ptsets(const llvm::Value *val,
             if ((ptr2.target->getUserData<llvm::Value>()
                 == ptr.target->getUserData<llvm::Value>())
                 && (ptr2.offset == ptr.offset ||
-                    ptr2.offset.isUnknown()
+                    ptr2.offset.isUnknown() ||
+                    (ptr2.offset.isStrided() && ptr.offset.isConcrete()
+                     && ptr2.offset.mayAlias(ptr.offset))
                     /* || ptr.offset.isUnknown()*/)) {
                 found = true;
                 break;
@@ -186,6 +196,290 @@ static bool verify_ptsets(const llvm::Value *val,
     return true;
 }
 
+// check that the points-to sets computed by the two runs
+// of the same analysis are the same
+static bool compare_ptsets(const llvm::Value *val,
+                           LLVMPointerAnalysis *full,
+                           LLVMPointerAnalysis *diff)
+{
+    PSNode *fullnode = full->getPointsTo(val);
+    PSNode *diffnode = diff->getPointsTo(val);
+
+    if (!fullnode && !diffnode)
+        return true;
+
+    if (!fullnode || !diffnode
+        || fullnode->pointsTo.size() != diffnode->pointsTo.size()) {
+        llvm::errs() << "Different points-to sets for: " << *val << "\n";
+        llvm::errs() << "FULL ";
+        if (fullnode)
+            dumpPSNode(fullnode);
+        llvm::errs() << "DIFF ";
+        if (diffnode)
+            dumpPSNode(diffnode);
+        return false;
+    }
+
+    for (const Pointer& ptr : diffnode->pointsTo) {
+        bool found = false;
+        for (const Pointer& ptr2 : fullnode->pointsTo) {
+            if (ptr2.target->getUserData<llvm::Value>()
+                == ptr.target->getUserData<llvm::Value>()
+                && ptr2.offset == ptr.offset) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            llvm::errs() << "Different points-to sets for: " << *val << "\n";
+            llvm::errs() << "FULL ";
+            dumpPSNode(fullnode);
+            llvm::errs() << "DIFF ";
+            dumpPSNode(diffnode);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool compare_ptsets(llvm::Module *M,
+                           LLVMPointerAnalysis *full,
+                           LLVMPointerAnalysis *diff)
+{
+    using namespace llvm;
+    bool ret = true;
+
+    for (Function& F : *M)
+        for (BasicBlock& B : F)
+            for (Instruction& I : B)
+                if (!compare_ptsets(&I, full, diff))
+                    ret = false;
+
+    return ret;
+}
+
+// run the analysis with full re-processing and with difference
+// propagation, compare the times and the results
+template <typename PTType>
+static bool compare_engines(llvm::Module *M, const char *name,
+                            bool scc_scheduling, bool cycle_detection,
+                            bool merge_equivalent)
+{
+    debug::TimeMeasure tm;
+    std::string msg;
+
+    LLVMPointerAnalysis full(M);
+    full.setSCCScheduling(scc_scheduling);
+    full.setCycleDetection(cycle_detection);
+    full.setMergeEquivalent(merge_equivalent);
+    tm.start();
+    full.run<PTType>();
+    tm.stop();
+    msg = std::string("INFO: ") + name + " (full re-processing) took";
+    tm.report(msg.c_str());
+    llvm::errs() << "INFO: Processed " << full.getProcessedNodesNum()
+                 << " nodes\n";
+
+    LLVMPointerAnalysis diff(M);
+    diff.setDifferencePropagation(true);
+    diff.setSCCScheduling(scc_scheduling);
+    diff.setCycleDetection(cycle_detection);
+    diff.setMergeEquivalent(merge_equivalent);
+    tm.start();
+    diff.run<PTType>();
+    tm.stop();
+    msg = std::string("INFO: ") + name + " (difference propagation) took";
+    tm.report(msg.c_str());
+    llvm::errs() << "INFO: Processed " << diff.getProcessedNodesNum()
+                 << " nodes\n";
+
+    bool ret = compare_ptsets(M, &full, &diff);
+    if (ret)
+        llvm::errs() << name << ": results of both engines are the same\n";
+
+    return ret;
+}
+
+// run the flow-sensitive analysis and the sparse flow-sensitive
+// analysis, compare the times and the results
+static bool compare_sparse(llvm::Module *M, bool scc_scheduling,
+                           bool diff_propagation)
+{
+    debug::TimeMeasure tm;
+
+    LLVMPointerAnalysis fs(M);
+    fs.setDifferencePropagation(diff_propagation);
+    fs.setSCCScheduling(scc_scheduling);
+    tm.start();
+    fs.run<analysis::pta::PointsToFlowSensitive>();
+    tm.stop();
+    tm.report("INFO: Points-to flow-sensitive analysis took");
+    llvm::errs() << "INFO: Processed " << fs.getProcessedNodesNum()
+                 << " nodes\n";
+
+    LLVMPointerAnalysis sfs(M);
+    sfs.setDifferencePropagation(diff_propagation);
+    sfs.setSCCScheduling(scc_scheduling);
+    tm.start();
+    sfs.run<analysis::pta::PointsToFlowSensitiveSparse>();
+    tm.stop();
+    tm.report("INFO: Points-to sparse flow-sensitive analysis took");
+    llvm::errs() << "INFO: Processed " << sfs.getProcessedNodesNum()
+                 << " nodes\n";
+
+    bool ret = compare_ptsets(M, &fs, &sfs);
+    if (ret)
+        llvm::errs() << "Results of both analyses are the same\n";
+
+    return ret;
+}
+
+// run the flow-insensitive analysis and ask the demand-driven analysis
+// about the instructions of the function @query_fun (or of all functions),
+// compare the times and the results
+static bool compare_demand(llvm::Module *M, const char *query_fun,
+                           size_t budget)
+{
+    using namespace llvm;
+    debug::TimeMeasure tm;
+
+    LLVMPointerAnalysis fi(M);
+    tm.start();
+    fi.run<analysis::pta::PointsToFlowInsensitive>();
+    tm.stop();
+    tm.report("INFO: Points-to flow-insensitive analysis took");
+    llvm::errs() << "INFO: Processed " << fi.getProcessedNodesNum()
+                 << " nodes\n";
+
+    LLVMPointerAnalysis dd(M);
+    dd.setDemandBudget(budget);
+    tm.start();
+    dd.run<analysis::pta::PointsToDemandDriven>();
+    size_t queries = 0;
+    for (Function& F : *M) {
+        if (query_fun && F.getName() != query_fun)
+            continue;
+
+        for (BasicBlock& B : F) {
+            for (Instruction& I : B) {
+                dd.getPointsTo(&I);
+                ++queries;
+            }
+        }
+    }
+    tm.stop();
+    tm.report("INFO: Points-to demand-driven analysis took");
+    llvm::errs() << "INFO: Asked about " << queries << " instructions\n";
+
+    bool ret = true;
+    for (Function& F : *M) {
+        if (query_fun && F.getName() != query_fun)
+            continue;
+
+        for (BasicBlock& B : F)
+            for (Instruction& I : B)
+                if (!compare_ptsets(&I, &fi, &dd))
+                    ret = false;
+    }
+
+    if (ret)
+        llvm::errs() << "Results of both analyses are the same\n";
+
+    return ret;
+}
+
+// run the flow-insensitive analysis in one thread and in more threads,
+// compare the times and the results
+static bool compare_threads(llvm::Module *M, unsigned threads_num,
+                            bool merge_equivalent)
+{
+    debug::TimeMeasure tm;
+    std::string msg;
+
+    LLVMPointerAnalysis seq(M);
+    seq.setMergeEquivalent(merge_equivalent);
+    tm.start();
+    seq.run<analysis::pta::PointsToFlowInsensitive>();
+    tm.stop();
+    tm.report("INFO: Points-to flow-insensitive analysis (1 thread) took");
+    llvm::errs() << "INFO: Processed " << seq.getProcessedNodesNum()
+                 << " nodes\n";
+
+    LLVMPointerAnalysis par(M);
+    par.setMergeEquivalent(merge_equivalent);
+    par.setThreadsNum(threads_num);
+    tm.start();
+    par.run<analysis::pta::PointsToFlowInsensitive>();
+    tm.stop();
+    msg = "INFO: Points-to flow-insensitive analysis ("
+          + std::to_string(threads_num) + " threads) took";
+    tm.report(msg.c_str());
+    llvm::errs() << "INFO: Processed " << par.getProcessedNodesNum()
+                 << " nodes\n";
+
+    bool ret = compare_ptsets(M, &seq, &par);
+    if (ret)
+        llvm::errs() << "Results of both runs are the same\n";
+
+    return ret;
+}
+
+// count the pointers in the points-to sets of the instructions
+// and the sets that contain the unknown pointer
+static void count_ptsets(llvm::Module *M, LLVMPointerAnalysis *pta,
+                         size_t& pointers, size_t& top_sets)
+{
+    using namespace llvm;
+
+    pointers = top_sets = 0;
+    for (Function& F : *M) {
+        for (BasicBlock& B : F) {
+            for (Instruction& I : B) {
+                PSNode *node = pta->getPointsTo(&I);
+                if (!node)
+                    continue;
+
+                pointers += node->pointsTo.size();
+                if (node->isTop())
+                    ++top_sets;
+            }
+        }
+    }
+}
+
+// run the flow-insensitive analysis without and with the saturation
+// of the sets with the unknown pointer, compare the times and the sizes
+static bool compare_saturation(llvm::Module *M, bool merge_equivalent)
+{
+    debug::TimeMeasure tm;
+    size_t pointers, top_sets;
+
+    LLVMPointerAnalysis exact(M);
+    exact.setMergeEquivalent(merge_equivalent);
+    tm.start();
+    exact.run<analysis::pta::PointsToFlowInsensitive>();
+    tm.stop();
+    tm.report("INFO: Points-to flow-insensitive analysis took");
+    count_ptsets(M, &exact, pointers, top_sets);
+    llvm::errs() << "INFO: " << pointers << " pointers, "
+                 << top_sets << " sets with unknown pointer\n";
+
+    LLVMPointerAnalysis sat(M);
+    sat.setMergeEquivalent(merge_equivalent);
+    sat.setSaturateUnknown(true);
+    tm.start();
+    sat.run<analysis::pta::PointsToFlowInsensitive>();
+    tm.stop();
+    tm.report("INFO: Points-to flow-insensitive analysis (saturated) took");
+    count_ptsets(M, &sat, pointers, top_sets);
+    llvm::errs() << "INFO: " << pointers << " pointers, "
+                 << top_sets << " sets with unknown pointer\n";
+
+    return true;
+}
+
 static bool verify_ptsets(llvm::Module *M,
                           LLVMPointerAnalysis *fi,
                           LLVMPointerAnalysis *fs)
@@ -209,6 +503,24 @@ int main(int argc, char *argv[])
     llvm::SMDiagnostic SMD;
     const char *module = nullptr;
     unsigned type = FLOW_SENSITIVE | FLOW_INSENSITIVE;
+    bool diff_propagation = false;
+    bool compare_diff = false;
+    bool compare_sparse_fs = false;
+    bool compare_threads_num = false;
+    unsigned threads_num = 1;
+    bool scc_scheduling = false;
+    bool alias_classes = false;
+    bool cycle_detection = false;
+    bool merge_equivalent = false;
+    bool saturate_unknown = false;
+    bool compare_saturated = false;
+    bool freeze_subgraph = false;
+    LLVMPointerAnalysis::FuncptrResolution funcptr_resolution
+        = LLVMPointerAnalysis::FUNCPTR_LAZY;
+    bool compare_demand_driven = false;
+    const char *demand_fun = nullptr;
+    size_t demand_budget = 0;
+    bool verbose = false;
 
     // parse options
     for (int i = 1; i < argc; ++i) {
@@ -218,19 +530,60 @@ int main(int argc, char *argv[])
                 type = FLOW_SENSITIVE;
             else if (strcmp(argv[i+1], "fi") == 0)
                 type = FLOW_INSENSITIVE;
+            else if (strcmp(argv[i+1], "sfs") == 0)
+                type = SPARSE_FLOW_SENSITIVE;
+            else if (strcmp(argv[i+1], "steens") == 0)
+                type = STEENSGAARD;
             else {
                 errs() << "Unknown PTA type" << argv[i + 1] << "\n";
                 abort();
             }
-        /*} else if (strcmp(argv[i], "-v") == 0) {
-            verbose = true;*/
+        } else if (strcmp(argv[i], "-diff") == 0) {
+            diff_propagation = true;
+        } else if (strcmp(argv[i], "-diff-compare") == 0) {
+            compare_diff = true;
+        } else if (strcmp(argv[i], "-steens-compare") == 0) {
+            type = FLOW_INSENSITIVE | STEENSGAARD;
+        } else if (strcmp(argv[i], "-sparse-compare") == 0) {
+            compare_sparse_fs = true;
+        } else if (strcmp(argv[i], "-threads") == 0) {
+            threads_num = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-threads-compare") == 0) {
+            compare_threads_num = true;
+        } else if (strcmp(argv[i], "-scc") == 0) {
+            scc_scheduling = true;
+        } else if (strcmp(argv[i], "-alias-classes") == 0) {
+            alias_classes = true;
+        } else if (strcmp(argv[i], "-collapse-cycles") == 0) {
+            cycle_detection = true;
+        } else if (strcmp(argv[i], "-merge-equivalent") == 0) {
+            merge_equivalent = true;
+        } else if (strcmp(argv[i], "-saturate") == 0) {
+            saturate_unknown = true;
+        } else if (strcmp(argv[i], "-saturate-compare") == 0) {
+            compare_saturated = true;
+        } else if (strcmp(argv[i], "-freeze") == 0) {
+            freeze_subgraph = true;
+        } else if (strcmp(argv[i], "-funcptr") == 0) {
+            if (strcmp(argv[i+1], "sig") == 0)
+                funcptr_resolution = LLVMPointerAnalysis::FUNCPTR_SIGNATURE;
+            else if (strcmp(argv[i+1], "fi") == 0)
+                funcptr_resolution = LLVMPointerAnalysis::FUNCPTR_FLOW_INSENSITIVE;
+        } else if (strcmp(argv[i], "-demand-compare") == 0) {
+            compare_demand_driven = true;
+        } else if (strcmp(argv[i], "-demand-fun") == 0) {
+            demand_fun = argv[++i];
+        } else if (strcmp(argv[i], "-demand-budget") == 0) {
+            demand_budget = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
         } else {
             module = argv[i];
         }
     }
 
     if (!module) {
-        errs() << "Usage: % llvm-pta-compare [-pta fs|fi] IR_module\n";
+        errs() << "Usage: % llvm-pta-compare [-pta fs|fi|sfs|steens] [-diff|-diff-compare|-sparse-compare|-steens-compare] [-threads N] [-threads-compare] [-demand-compare [-demand-fun F] [-demand-budget N]] [-scc] [-alias-classes] [-collapse-cycles] [-merge-equivalent] [-saturate] [-saturate-compare] [-freeze] [-funcptr sig|fi] [-v] IR_module\n";
         return 1;
     }
 
@@ -248,27 +601,116 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (compare_diff) {
+        int ret = 0;
+        if (type & FLOW_INSENSITIVE)
+            ret |= !compare_engines<analysis::pta::PointsToFlowInsensitive>(M,
+                            "Points-to flow-insensitive analysis", scc_scheduling,
+                            cycle_detection, merge_equivalent);
+        if (type & FLOW_SENSITIVE)
+            ret |= !compare_engines<analysis::pta::PointsToFlowSensitive>(M,
+                            "Points-to flow-sensitive analysis", scc_scheduling,
+                            cycle_detection, merge_equivalent);
+
+        return ret;
+    }
+
+    if (compare_sparse_fs)
+        return !compare_sparse(M, scc_scheduling, diff_propagation);
+
+    if (compare_threads_num)
+        return !compare_threads(M, threads_num, merge_equivalent);
+
+    if (compare_demand_driven)
+        return !compare_demand(M, demand_fun, demand_budget);
+
+    if (compare_saturated)
+        return !compare_saturation(M, merge_equivalent);
+
     debug::TimeMeasure tm;
 
     LLVMPointerAnalysis *PTAfs = nullptr;
     LLVMPointerAnalysis *PTAfi = nullptr;
+    LLVMPointerAnalysis *PTAsfs = nullptr;
+    LLVMPointerAnalysis *PTAsteens = nullptr;
 
     if (type & FLOW_INSENSITIVE) {
         PTAfi = new LLVMPointerAnalysis(M);
+        PTAfi->setDifferencePropagation(diff_propagation);
+        PTAfi->setSCCScheduling(scc_scheduling);
+        PTAfi->setAliasClassesScheduling(alias_classes);
+        PTAfi->setCycleDetection(cycle_detection);
+        PTAfi->setMergeEquivalent(merge_equivalent);
+        PTAfi->setThreadsNum(threads_num);
+        PTAfi->setSaturateUnknown(saturate_unknown);
+        PTAfi->setFreezeSubgraph(freeze_subgraph);
+        PTAfi->setFuncptrResolution(funcptr_resolution);
 
         tm.start();
         PTAfi->run<analysis::pta::PointsToFlowInsensitive>();
         tm.stop();
         tm.report("INFO: Points-to flow-insensitive analysis took");
+
+        if (verbose) {
+            llvm::errs() << "INFO: Processed " << PTAfi->getProcessedNodesNum()
+                         << " nodes\n";
+            if (cycle_detection)
+                llvm::errs() << "INFO: Collapsed " << PTAfi->getCollapsedNodesNum()
+                             << " nodes\n";
+        }
     }
 
     if (type & FLOW_SENSITIVE) {
         PTAfs = new LLVMPointerAnalysis(M);
+        PTAfs->setDifferencePropagation(diff_propagation);
+        PTAfs->setSCCScheduling(scc_scheduling);
+        PTAfs->setCycleDetection(cycle_detection);
+        PTAfs->setMergeEquivalent(merge_equivalent);
+        PTAfs->setSaturateUnknown(saturate_unknown);
+        PTAfs->setFreezeSubgraph(freeze_subgraph);
+        PTAfs->setFuncptrResolution(funcptr_resolution);
 
         tm.start();
         PTAfs->run<analysis::pta::PointsToFlowSensitive>();
         tm.stop();
         tm.report("INFO: Points-to flow-sensitive analysis took");
+
+        if (verbose) {
+            llvm::errs() << "INFO: Processed " << PTAfs->getProcessedNodesNum()
+                         << " nodes\n";
+            if (cycle_detection)
+                llvm::errs() << "INFO: Collapsed " << PTAfs->getCollapsedNodesNum()
+                             << " nodes\n";
+        }
+    }
+
+    if (type & SPARSE_FLOW_SENSITIVE) {
+        PTAsfs = new LLVMPointerAnalysis(M);
+        PTAsfs->setDifferencePropagation(diff_propagation);
+        PTAsfs->setSCCScheduling(scc_scheduling);
+        PTAsfs->setSaturateUnknown(saturate_unknown);
+        PTAsfs->setFreezeSubgraph(freeze_subgraph);
+        PTAsfs->setFuncptrResolution(funcptr_resolution);
+
+        tm.start();
+        PTAsfs->run<analysis::pta::PointsToFlowSensitiveSparse>();
+        tm.stop();
+        tm.report("INFO: Points-to sparse flow-sensitive analysis took");
+
+        if (verbose)
+            llvm::errs() << "INFO: Processed " << PTAsfs->getProcessedNodesNum()
+                         << " nodes\n";
+    }
+
+    if (type & STEENSGAARD) {
+        PTAsteens = new LLVMPointerAnalysis(M);
+        PTAsteens->setSaturateUnknown(saturate_unknown);
+        PTAsteens->setFreezeSubgraph(freeze_subgraph);
+
+        tm.start();
+        PTAsteens->run<analysis::pta::PointsToSteensgaard>();
+        tm.stop();
+        tm.report("INFO: Points-to Steensgaard's analysis took");
     }
 
     int ret = 0;
@@ -276,10 +718,16 @@ int main(int argc, char *argv[])
         ret = !verify_ptsets(M, PTAfi, PTAfs);
         if (ret == 0)
             llvm::errs() << "FS is a subset of FI, all OK\n";
+    } else if (type == (FLOW_INSENSITIVE | STEENSGAARD)) {
+        ret = !verify_ptsets(M, PTAsteens, PTAfi);
+        if (ret == 0)
+            llvm::errs() << "FI is a subset of Steensgaard's, all OK\n";
     }
 
     delete PTAfi;
     delete PTAfs;
+    delete PTAsfs;
+    delete PTAsteens;
 
     return ret;
 }
@@ -110,7 +110,7 @@ printName(RDNode *node, bool dot)
 static void
 dumpMap(RDNode *node, bool dot = false)
 {
-    RDMap& map = node->getReachingDefinitions();
+    const RDMap& map = node->getReachingDefinitions();
     for (auto it : map) {
         for (RDNode *site : it.second) {
             printName(it.first.target, dot);
@@ -222,6 +222,78 @@ dumpRDdot(LLVMReachingDefinitions *RD)
     printf("}\n");
 }
 
+// print the numbers that tell how precise the results are
+static void
+dumpStats(LLVMPointerAnalysis *PTA, LLVMReachingDefinitions *RD)
+{
+    std::set<pta::PSNode *> psnodes;
+    PTA->getNodes(psnodes);
+
+    size_t pointers = 0, unknown_pointers = 0;
+    for (pta::PSNode *node : psnodes) {
+        for (const pta::Pointer& ptr : node->pointsTo) {
+            ++pointers;
+            if (ptr.isUnknown())
+                ++unknown_pointers;
+        }
+    }
+
+    std::set<RDNode *> nodes;
+    RD->getNodes(nodes);
+
+    size_t defs = 0, unknown_defs = 0;
+    for (RDNode *node : nodes) {
+        for (const DefSite& def : node->getDefines()) {
+            ++defs;
+            if (def.target == rd::UNKNOWN_MEMORY)
+                ++unknown_defs;
+        }
+    }
+
+    printf("Pointers: %lu (unknown: %lu)\n", pointers, unknown_pointers);
+    printf("Definitions: %lu (unknown memory: %lu)\n", defs, unknown_defs);
+    printf("RD visits: %lu, merges: %lu\n",
+           RD->getVisitsNum(), RD->getMergesNum());
+}
+
+static uint64_t
+toMs(const struct timespec& t)
+{
+    return t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+// report how many nodes the compaction removed and compare
+// the time of the analysis with the time of the analysis
+// on the graph that is not compacted
+static void
+reportCompaction(llvm::Module *M, LLVMPointerAnalysis *PTA,
+                 LLVMReachingDefinitions *RD, uint64_t compacted_ms,
+                 bool strong_update_unknown, uint32_t max_set_size,
+                 bool rounds_scheduling)
+{
+    size_t nodes = RD->getNodesNum();
+    size_t removed = RD->getRemovedNodesNum();
+    llvm::errs() << "INFO: Compaction removed " << removed << " of "
+                 << nodes << " nodes ("
+                 << (nodes ? removed * 100 / nodes : 0) << "%)\n";
+
+    debug::TimeMeasure tm;
+    LLVMReachingDefinitions full(M, PTA, strong_update_unknown, max_set_size);
+    full.setRoundsScheduling(rounds_scheduling);
+    tm.start();
+    full.run();
+    tm.stop();
+    tm.report("INFO: Reaching definitions analysis without compaction took");
+
+    uint64_t full_ms = toMs(tm.duration());
+    if (full_ms >= compacted_ms)
+        llvm::errs() << "INFO: Compaction saved "
+                     << full_ms - compacted_ms << " ms\n";
+    else
+        llvm::errs() << "INFO: Compaction lost "
+                     << compacted_ms - full_ms << " ms\n";
+}
+
 static void
 dumpRD(LLVMReachingDefinitions *RD, bool todot)
 {
@@ -248,6 +320,11 @@ int main(int argc, char *argv[])
     uint64_t field_senitivity = UNKNOWN_OFFSET;
     bool rd_strong_update_unknown = false;
     uint32_t max_set_size = ~((uint32_t) 0);
+    const char *pta_cache = nullptr;
+    const char *library_summaries = nullptr;
+    bool stats = false;
+    bool rd_compact = false;
+    bool rd_rounds = false;
 
     enum {
         FLOW_SENSITIVE = 1,
@@ -262,6 +339,10 @@ int main(int argc, char *argv[])
                 type = FLOW_SENSITIVE;
         } else if (strcmp(argv[i], "-pta-field-sensitive") == 0) {
             field_senitivity = (uint64_t) atoll(argv[i + 1]);
+        } else if (strcmp(argv[i], "-pta-cache") == 0) {
+            pta_cache = argv[++i];
+        } else if (strcmp(argv[i], "-library-summaries") == 0) {
+            library_summaries = argv[++i];
         } else if (strcmp(argv[i], "-rd-max-set-size") == 0) {
             max_set_size = (uint64_t) atoll(argv[i + 1]);
             if (max_set_size == 0) {
@@ -270,8 +351,14 @@ int main(int argc, char *argv[])
             }
         } else if (strcmp(argv[i], "-rd-strong-update-unknown") == 0) {
             rd_strong_update_unknown = true;
+        } else if (strcmp(argv[i], "-rd-compact") == 0) {
+            rd_compact = true;
+        } else if (strcmp(argv[i], "-rd-rounds") == 0) {
+            rd_rounds = true;
         } else if (strcmp(argv[i], "-dot") == 0) {
             todot = true;
+        } else if (strcmp(argv[i], "-stats") == 0) {
+            stats = true;
         } else if (strcmp(argv[i], "-v") == 0) {
             verbose = true;
         } else {
@@ -280,7 +367,9 @@ int main(int argc, char *argv[])
     }
 
     if (!module) {
-        errs() << "Usage: % IR_module [-pts fs|fi] [-dot] [-v] [output_file]\n";
+        errs() << "Usage: % IR_module [-pts fs|fi] [-pta-cache FILE] "
+                  "[-library-summaries FILE|none] [-rd-compact] [-rd-rounds] [-dot] [-stats] [-v] "
+                  "[output_file]\n";
         return 1;
     }
 
@@ -301,6 +390,22 @@ int main(int argc, char *argv[])
     debug::TimeMeasure tm;
 
     LLVMPointerAnalysis PTA(M, field_senitivity);
+    if (pta_cache)
+        PTA.setCacheFile(pta_cache);
+
+    // the builtin summaries extended with the ones from the file
+    LibrarySummaries summaries(LibrarySummaries::getBuiltin());
+    if (library_summaries) {
+        std::string err;
+        if (strcmp(library_summaries, "none") == 0) {
+            PTA.setLibrarySummaries(nullptr);
+        } else if (summaries.load(library_summaries, &err)) {
+            PTA.setLibrarySummaries(&summaries);
+        } else {
+            llvm::errs() << "Failed loading library summaries: " << err << "\n";
+            return 1;
+        }
+    }
 
     tm.start();
 
@@ -314,12 +419,25 @@ int main(int argc, char *argv[])
     tm.report("INFO: Points-to analysis took");
 
     LLVMReachingDefinitions RD(M, &PTA, rd_strong_update_unknown, max_set_size);
+    RD.setCompactGraph(rd_compact);
+    RD.setRoundsScheduling(rd_rounds);
     tm.start();
     RD.run();
     tm.stop();
     tm.report("INFO: Reaching definitions analysis took");
 
-    dumpRD(&RD, todot);
+    if (verbose)
+        llvm::errs() << "INFO: Processed " << RD.getVisitsNum()
+                     << " nodes, merged " << RD.getMergesNum() << " maps\n";
+
+    if (rd_compact && verbose)
+        reportCompaction(M, &PTA, &RD, toMs(tm.duration()),
+                         rd_strong_update_unknown, max_set_size, rd_rounds);
+
+    if (stats)
+        dumpStats(&PTA, &RD);
+    else
+        dumpRD(&RD, todot);
 
     return 0;
 }
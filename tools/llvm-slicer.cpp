@@ -69,6 +69,9 @@
 
 #include "analysis/PointsTo/PointsToFlowInsensitive.h"
 #include "analysis/PointsTo/PointsToFlowSensitive.h"
+#include "analysis/PointsTo/PointsToFlowSensitiveSparse.h"
+#include "analysis/PointsTo/PointsToDemandDriven.h"
+#include "analysis/PointsTo/PointsToSteensgaard.h"
 #include "analysis/PointsTo/Pointer.h"
 
 using namespace dg;
@@ -94,7 +97,7 @@ enum {
 };
 
 enum PtaType {
-    old, fs, fi
+    old, fs, fi, sfs, dd, steens
 };
 
 llvm::cl::OptionCategory SlicingOpts("Slicer options", "");
@@ -121,6 +124,44 @@ llvm::cl::opt<uint64_t> pta_field_sensitivie("pta-field-sensitive",
                    llvm::cl::value_desc("N"), llvm::cl::init(UNKNOWN_OFFSET),
                    llvm::cl::cat(SlicingOpts));
 
+llvm::cl::opt<unsigned> pta_threads("pta-threads",
+    llvm::cl::desc("Solve the flow-insensitive PTA in N threads (default 1)\n"),
+                   llvm::cl::value_desc("N"), llvm::cl::init(1),
+                   llvm::cl::cat(SlicingOpts));
+
+llvm::cl::opt<uint64_t> pta_demand_budget("pta-demand-budget",
+    llvm::cl::desc("The maximal number of nodes processed for one query of the\n"
+                   "demand-driven PTA, then everything is computed (default 0 = no limit)\n"),
+                   llvm::cl::value_desc("N"), llvm::cl::init(0),
+                   llvm::cl::cat(SlicingOpts));
+
+llvm::cl::opt<LLVMPointerAnalysis::FuncptrResolution> pta_funcptr("pta-funcptr",
+    llvm::cl::desc("When to build the subgraphs for calls via function pointers:"),
+    llvm::cl::values(
+        clEnumValN(LLVMPointerAnalysis::FUNCPTR_LAZY, "lazy",
+                   "When the PTA finds the called function (default)"),
+        clEnumValN(LLVMPointerAnalysis::FUNCPTR_SIGNATURE, "signature",
+                   "Before the PTA, call all address-taken functions\n"
+                   "with compatible signature"),
+        clEnumValN(LLVMPointerAnalysis::FUNCPTR_FLOW_INSENSITIVE, "fi",
+                   "Before the PTA, call the functions found by\n"
+                   "the flow-insensitive PTA"),
+        nullptr),
+    llvm::cl::init(LLVMPointerAnalysis::FUNCPTR_LAZY),
+    llvm::cl::cat(SlicingOpts));
+
+llvm::cl::opt<std::string> pta_cache("pta-cache",
+    llvm::cl::desc("Load the points-to sets from the file if it has the results for\n"
+                   "this module, otherwise store the results there\n"),
+                   llvm::cl::value_desc("FILE"), llvm::cl::init(""),
+                   llvm::cl::cat(SlicingOpts));
+
+llvm::cl::opt<std::string> library_summaries("library-summaries",
+    llvm::cl::desc("Add the summaries of library functions from the file to the builtin\n"
+                   "ones, 'none' turns off the summaries (see LibrarySummaries.h)\n"),
+                   llvm::cl::value_desc("FILE"), llvm::cl::init(""),
+                   llvm::cl::cat(SlicingOpts));
+
 llvm::cl::opt<bool> rd_strong_update_unknown("rd-strong-update-unknown",
     llvm::cl::desc("Let reaching defintions analysis do strong updates on memory defined\n"
                    "with uknown offset in the case, that new definition overwrites\n"
@@ -133,6 +174,10 @@ llvm::cl::opt<PtaType> pta("pta",
         clEnumVal(old , "Old pointer analysis (flow-insensitive, deprecated)"),
         clEnumVal(fi, "Flow-insensitive PTA (default)"),
         clEnumVal(fs, "Flow-sensitive PTA"),
+        clEnumVal(sfs, "Sparse flow-sensitive PTA"),
+        clEnumVal(dd, "Demand-driven flow-insensitive PTA (computes only\n"
+                      "the points-to sets needed for the slice)"),
+        clEnumVal(steens, "Steensgaard's PTA (unification-based, fast and imprecise)"),
         nullptr),
     llvm::cl::init(fi), llvm::cl::cat(SlicingOpts));
 
@@ -183,6 +228,8 @@ class CommentDBG : public llvm::AssemblyAnnotationWriter
             os << " + ";
             if (ptr.offset.isUnknown())
                 os << "UNKNOWN";
+            else if (ptr.offset.isStrided())
+                os << ptr.offset.getBase() << " + k*" << ptr.offset.getStride();
             else
                 os << *ptr.offset;
         } else
@@ -251,11 +298,11 @@ class CommentDBG : public llvm::AssemblyAnnotationWriter
     {
         if (opts & ANNOTATE_RD) {
             if (RD) {
-                analysis::rd::RDNode *rd = RD->getMapping(node->getKey());
+                const analysis::rd::RDNode *rd = RD->getMapping(node->getKey());
                 if (!rd) {
                     os << "  ; RD: no mapping\n";
                 } else {
-                    auto defs = rd->getReachingDefinitions();
+                    const auto& defs = rd->getReachingDefinitions();
                     for (auto it : defs) {
                         for (auto nd : it.second) {
                             printDefSite(it.first, os, "RD: ");
@@ -497,6 +544,8 @@ class Slicer {
 protected:
     llvm::Module *M;
     uint32_t opts = 0;
+    // the builtin summaries extended with the ones from the file
+    analysis::LibrarySummaries summaries;
     std::unique_ptr<LLVMPointerAnalysis> PTA;
     std::unique_ptr<LLVMReachingDefinitions> RD;
     LLVMDependenceGraph dg;
@@ -534,7 +583,7 @@ protected:
 
 public:
     Slicer(llvm::Module *mod, uint32_t o)
-    :M(mod), opts(o),
+    :M(mod), opts(o), summaries(analysis::LibrarySummaries::getBuiltin()),
      PTA(new LLVMPointerAnalysis(mod, pta_field_sensitivie)),
       RD(new LLVMReachingDefinitions(mod, PTA.get(), rd_strong_update_unknown)) {
         assert(mod && "Need module");
@@ -669,10 +718,34 @@ public:
 
         tm.start();
 
+        PTA->setThreadsNum(pta_threads);
+        PTA->setDemandBudget(pta_demand_budget);
+        PTA->setFuncptrResolution(pta_funcptr);
+        if (!pta_cache.empty())
+            PTA->setCacheFile(pta_cache);
+        if (library_summaries == "none") {
+            PTA->setLibrarySummaries(nullptr);
+        } else if (!library_summaries.empty()) {
+            std::string err;
+            if (!summaries.load(library_summaries, &err)) {
+                llvm::errs() << "ERROR: Failed loading library summaries: "
+                             << err << "\n";
+                return false;
+            }
+
+            PTA->setLibrarySummaries(&summaries);
+        }
+
         if (pta == PtaType::fs)
             PTA->run<analysis::pta::PointsToFlowSensitive>();
         else if (pta == PtaType::fi)
             PTA->run<analysis::pta::PointsToFlowInsensitive>();
+        else if (pta == PtaType::sfs)
+            PTA->run<analysis::pta::PointsToFlowSensitiveSparse>();
+        else if (pta == PtaType::dd)
+            PTA->run<analysis::pta::PointsToDemandDriven>();
+        else if (pta == PtaType::steens)
+            PTA->run<analysis::pta::PointsToSteensgaard>();
         else
             assert(0 && "Wrong pointer analysis");
 
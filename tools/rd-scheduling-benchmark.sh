@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# Compare the reaching definitions analysis with the worklist scheduling
+# and with the old scheduling in rounds on the test sources (or on the
+# given files). Run from the build directory:
+# rd-scheduling-benchmark.sh [file.c ...]
+
+DIR=`dirname $0`
+RDDUMP=${RDDUMP:-./tools/llvm-rd-dump}
+CLANG=${CLANG:-clang}
+
+if [ $# -eq 0 ]; then
+	set -- $DIR/../tests/sources/*.c
+fi
+
+TMP=`mktemp -d`
+trap "rm -rf $TMP" EXIT
+
+run()
+{
+	# the time goes to stderr, the stats to stdout
+	$RDDUMP "$1" -stats $2 2>$TMP/time | grep "RD visits" \
+		| sed 's/^/    /'
+	grep "Reaching definitions analysis took" $TMP/time \
+		| sed 's/^INFO: /    /'
+}
+
+for F in "$@"; do
+	BC=$TMP/`basename "${F%.c}"`.bc
+	$CLANG -emit-llvm -c -g "$F" -o "$BC" || exit 1
+
+	echo "== $F"
+	echo "  worklist:"
+	run "$BC"
+	echo "  rounds:"
+	run "$BC" -rd-rounds
+done